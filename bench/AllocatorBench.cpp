@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "memory/Arena.hpp"
+#include "memory/BlockPool.hpp"
+#include "util/TextUtils.hpp"
+
+// Pool and arena against malloc for the patterns of the pipeline: blocks of
+// 256 float samples allocated and freed from several threads, and many small
+// short-lived allocations per record
+
+static constexpr std::size_t BLOCK_BYTES = 256 * sizeof(float);
+static constexpr int BATCH = 16;
+
+static jltx::memory::BlockPool& SharedPool() {
+  static jltx::memory::BlockPool pool(BLOCK_BYTES, 4096);
+  return pool;
+}
+
+static void BM_Malloc_Block(benchmark::State& state) {
+  void* blocks[BATCH];
+  for (auto _ : state) {
+    for (auto& block : blocks) {
+      block = std::malloc(BLOCK_BYTES);
+      benchmark::DoNotOptimize(block);
+    }
+    for (auto& block : blocks) {
+      std::free(block);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(BM_Malloc_Block)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_BlockPool_Block(benchmark::State& state) {
+  jltx::memory::BlockPool& pool = SharedPool();
+  void* blocks[BATCH];
+  for (auto _ : state) {
+    for (auto& block : blocks) {
+      block = pool.Allocate();
+      benchmark::DoNotOptimize(block);
+    }
+    for (auto& block : blocks) {
+      pool.Free(block);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(BM_BlockPool_Block)->ThreadRange(1, 8)->UseRealTime();
+
+// One thread alternating between two pools, e.g. two block sizes. Their ids
+// are 8 apart, which mapped them to the same cache slot.
+static void BM_BlockPool_TwoPools(benchmark::State& state) {
+  jltx::memory::BlockPool first(BLOCK_BYTES, 256);
+  std::vector<std::unique_ptr<jltx::memory::BlockPool>> between;
+  for (int i = 0; i < 7; ++i) {
+    between.push_back(std::make_unique<jltx::memory::BlockPool>(64, 1));
+  }
+  jltx::memory::BlockPool second(BLOCK_BYTES / 2, 256);
+  for (auto _ : state) {
+    void* block = first.Allocate();
+    benchmark::DoNotOptimize(block);
+    first.Free(block);
+    block = second.Allocate();
+    benchmark::DoNotOptimize(block);
+    second.Free(block);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_BlockPool_TwoPools);
+
+// A record's worth of small allocations of mixed sizes
+static constexpr std::size_t SIZES[] = {16, 40, 24, 96, 8, 200, 32, 64};
+
+static void BM_Malloc_Small(benchmark::State& state) {
+  std::vector<void*> pointers;
+  pointers.reserve(64);
+  for (auto _ : state) {
+    for (int i = 0; i < 64; ++i) {
+      pointers.push_back(std::malloc(SIZES[i % 8]));
+    }
+    benchmark::DoNotOptimize(pointers.data());
+    for (void* pointer : pointers) {
+      std::free(pointer);
+    }
+    pointers.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_Malloc_Small);
+
+static void BM_Arena_Small(benchmark::State& state) {
+  jltx::memory::MonotonicArena arena;
+  for (auto _ : state) {
+    for (int i = 0; i < 64; ++i) {
+      benchmark::DoNotOptimize(arena.Allocate(SIZES[i % 8]));
+    }
+    arena.Reset();
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_Arena_Small);
+
+// Splitting a CSV line whose fields are too long for the short string
+// optimization, with the global heap and with an arena reset per line
+static const std::string& Line() {
+  static const std::string line = [] {
+    std::string text;
+    for (int i = 0; i < 16; ++i) {
+      text += "2022-06-01T12:00:00.000000;sensor_" + std::to_string(i) + ";";
+    }
+    return text;
+  }();
+  return line;
+}
+
+static void BM_Split_Heap(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jltx::TextUtils::Split(Line(), ";"));
+  }
+  state.SetBytesProcessed(state.iterations() * Line().size());
+}
+BENCHMARK(BM_Split_Heap);
+
+static void BM_Split_Arena(benchmark::State& state) {
+  jltx::memory::MonotonicArena arena;
+  jltx::memory::ArenaResource resource(arena);
+  for (auto _ : state) {
+    {
+      auto tokens = jltx::TextUtils::Split(Line(), ";", &resource);
+      benchmark::DoNotOptimize(tokens.data());
+    }
+    arena.Reset();
+  }
+  state.SetBytesProcessed(state.iterations() * Line().size());
+}
+BENCHMARK(BM_Split_Arena);
@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "audio/FileAudioSink.hpp"
+#include "audio/NullAudioSink.hpp"
+
+// Throughput of the file sink write modes for a stereo 16-bit stream, with
+// the null sink as the cost of the interface alone
+
+static constexpr uint32_t FRAMES_PER_SEND = 1024;
+static constexpr uint32_t SENDS_PER_FILE = 4096;  // 16 MiB of samples
+
+static void BM_NullSink(benchmark::State& state) {
+  jltx::audio::NullAudioSink sink(48000, 2);
+  const std::vector<float> samples(2 * FRAMES_PER_SEND, 0.5f);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sink.Send(samples.data(), FRAMES_PER_SEND));
+  }
+  state.SetItemsProcessed(state.iterations() * FRAMES_PER_SEND);
+}
+BENCHMARK(BM_NullSink);
+
+static void BM_FileSink(benchmark::State& state) {
+  const std::string path = "jltx_audio_sink_bench.wav";
+  const std::vector<float> samples(2 * FRAMES_PER_SEND, 0.5f);
+  jltx::audio::FileSinkConfig config;
+  config.path = path.c_str();
+  config.channels = 2;
+  config.format = jltx::audio::SampleFormat::S16;
+  config.mode = static_cast<jltx::audio::FileWriteMode>(state.range(0));
+
+  for (auto _ : state) {
+    jltx::audio::FileAudioSink sink(config);
+    if (!sink.IsOpen()) {
+      state.SkipWithError("Cannot open the file");
+      break;
+    }
+    for (uint32_t i = 0; i < SENDS_PER_FILE; ++i) {
+      sink.Send(samples.data(), FRAMES_PER_SEND);
+    }
+    sink.Close();
+  }
+  std::remove(path.c_str());
+  state.SetItemsProcessed(state.iterations() * SENDS_PER_FILE *
+                          FRAMES_PER_SEND);
+  state.SetBytesProcessed(state.iterations() * SENDS_PER_FILE *
+                          FRAMES_PER_SEND * 4);
+}
+// BUFFERED, DIRECT, MMAP
+BENCHMARK(BM_FileSink)
+    ->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "optimization/autodiff.hpp"
+#include "optimization/gradient.hpp"
+
+static constexpr uint32_t NPARAMS = 6;
+static constexpr std::size_t NUM_SAMPLES = 1 << 16;
+
+template <uint32_t nparams>
+struct AutoDiffPolynomial
+    : public jltx::opt::AutoDiffProblem<float, nparams,
+                                        AutoDiffPolynomial<nparams>> {
+  template <typename S>
+  S Evaluate(float x, const std::array<S, nparams>& w) const {
+    S estimate = w[nparams - 1];
+    for (uint32_t i = nparams - 1; i-- > 0;) {
+      estimate = estimate * x + w[i];
+    }
+    return estimate;
+  }
+};
+
+static void MakeSamples(std::vector<float>& x, std::vector<float>& y) {
+  x.resize(NUM_SAMPLES);
+  y.resize(NUM_SAMPLES);
+  for (std::size_t n = 0; n < NUM_SAMPLES; ++n) {
+    x[n] = -1.0f + 2.0f * static_cast<float>(n) / NUM_SAMPLES;
+    y[n] = 1.0f - 2.0f * x[n] + 0.5f * x[n] * x[n];
+  }
+}
+
+static void BM_Gradient_HandCoded(benchmark::State& state) {
+  std::vector<float> x, y;
+  MakeSamples(x, y);
+  jltx::opt::PolynomicFitProblem<float, NPARAMS> problem;
+  const auto w = jltx::opt::RandomInitParams<float, NPARAMS>(1);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(problem.Gradient(x, w, y));
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_SAMPLES);
+}
+BENCHMARK(BM_Gradient_HandCoded);
+
+static void BM_Gradient_AutoDiff(benchmark::State& state) {
+  std::vector<float> x, y;
+  MakeSamples(x, y);
+  AutoDiffPolynomial<NPARAMS> problem;
+  const auto w = jltx::opt::RandomInitParams<float, NPARAMS>(1);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(problem.Gradient(x, w, y));
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_SAMPLES);
+}
+BENCHMARK(BM_Gradient_AutoDiff);
+
+// Central differences: two extra passes over the data per parameter
+static void BM_Gradient_FiniteDifference(benchmark::State& state) {
+  std::vector<float> x, y;
+  MakeSamples(x, y);
+  jltx::opt::PolynomicFitProblem<float, NPARAMS> problem;
+  const auto w = jltx::opt::RandomInitParams<float, NPARAMS>(1);
+  static constexpr float h = 1e-3f;
+
+  for (auto _ : state) {
+    std::array<float, NPARAMS> gradient;
+    for (uint32_t i = 0; i < NPARAMS; ++i) {
+      auto w_plus = w;
+      auto w_minus = w;
+      w_plus[i] += h;
+      w_minus[i] -= h;
+      gradient[i] =
+          (problem.Error(x, w_plus, y) - problem.Error(x, w_minus, y)) /
+          (2 * h);
+    }
+    benchmark::DoNotOptimize(gradient);
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_SAMPLES);
+}
+BENCHMARK(BM_Gradient_FiniteDifference);
@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "util/CsvReader.hpp"
+#include "util/TextUtils.hpp"
+#include "util/ThreadPool.hpp"
+
+// Size of the synthetic file in MiB. Set JLTX_BENCH_CSV_MB to run on
+// multi-GB files, e.g. JLTX_BENCH_CSV_MB=4096.
+static std::size_t FileSize() {
+  const char* env = std::getenv("JLTX_BENCH_CSV_MB");
+  const std::size_t mb = env != nullptr ? std::strtoull(env, nullptr, 10) : 0;
+  return (mb > 0 ? mb : 256) << 20;
+}
+
+// Telemetry-like rows: timestamp, channel name, three readings and a quoted
+// comment containing delimiters. Written once per process.
+static const std::string& CsvPath() {
+  static const std::string path = [] {
+    const std::string path = "/tmp/jltx_csv_bench.csv";
+    const std::size_t size = FileSize();
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> reading(-1000.0, 1000.0);
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+      return std::string();
+    }
+    char line[256];
+    std::size_t written = 0;
+    for (std::size_t i = 0; written < size; ++i) {
+      const int length = std::snprintf(
+          line, sizeof(line), "%zu,channel_%zu,%.6f,%.6f,%.6f,\"a, b\"\n",
+          1600000000000 + i, i % 64, reading(generator), reading(generator),
+          reading(generator));
+      std::fwrite(line, 1, static_cast<std::size_t>(length), file);
+      written += static_cast<std::size_t>(length);
+    }
+    std::fclose(file);
+    std::atexit([] { std::remove("/tmp/jltx_csv_bench.csv"); });
+    return path;
+  }();
+  return path;
+}
+
+// Reading line by line into std::string and splitting, as done before the
+// CsvReader
+static void BM_Csv_GetlineSplit(benchmark::State& state) {
+  const std::string& path = CsvPath();
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    std::ifstream file(path);
+    std::string line;
+    std::size_t fields = 0;
+    bytes = 0;
+    while (std::getline(file, line)) {
+      fields += jltx::TextUtils::Split(line, ",").size();
+      bytes += line.size() + 1;
+    }
+    benchmark::DoNotOptimize(fields);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_Csv_GetlineSplit)->Unit(benchmark::kMillisecond);
+
+static void BM_CsvReader(benchmark::State& state) {
+  const std::size_t threads = static_cast<std::size_t>(state.range(0));
+  jltx::ThreadPool pool(threads);
+  jltx::TextUtils::MappedFile file(CsvPath());
+  if (!file.IsOpen()) {
+    state.SkipWithError("Could not map the CSV file");
+    return;
+  }
+
+  for (auto _ : state) {
+    std::size_t fields = 0;
+    jltx::TextUtils::CsvReader(file.Data())
+        .ForEachRow(
+            [&](const jltx::TextUtils::CsvRow& row) {
+              fields += row.fields.size();
+            },
+            threads > 1 ? &pool : nullptr);
+    benchmark::DoNotOptimize(fields);
+  }
+  state.SetBytesProcessed(
+      static_cast<int64_t>(state.iterations() * file.Data().size()));
+}
+BENCHMARK(BM_CsvReader)
+    ->RangeMultiplier(2)
+    ->Range(1, std::max(1u, std::thread::hardware_concurrency()))
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
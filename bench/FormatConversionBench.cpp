@@ -0,0 +1,106 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "audio/FormatConversion.hpp"
+
+// Float to S16 conversion of one stereo period, compared with a plain loop
+// using lrintf()
+
+static constexpr std::size_t FRAMES = 1024;
+
+static std::vector<float> Signal(std::size_t size) {
+  std::vector<float> in(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    in[i] = std::sin(static_cast<float>(i) * 0.01f);
+  }
+  return in;
+}
+
+static void BM_FloatToS16_Naive(benchmark::State& state) {
+  const std::vector<float> in = Signal(2 * FRAMES);
+  std::vector<int16_t> out(in.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      const float v = std::clamp(in[i] * 32768.0f, -32768.0f, 32767.0f);
+      out[i] = static_cast<int16_t>(std::lrint(v));
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(in.size()));
+}
+BENCHMARK(BM_FloatToS16_Naive);
+
+static void BM_FloatToS16(benchmark::State& state) {
+  const std::vector<float> in = Signal(2 * FRAMES);
+  std::vector<int16_t> out(in.size());
+  for (auto _ : state) {
+    jltx::audio::ConvertFromFloat(in, jltx::audio::SampleFormat::S16,
+                                  out.data());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(in.size()));
+}
+BENCHMARK(BM_FloatToS16);
+
+static void BM_FloatToS32(benchmark::State& state) {
+  const std::vector<float> in = Signal(2 * FRAMES);
+  std::vector<int32_t> out(in.size());
+  for (auto _ : state) {
+    jltx::audio::ConvertFromFloat(in, jltx::audio::SampleFormat::S32,
+                                  out.data());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(in.size()));
+}
+BENCHMARK(BM_FloatToS32);
+
+static void BM_PlanarToS16(benchmark::State& state) {
+  const std::vector<float> left = Signal(FRAMES);
+  const std::vector<float> right = Signal(FRAMES);
+  const float* planes[] = {left.data(), right.data()};
+  std::vector<int16_t> out(2 * FRAMES);
+  for (auto _ : state) {
+    jltx::audio::InterleaveFromFloat(planes, FRAMES,
+                                     jltx::audio::SampleFormat::S16,
+                                     out.data());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(out.size()));
+}
+BENCHMARK(BM_PlanarToS16);
@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "optimization/gradient.hpp"
+#include "util/ThreadPool.hpp"
+
+static constexpr uint32_t NPARAMS = 4;
+static constexpr std::size_t NUM_SAMPLES = 1 << 22;
+static constexpr uint32_t ITERATIONS = 10;
+
+static void MakeSamples(std::vector<float>& x, std::vector<float>& y) {
+  x.resize(NUM_SAMPLES);
+  y.resize(NUM_SAMPLES);
+  for (std::size_t n = 0; n < NUM_SAMPLES; ++n) {
+    x[n] = -1.0f + 2.0f * static_cast<float>(n) / NUM_SAMPLES;
+    y[n] = 1.0f - 2.0f * x[n] + 0.5f * x[n] * x[n];
+  }
+}
+
+// Full-batch gradient descent sharded over 1..N threads
+static void BM_GradientSolverScaling(benchmark::State& state) {
+  std::vector<float> x, y;
+  MakeSamples(x, y);
+
+  jltx::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  jltx::opt::PolynomicFitProblem<float, NPARAMS> problem;
+  jltx::opt::GradientSolver<float, NPARAMS> solver(&problem, 0.1f, &pool);
+  const std::array<float, NPARAMS> init{};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(solver.Solve(ITERATIONS, x, y, init));
+  }
+  state.SetItemsProcessed(state.iterations() * ITERATIONS * NUM_SAMPLES);
+}
+BENCHMARK(BM_GradientSolverScaling)
+    ->Apply([](benchmark::internal::Benchmark* b) {
+      const unsigned int max_threads =
+          std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        b->Arg(threads);
+      }
+      if ((max_threads & (max_threads - 1)) != 0) {
+        b->Arg(max_threads);
+      }
+    })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
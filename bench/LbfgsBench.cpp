@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "optimization/gradient.hpp"
+#include "optimization/lbfgs.hpp"
+
+static constexpr uint32_t NPARAMS = 4;
+static constexpr std::size_t NUM_SAMPLES = 1 << 16;
+static constexpr double TARGET_LOSS = 1e-8;
+static constexpr uint32_t MAX_PASSES = 100000;
+
+static void MakeSamples(std::vector<double>& x, std::vector<double>& y) {
+  x.resize(NUM_SAMPLES);
+  y.resize(NUM_SAMPLES);
+  for (std::size_t n = 0; n < NUM_SAMPLES; ++n) {
+    x[n] = -1.0 + 2.0 * static_cast<double>(n) / NUM_SAMPLES;
+    y[n] = 1.0 - 2.0 * x[n] + 0.5 * x[n] * x[n] - 0.25 * x[n] * x[n] * x[n];
+  }
+}
+
+// One loss and one gradient pass per iteration
+static void BM_PolynomicFit_GradientSolver(benchmark::State& state) {
+  std::vector<double> x, y;
+  MakeSamples(x, y);
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  jltx::opt::GradientSolver<double, NPARAMS> solver(&problem, 0.5);
+
+  uint32_t evaluations = 0;
+  for (auto _ : state) {
+    auto w = jltx::opt::RandomInitParams<double, NPARAMS>(1);
+    evaluations = 0;
+    while ((problem.Error(x, w, y) > TARGET_LOSS) &&
+           (evaluations < MAX_PASSES)) {
+      w = solver.Solve(1, x, y, w);
+      ++evaluations;
+    }
+    benchmark::DoNotOptimize(w);
+  }
+  state.counters["evaluations"] = evaluations;
+}
+BENCHMARK(BM_PolynomicFit_GradientSolver)->Unit(benchmark::kMillisecond);
+
+static void BM_PolynomicFit_Lbfgs(benchmark::State& state) {
+  std::vector<double> x, y;
+  MakeSamples(x, y);
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+
+  jltx::opt::ConvergenceCriteria<double> criteria;
+  criteria.gradient_tolerance = 0;
+  jltx::opt::LineSearchOptions<double> line_search;
+  line_search.method = static_cast<jltx::opt::LineSearchMethod>(state.range(0));
+  jltx::opt::LbfgsSolver<double, NPARAMS> solver(&problem, criteria,
+                                                 line_search);
+  solver.SetCallback([](const jltx::opt::IterationReport<double>& report) {
+    return report.loss > TARGET_LOSS;
+  });
+
+  uint32_t evaluations = 0;
+  for (auto _ : state) {
+    const auto result =
+        solver.Solve(x, y, jltx::opt::RandomInitParams<double, NPARAMS>(1));
+    evaluations = result.evaluations;
+    benchmark::DoNotOptimize(result);
+  }
+  state.counters["evaluations"] = evaluations;
+}
+BENCHMARK(BM_PolynomicFit_Lbfgs)
+    ->ArgName("line_search")
+    ->Arg(static_cast<int>(jltx::opt::LineSearchMethod::ARMIJO))
+    ->Arg(static_cast<int>(jltx::opt::LineSearchMethod::WOLFE))
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,66 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "optimization/levenberg_marquardt.hpp"
+
+static constexpr double SAMPLE_RATE = 48000;
+static constexpr std::array<double, 3> TONE = {0.8, 1000.0, 0.3};
+
+// Noisy tone, fitted from an initial guess half a frequency bin away
+static void BM_LevenbergMarquardtSinusoid(benchmark::State& state) {
+  const std::size_t num_samples = static_cast<std::size_t>(state.range(0));
+
+  jltx::opt::SinusoidFitProblem<double> problem;
+  std::mt19937 generator(1);
+  std::normal_distribution<double> noise(0.0, 0.1);
+  std::vector<double> x(num_samples), y(num_samples);
+  for (std::size_t n = 0; n < num_samples; ++n) {
+    x[n] = static_cast<double>(n) / SAMPLE_RATE;
+    y[n] = problem.Evaluate(x[n], TONE) + noise(generator);
+  }
+
+  const double duration = static_cast<double>(num_samples) / SAMPLE_RATE;
+  const std::array<double, 3> init = {1.0, TONE[1] + 0.25 / duration, 0.0};
+
+  jltx::opt::LevenbergMarquardtSolver<double, 3> solver(&problem);
+  uint32_t iterations = 0;
+  for (auto _ : state) {
+    const auto result = solver.Solve(x, y, init);
+    iterations = result.iterations;
+    benchmark::DoNotOptimize(result);
+  }
+  state.counters["iterations"] = iterations;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LevenbergMarquardtSinusoid)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
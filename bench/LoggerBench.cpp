@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+
+#include <cstdio>
+#include <memory>
+
+#include "debug.hpp"
+#include "util/AsyncLog.hpp"
+#include "util/BinaryLog.hpp"
+
+// Time of one log call on the calling thread, with several threads logging
+// at the same time. Output goes to /dev/null so only the logging cost counts.
+
+static void BM_Logger_Sync(benchmark::State& state) {
+  static FILE* const file = std::fopen("/dev/null", "w");
+  const jltx::debug::Logger log(file);
+  int i = 0;
+  for (auto _ : state) {
+    log.i("BENCH", "iteration %d value %f", i++, 0.5);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Logger_Sync)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Logger_Async(benchmark::State& state) {
+  static jltx::debug::AsyncLogBackend backend(open("/dev/null", O_WRONLY));
+  const jltx::debug::BasicLogger log(backend);
+  int i = 0;
+  for (auto _ : state) {
+    log.i("BENCH", "iteration %d value %f", i++, 0.5);
+  }
+  if (state.thread_index() == 0) {
+    state.counters["dropped"] = static_cast<double>(backend.Dropped());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Logger_Async)->ThreadRange(1, 8)->UseRealTime();
+
+// A fresh log for every run, large enough not to drop records
+static std::unique_ptr<jltx::debug::BinaryLogWriter> binary_writer;
+static constexpr const char* BINARY_LOG_PATH = "/tmp/jltx_logger_bench.blog";
+
+static void BM_Logger_Binary(benchmark::State& state) {
+  const jltx::debug::BasicLogger log(*binary_writer);
+  int i = 0;
+  for (auto _ : state) {
+    log.i("BENCH", "iteration %d value %f", i++, 0.5);
+  }
+  if (state.thread_index() == 0) {
+    state.counters["dropped"] = static_cast<double>(binary_writer->Dropped());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Logger_Binary)
+    ->ThreadRange(1, 8)
+    ->UseRealTime()
+    ->Setup([](const benchmark::State&) {
+      binary_writer = std::make_unique<jltx::debug::BinaryLogWriter>(
+          BINARY_LOG_PATH, std::size_t{4} << 30);
+    })
+    ->Teardown([](const benchmark::State&) {
+      binary_writer.reset();
+      std::remove(BINARY_LOG_PATH);
+    });
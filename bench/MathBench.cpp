@@ -0,0 +1,65 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "math/math.hpp"
+
+// Series approximations against libm over several turns of the circle
+
+static constexpr std::size_t NUM_ANGLES = 4096;
+
+static std::vector<float> Angles() {
+  std::vector<float> angles(NUM_ANGLES);
+  for (std::size_t i = 0; i < NUM_ANGLES; ++i) {
+    angles[i] = -20.0f + 40.0f * static_cast<float>(i) / NUM_ANGLES;
+  }
+  return angles;
+}
+
+template <float (*function)(float)>
+static void BM_Trig(benchmark::State& state) {
+  const std::vector<float> angles = Angles();
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const float angle : angles) {
+      sum += function(angle);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_ANGLES);
+}
+
+static float Sin11(float x) { return jltx::math::sin11(x); }
+static float Cos11(float x) { return jltx::math::cos11(x); }
+static float Sinf(float x) { return std::sin(x); }
+static float Cosf(float x) { return std::cos(x); }
+
+BENCHMARK(BM_Trig<Sin11>)->Name("BM_sin11");
+BENCHMARK(BM_Trig<Sinf>)->Name("BM_sinf");
+BENCHMARK(BM_Trig<Cos11>)->Name("BM_cos11");
+BENCHMARK(BM_Trig<Cosf>)->Name("BM_cosf");
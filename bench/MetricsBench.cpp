@@ -0,0 +1,63 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+#include "util/Metrics.hpp"
+
+// Cost of updating metrics from several threads at once, compared with a
+// counter behind a mutex
+
+static void BM_Counter_Mutex(benchmark::State& state) {
+  static std::mutex mutex;
+  static uint64_t counter = 0;
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counter;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Counter_Mutex)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Counter(benchmark::State& state) {
+  static jltx::metrics::Counter counter;
+  for (auto _ : state) {
+    counter.Add();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Counter)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Histogram(benchmark::State& state) {
+  static jltx::metrics::Histogram histogram;
+  uint64_t value = 1;
+  for (auto _ : state) {
+    histogram.Record(value);
+    value = (value * 7 + 13) & 0xFFFFF;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Histogram)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+
+// One block of samples from the NCO at the LUT sizes in use. Bigger tables
+// cost cache space, not instructions.
+
+static constexpr std::size_t BLOCK_SIZE = 256;
+
+template <uint8_t bit_depth>
+static void BM_NCO(benchmark::State& state) {
+  const jltx::dsp::SineLUT<bit_depth> table;
+  jltx::dsp::NCO<bit_depth> nco(997.0f, 48000.0f, table);
+  std::vector<float> block(BLOCK_SIZE);
+  for (auto _ : state) {
+    for (auto& sample : block) {
+      sample = nco();
+    }
+    benchmark::DoNotOptimize(block.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_SIZE);
+}
+BENCHMARK(BM_NCO<8>);
+BENCHMARK(BM_NCO<10>);
+BENCHMARK(BM_NCO<12>);
+BENCHMARK(BM_NCO<16>);
+
+// The same block through NCO::Render(), which computes every phase from the
+// sample index and gathers 8 samples at a time
+template <uint8_t bit_depth>
+static void BM_NCO_Render(benchmark::State& state) {
+  const jltx::dsp::SineLUT<bit_depth> table;
+  jltx::dsp::NCO<bit_depth> nco(997.0f, 48000.0f, table);
+  std::vector<float> block(BLOCK_SIZE);
+  for (auto _ : state) {
+    nco.Render(block);
+    benchmark::DoNotOptimize(block.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCK_SIZE);
+}
+BENCHMARK(BM_NCO_Render<8>);
+BENCHMARK(BM_NCO_Render<10>);
+BENCHMARK(BM_NCO_Render<12>);
+BENCHMARK(BM_NCO_Render<16>);
+
+// Jumping to a sample, as the parallel renderer does for every chunk
+static void BM_NCO_Seek(benchmark::State& state) {
+  const jltx::dsp::SineLUT<10> table;
+  jltx::dsp::NCO<10> nco(997.0f, 48000.0f, table);
+  uint64_t sample = 0;
+  for (auto _ : state) {
+    nco.Seek(sample);
+    benchmark::DoNotOptimize(nco());
+    sample += 65536;
+  }
+}
+BENCHMARK(BM_NCO_Seek);
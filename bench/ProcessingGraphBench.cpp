@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+#include "dsp/Nodes.hpp"
+#include "dsp/ProcessingGraph.hpp"
+#include "util/ThreadPool.hpp"
+
+// Cost of the graph per node and block: a chain of gain nodes against the
+// same chain as a plain loop, then wide graphs that can run in parallel
+
+using jltx::dsp::GainNode;
+using jltx::dsp::MixerNode;
+using jltx::dsp::NcoNode;
+using jltx::dsp::ProcessingGraph;
+
+static constexpr uint32_t BLOCK_FRAMES = 256;
+static constexpr uint8_t BIT_DEPTH = 12;
+
+static const jltx::dsp::SineLUT<BIT_DEPTH>& Table() {
+  static const jltx::dsp::SineLUT<BIT_DEPTH> table;
+  return table;
+}
+
+static void BM_GraphChain(benchmark::State& state) {
+  const auto length = static_cast<int>(state.range(0));
+  ProcessingGraph graph(BLOCK_FRAMES);
+  auto node = graph.Add(
+      std::make_unique<NcoNode<BIT_DEPTH>>(440.0f, 48000.0f, Table()));
+  for (int i = 0; i < length; ++i) {
+    node = graph.Add(std::make_unique<GainNode>(0.999f), {node});
+  }
+  graph.Compile(node);
+  for (auto _ : state) {
+    graph.Process();
+    benchmark::DoNotOptimize(graph.Output().data);
+  }
+  state.counters["ns_per_node"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * (length + 1),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_GraphChain)->Arg(1)->Arg(16)->Arg(256);
+
+static void BM_ManualChain(benchmark::State& state) {
+  const auto length = static_cast<int>(state.range(0));
+  jltx::dsp::NCO<BIT_DEPTH> nco(440.0f, 48000.0f, Table());
+  std::vector<float> a(BLOCK_FRAMES);
+  std::vector<float> b(BLOCK_FRAMES);
+  for (auto _ : state) {
+    for (auto& sample : a) {
+      sample = nco();
+    }
+    for (int i = 0; i < length; ++i) {
+      for (uint32_t k = 0; k < BLOCK_FRAMES; ++k) {
+        b[k] = 0.999f * a[k];
+      }
+      a.swap(b);
+    }
+    benchmark::DoNotOptimize(a.data());
+  }
+  state.counters["ns_per_node"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * (length + 1),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_ManualChain)->Arg(1)->Arg(16)->Arg(256);
+
+// range(0) voices of an oscillator and 8 gains, mixed to stereo, on range(1)
+// threads
+static void BM_GraphWide(benchmark::State& state) {
+  ProcessingGraph graph(BLOCK_FRAMES);
+  std::vector<ProcessingGraph::NodeId> voices;
+  for (int v = 0; v < state.range(0); ++v) {
+    auto node = graph.Add(std::make_unique<NcoNode<BIT_DEPTH>>(
+        110.0f * static_cast<float>(v + 1), 48000.0f, Table()));
+    for (int i = 0; i < 8; ++i) {
+      node = graph.Add(std::make_unique<GainNode>(0.99f), {node});
+    }
+    voices.push_back(node);
+  }
+  graph.Compile(graph.Add(std::make_unique<MixerNode>(2), voices));
+
+  jltx::ThreadPool pool(static_cast<std::size_t>(state.range(1)));
+  for (auto _ : state) {
+    graph.Process(&pool);
+    benchmark::DoNotOptimize(graph.Output().data);
+  }
+  state.counters["buffers"] = static_cast<double>(graph.BufferCount());
+  state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES);
+}
+BENCHMARK(BM_GraphWide)
+    ->ArgsProduct({{16, 64}, {1, 2, 4}})
+    ->UseRealTime();
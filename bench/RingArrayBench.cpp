@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "containers/RingArray.hpp"
+
+static constexpr std::size_t RING_SIZE = 1024;
+
+// Push into a full ring, which also advances the head
+static void BM_RingArray_Push(benchmark::State& state) {
+  jltx::RingArray<float, RING_SIZE> ring;
+  float value = 0.0f;
+  for (auto _ : state) {
+    ring.Push(value);
+    value += 1.0f;
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RingArray_Push);
+
+static void BM_RingArray_PushPop(benchmark::State& state) {
+  jltx::RingArray<float, RING_SIZE> ring;
+  for (std::size_t i = 0; i < RING_SIZE / 2; ++i) {
+    ring.Push(static_cast<float>(i));
+  }
+  for (auto _ : state) {
+    ring.Push(1.0f);
+    benchmark::DoNotOptimize(ring.Pop());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RingArray_PushPop);
+
+// Sum a full ring whose contents wrap around the end of the array
+static void BM_RingArray_Iterate(benchmark::State& state) {
+  jltx::RingArray<float, RING_SIZE> ring;
+  for (std::size_t i = 0; i < RING_SIZE + RING_SIZE / 3; ++i) {
+    ring.Push(static_cast<float>(i));
+  }
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const float value : ring) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * RING_SIZE);
+}
+BENCHMARK(BM_RingArray_Iterate);
+
+static void BM_RingArray_Index(benchmark::State& state) {
+  jltx::RingArray<float, RING_SIZE> ring;
+  for (std::size_t i = 0; i < RING_SIZE + RING_SIZE / 3; ++i) {
+    ring.Push(static_cast<float>(i));
+  }
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < ring.FillLevel(); ++i) {
+      sum += ring[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * RING_SIZE);
+}
+BENCHMARK(BM_RingArray_Index);
@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "optimization/gradient.hpp"
+#include "optimization/sgd.hpp"
+
+static constexpr uint32_t NPARAMS = 3;
+static constexpr std::size_t NUM_SAMPLES = 1 << 20;
+static constexpr std::size_t NUM_EVAL_SAMPLES = 1 << 12;
+static constexpr float TARGET_LOSS = 1e-4f;
+static constexpr uint64_t MAX_PASSES = 1000;
+
+struct Data {
+  std::vector<float> x, y;
+  std::vector<float> x_eval, y_eval;
+
+  Data() {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    auto fill = [&](std::vector<float>& xs, std::vector<float>& ys,
+                    std::size_t count) {
+      for (std::size_t n = 0; n < count; ++n) {
+        const float x = distribution(generator);
+        xs.push_back(x);
+        ys.push_back(1.0f - 2.0f * x + 0.5f * x * x);
+      }
+    };
+    fill(x, y, NUM_SAMPLES);
+    fill(x_eval, y_eval, NUM_EVAL_SAMPLES);
+  }
+};
+
+static const Data& GetData() {
+  static const Data data;
+  return data;
+}
+
+// Full-batch fixed-step descent, one pass over the data per iteration
+static void BM_TimeToTarget_GradientSolver(benchmark::State& state) {
+  const Data& data = GetData();
+  jltx::opt::PolynomicFitProblem<float, NPARAMS> problem;
+  jltx::opt::GradientSolver<float, NPARAMS> solver(&problem, 0.5f);
+
+  uint64_t passes = 0;
+  for (auto _ : state) {
+    auto w = jltx::opt::RandomInitParams<float, NPARAMS>(1);
+    passes = 0;
+    while ((problem.Error(data.x_eval, w, data.y_eval) > TARGET_LOSS) &&
+           (passes < MAX_PASSES)) {
+      w = solver.Solve(1, data.x, data.y, w);
+      ++passes;
+    }
+    benchmark::DoNotOptimize(w);
+  }
+  state.counters["passes"] = static_cast<double>(passes);
+}
+BENCHMARK(BM_TimeToTarget_GradientSolver)->Unit(benchmark::kMillisecond);
+
+// Streaming mini-batch solvers, loss checked every 1/16 of a pass
+static void BM_TimeToTarget_Sgd(benchmark::State& state) {
+  const Data& data = GetData();
+  jltx::opt::PolynomicFitProblem<float, NPARAMS> problem;
+
+  jltx::opt::SgdOptions<float> options;
+  options.method = static_cast<jltx::opt::SgdMethod>(state.range(0));
+  options.batch_size = 256;
+  options.learning_rate = jltx::opt::ConstantRate(
+      (options.method == jltx::opt::SgdMethod::SGD)   ? 0.5f
+      : (options.method == jltx::opt::SgdMethod::ADAM) ? 0.01f
+                                                       : 0.05f);
+
+  static constexpr std::size_t CHECK_INTERVAL = NUM_SAMPLES / 16;
+  double passes = 0;
+  for (auto _ : state) {
+    jltx::opt::StochasticGradientSolver<float, NPARAMS> solver(&problem,
+                                                              options);
+    auto w = jltx::opt::RandomInitParams<float, NPARAMS>(1);
+    std::size_t offset = 0;
+    uint64_t checks = 0;
+    while ((problem.Error(data.x_eval, w, data.y_eval) > TARGET_LOSS) &&
+           (checks < MAX_PASSES * 16)) {
+      for (std::size_t n = 0; n < CHECK_INTERVAL; n += options.batch_size) {
+        solver.Step(
+            std::span<const float>(data.x.data() + offset, options.batch_size),
+            std::span<const float>(data.y.data() + offset, options.batch_size),
+            w);
+        offset = (offset + options.batch_size) % NUM_SAMPLES;
+      }
+      ++checks;
+    }
+    passes = static_cast<double>(checks) / 16;
+    benchmark::DoNotOptimize(w);
+  }
+  state.counters["passes"] = passes;
+}
+BENCHMARK(BM_TimeToTarget_Sgd)
+    ->ArgName("method")
+    ->DenseRange(static_cast<int>(jltx::opt::SgdMethod::SGD),
+                 static_cast<int>(jltx::opt::SgdMethod::ADAM))
+    ->Unit(benchmark::kMillisecond);
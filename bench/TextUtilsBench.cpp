@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/ColumnParser.hpp"
+#include "util/TextUtils.hpp"
+
+static constexpr std::size_t TEXT_SIZE = 16 << 20;
+static const char* const DELIMITERS[] = {";", "::", "<sep>"};
+
+// Split and trim as implemented before the string_view and SIMD versions,
+// kept as the baseline
+static std::vector<std::string> LegacySplit(const std::string& str,
+                                            const std::string& delimiter) {
+  std::vector<std::string> str_vec;
+  const std::size_t str_size = str.size();
+  const std::size_t sep_size = delimiter.size();
+
+  if (str_size > 0 && sep_size > 0) {
+    std::size_t pos = 0;
+    std::size_t found;
+    while (pos < str_size) {
+      found = str.find(delimiter, pos);
+      if (found == std::string::npos) {
+        str_vec.push_back(str.substr(pos));
+        break;
+      } else {
+        str_vec.push_back(str.substr(pos, found - pos));
+        pos = found + sep_size;
+      }
+    }
+
+    if (str.substr(str_size - sep_size) == delimiter) {
+      str_vec.push_back("");
+    }
+  }
+
+  return str_vec;
+}
+
+static void LegacyTrim(std::string& str) {
+  str.erase(str.begin(),
+            std::find_if(str.begin(), str.end(),
+                         [](unsigned char ch) { return !std::isspace(ch); }));
+  str.erase(std::find_if(str.rbegin(), str.rend(),
+                         [](unsigned char ch) { return !std::isspace(ch); })
+                .base(),
+            str.end());
+}
+
+// Words of 3 to 12 letters joined by the delimiter
+static std::string MakeText(const std::string& delimiter) {
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> length(3, 12);
+  std::uniform_int_distribution<int> letter('a', 'z');
+
+  std::string text;
+  text.reserve(TEXT_SIZE + 64);
+  while (text.size() < TEXT_SIZE) {
+    for (int i = length(generator); i > 0; --i) {
+      text.push_back(static_cast<char>(letter(generator)));
+    }
+    text += delimiter;
+  }
+  return text;
+}
+
+static void BM_Split_Legacy(benchmark::State& state) {
+  const std::string delimiter = DELIMITERS[state.range(0)];
+  const std::string text = MakeText(delimiter);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacySplit(text, delimiter));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Split_Legacy)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+static void BM_Split(benchmark::State& state) {
+  const std::string delimiter = DELIMITERS[state.range(0)];
+  const std::string text = MakeText(delimiter);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jltx::TextUtils::Split(text, delimiter));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Split)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+static void BM_SplitView(benchmark::State& state) {
+  const std::string delimiter = DELIMITERS[state.range(0)];
+  const std::string text = MakeText(delimiter);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(jltx::TextUtils::SplitView(text, delimiter));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_SplitView)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+static void BM_SplitRange(benchmark::State& state) {
+  const std::string delimiter = DELIMITERS[state.range(0)];
+  const std::string text = MakeText(delimiter);
+  for (auto _ : state) {
+    std::size_t bytes = 0;
+    for (std::string_view token : jltx::TextUtils::SplitRange(text, delimiter)) {
+      bytes += token.size();
+    }
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_SplitRange)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// Lines with long runs of leading and trailing whitespace
+static std::vector<std::string> MakePaddedLines(std::size_t& bytes) {
+  std::vector<std::string> lines;
+  bytes = 0;
+  for (std::size_t i = 0; i < 4096; ++i) {
+    lines.push_back(std::string(64, ' ') + "\tsome value " +
+                    std::to_string(i) + std::string(64, ' ') + "\n");
+    bytes += lines.back().size();
+  }
+  return lines;
+}
+
+static void BM_Trim_Legacy(benchmark::State& state) {
+  std::size_t bytes;
+  const std::vector<std::string> lines = MakePaddedLines(bytes);
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      std::string str = line;
+      LegacyTrim(str);
+      benchmark::DoNotOptimize(str);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_Trim_Legacy);
+
+static void BM_Trim(benchmark::State& state) {
+  std::size_t bytes;
+  const std::vector<std::string> lines = MakePaddedLines(bytes);
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      std::string str = line;
+      jltx::TextUtils::Trim(str);
+      benchmark::DoNotOptimize(str);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_Trim);
+
+static void BM_TrimView(benchmark::State& state) {
+  std::size_t bytes;
+  const std::vector<std::string> lines = MakePaddedLines(bytes);
+  for (auto _ : state) {
+    for (const std::string& line : lines) {
+      benchmark::DoNotOptimize(jltx::TextUtils::TrimView(line));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_TrimView);
+
+// Integer and decimal fields as found in telemetry files
+static std::vector<std::string> MakeNumericFields(bool integers) {
+  std::mt19937_64 generator(2);
+  std::uniform_real_distribution<double> real(-1000.0, 1000.0);
+  std::vector<std::string> fields;
+  for (std::size_t i = 0; i < 65536; ++i) {
+    fields.push_back(integers
+                         ? std::to_string(1600000000000 + (generator() >> 40))
+                         : std::to_string(real(generator)));
+  }
+  return fields;
+}
+
+static void BM_ParseInt_Stoll(benchmark::State& state) {
+  const std::vector<std::string> fields = MakeNumericFields(true);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const std::string& field : fields) {
+      sum += std::stoll(field);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * fields.size());
+}
+BENCHMARK(BM_ParseInt_Stoll);
+
+static void BM_ParseInt(benchmark::State& state) {
+  const std::vector<std::string> fields = MakeNumericFields(true);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const std::string& field : fields) {
+      int64_t value = 0;
+      jltx::TextUtils::ParseNumber(field, value);
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * fields.size());
+}
+BENCHMARK(BM_ParseInt);
+
+static void BM_ParseFloat_Stof(benchmark::State& state) {
+  const std::vector<std::string> fields = MakeNumericFields(false);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const std::string& field : fields) {
+      sum += std::stof(field);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * fields.size());
+}
+BENCHMARK(BM_ParseFloat_Stof);
+
+static void BM_ParseFloat(benchmark::State& state) {
+  const std::vector<std::string> fields = MakeNumericFields(false);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const std::string& field : fields) {
+      float value = 0.0f;
+      jltx::TextUtils::ParseNumber(field, value);
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * fields.size());
+}
+BENCHMARK(BM_ParseFloat);
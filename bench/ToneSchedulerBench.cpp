@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+#include "dsp/ToneScheduler.hpp"
+
+// One second of a frequency-hopping pattern at 48 kHz with range(0) switches
+// per second, rendered in blocks of 256 samples, against a per-sample loop
+// that checks for the next event before every sample
+
+static constexpr uint8_t BIT_DEPTH = 10;
+static constexpr uint32_t SAMPLE_RATE = 48000;
+static constexpr std::size_t BLOCK_SIZE = 256;
+static const float HOPS[] = {697.0f, 1209.0f, 770.0f, 1336.0f, 852.0f, 1477.0f};
+
+// Events of one second, from sample 0
+static std::vector<jltx::dsp::ToneEvent> Pattern(int64_t rate) {
+  std::vector<jltx::dsp::ToneEvent> events;
+  for (int64_t i = 0; i < rate; ++i) {
+    events.push_back({static_cast<uint64_t>(i) * SAMPLE_RATE /
+                          static_cast<uint64_t>(rate),
+                      HOPS[i % 6], 0.5f});
+  }
+  return events;
+}
+
+static void BM_ToneScheduler(benchmark::State& state) {
+  const jltx::dsp::SineLUT<BIT_DEPTH> table;
+  jltx::dsp::ToneScheduler<BIT_DEPTH> scheduler(SAMPLE_RATE, table);
+  const auto pattern = Pattern(state.range(0));
+  std::vector<float> block(BLOCK_SIZE);
+  for (auto _ : state) {
+    const uint64_t start = scheduler.Position();
+    for (const auto& event : pattern) {
+      scheduler.Schedule({start + event.sample, event.frequency,
+                          event.amplitude});
+    }
+    for (std::size_t n = 0; n < SAMPLE_RATE; n += BLOCK_SIZE) {
+      scheduler.Render(block);
+      benchmark::DoNotOptimize(block.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLE_RATE);
+  state.counters["events"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * state.range(0)),
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ToneScheduler)->RangeMultiplier(10)->Range(100, 10000);
+
+static void BM_ToneSchedulerPerSample(benchmark::State& state) {
+  const jltx::dsp::SineLUT<BIT_DEPTH> table;
+  jltx::dsp::NCO<BIT_DEPTH> nco(0.0f, SAMPLE_RATE, table);
+  const auto events = Pattern(state.range(0));
+  std::vector<float> block(BLOCK_SIZE);
+  for (auto _ : state) {
+    std::size_t next = 0;
+    float amplitude = 0.0f;
+    uint64_t position = 0;
+    for (std::size_t n = 0; n < SAMPLE_RATE; n += BLOCK_SIZE) {
+      for (auto& sample : block) {
+        if (next < events.size() && events[next].sample == position) {
+          nco.SetFrequency(events[next].frequency);
+          amplitude = events[next].amplitude;
+          ++next;
+        }
+        sample = amplitude * nco();
+        ++position;
+      }
+      benchmark::DoNotOptimize(block.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLE_RATE);
+  state.counters["events"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * state.range(0)),
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ToneSchedulerPerSample)->RangeMultiplier(10)->Range(100, 10000);
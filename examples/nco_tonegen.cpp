@@ -23,38 +23,222 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "audio/AlsaAudioSink.hpp"
+#include "audio/FileAudioSink.hpp"
+#include "audio/NullAudioSink.hpp"
 #include "dsp/NCO.hpp"
+#include "trace.hpp"
+#include "util/Clock.hpp"
+#include "util/Metrics.hpp"
+#include "util/ThreadPool.hpp"
 
 static constexpr uint8_t BIT_DEPTH = 10;
 static constexpr uint32_t BUFFER_SIZE = 256;
+static constexpr uint32_t CHUNK_SIZE = 1 << 16;  // Samples per parallel task
 
+using Nco = jltx::dsp::NCO<BIT_DEPTH>;
+
+// Render one buffer at a time into any sink
+static void Render(jltx::audio::AudioSink& sink, Nco& nco,
+                   uint64_t remaining_samples) {
+  float buffer[BUFFER_SIZE];
+  while (remaining_samples > 0) {
+    JLTX_TRACE_ZONE("Buffer");
+    const auto write_size = static_cast<uint32_t>(
+        std::min<uint64_t>(BUFFER_SIZE, remaining_samples));
+    {
+      JLTX_TRACE_ZONE("NCO");
+      for (uint32_t i = 0; i < write_size; ++i) {
+        buffer[i] = nco();
+      }
+    }
+    sink.Send(buffer, write_size);
+    remaining_samples -= write_size;
+  }
+}
+
+static void Report(const jltx::audio::AudioSink& sink, uint64_t samples,
+                   int64_t start_ns) {
+  const double seconds = static_cast<double>(jltx::NowNs() - start_ns) * 1e-9;
+  const double rate = static_cast<double>(samples) / seconds;
+  fprintf(stderr, "%" PRIu64 " samples in %.3f s, %.1f M samples/s, "
+          "%.1fx real time\n", samples, seconds, rate * 1e-6,
+          rate / sink.SampleRate());
+}
+
+// Render without sound hardware, as fast as the CPU allows
+static bool RenderOffline(jltx::audio::AudioSink& sink, Nco& nco,
+                          uint64_t samples) {
+  if (!sink.IsOpen()) {
+    fprintf(stderr, "Cannot open the output\n");
+    return false;
+  }
+  const int64_t start = jltx::NowNs();
+  Render(sink, nco, samples);
+  Report(sink, samples, start);
+  return true;
+}
+
+// Render chunks of the timeline on every core. Each chunk seeks its own copy
+// of the NCO to its first sample, so chunks do not depend on each other. A
+// chunk is sent as soon as the ones before it have been, which overlaps the
+// writes with the rendering of the following chunks.
+static bool RenderParallel(jltx::audio::AudioSink& sink, const Nco& nco,
+                           uint64_t samples) {
+  if (!sink.IsOpen()) {
+    fprintf(stderr, "Cannot open the output\n");
+    return false;
+  }
+  jltx::ThreadPool pool;
+  const std::size_t slots = pool.Size();
+  const auto chunks =
+      static_cast<std::size_t>((samples + CHUNK_SIZE - 1) / CHUNK_SIZE);
+  // Chunks are handed out in order and wait for their turn to be sent, so a
+  // chunk only starts once the one `slots` before it is out of its buffer
+  std::vector<float> buffers(slots * CHUNK_SIZE);
+  std::atomic<std::size_t> next_to_send{0};
+
+  const int64_t start = jltx::NowNs();
+  pool.ParallelFor(chunks, [&](std::size_t chunk) {
+    JLTX_TRACE_ZONE("Chunk");
+    const uint64_t first = uint64_t{chunk} * CHUNK_SIZE;
+    const auto size = static_cast<uint32_t>(
+        std::min<uint64_t>(CHUNK_SIZE, samples - first));
+    float* buffer = &buffers[(chunk % slots) * CHUNK_SIZE];
+    Nco chunk_nco = nco;
+    chunk_nco.Seek(first);
+    {
+      JLTX_TRACE_ZONE("NCO");
+      for (uint32_t i = 0; i < size; ++i) {
+        buffer[i] = chunk_nco();
+      }
+    }
+    for (std::size_t turn = next_to_send.load(std::memory_order_acquire);
+         turn != chunk; turn = next_to_send.load(std::memory_order_acquire)) {
+      next_to_send.wait(turn, std::memory_order_acquire);
+    }
+    sink.Send(buffer, size);
+    next_to_send.store(chunk + 1, std::memory_order_release);
+    next_to_send.notify_all();
+  });
+  fprintf(stderr, "%zu threads, %zu chunks of %u samples\n", slots, chunks,
+          CHUNK_SIZE);
+  Report(sink, samples, start);
+  return true;
+}
+
+// Usage: nco_tonegen <frequency> <sample rate> <seconds>
+//                    [mmap|thread|null|file <path>|parallel [path]]
+// With "mmap" the NCO renders straight into the device ring buffer. With
+// "thread" the sink's real-time playback thread pulls samples from the NCO.
+// "null" and "file" render without sound hardware at full speed, into
+// nothing or into a 16-bit WAV file. "parallel" does the same on every core,
+// into the WAV file if a path is given.
 int main(int argc, char* argv[]) {
   const uint32_t freq = atoi(argv[1]);
   const uint32_t sample_rate = atoi(argv[2]);
   const float length = static_cast<float>(atof(argv[3]));
+  const std::string_view mode = argc > 4 ? argv[4] : "";
+  const bool use_mmap = mode == "mmap";
+  const bool use_thread = mode == "thread";
+  const auto total_samples =
+      static_cast<uint64_t>(static_cast<double>(sample_rate) * atof(argv[3]));
 
   jltx::dsp::SineLUT<BIT_DEPTH> lut;
-  jltx::dsp::NCO<BIT_DEPTH> sin_nco(static_cast<float>(freq),
-                                    static_cast<float>(sample_rate), lut);
+  Nco sin_nco(static_cast<float>(freq), static_cast<float>(sample_rate), lut);
 
-  jltx::audio::AlsaAudioSink audio_sink(sample_rate);
+  if (mode == "null") {
+    jltx::audio::NullAudioSink sink(sample_rate);
+    return RenderOffline(sink, sin_nco, total_samples) ? 0 : 1;
+  }
+  if (mode == "file" || (mode == "parallel" && argc > 5)) {
+    jltx::audio::FileSinkConfig config;
+    config.path = argc > 5 ? argv[5] : "nco_tonegen.wav";
+    config.sample_rate = sample_rate;
+    config.format = jltx::audio::SampleFormat::S16;
+    jltx::audio::FileAudioSink sink(config);
+    const bool rendered = (mode == "parallel")
+                              ? RenderParallel(sink, sin_nco, total_samples)
+                              : RenderOffline(sink, sin_nco, total_samples);
+    return (rendered && sink.Close()) ? 0 : 1;
+  }
+  if (mode == "parallel") {
+    jltx::audio::NullAudioSink sink(sample_rate);
+    return RenderParallel(sink, sin_nco, total_samples) ? 0 : 1;
+  }
 
-  int32_t remaining_samples = sample_rate * static_cast<uint32_t>(length);
-  float buffer[BUFFER_SIZE];
+  jltx::audio::AlsaAudioSink audio_sink(
+      sample_rate,
+      use_mmap ? jltx::audio::AccessMode::MMAP : jltx::audio::AccessMode::RW);
+  if (!audio_sink.IsOpen()) {
+    fprintf(stderr, "Cannot open the audio device: %s\n",
+            snd_strerror(audio_sink.Error()));
+    return 1;
+  }
+  fputs(audio_sink.Negotiated().ToText().c_str(), stderr);
 
-  while (remaining_samples > 0) {
-    const int32_t write_size =
-        std::min(BUFFER_SIZE, static_cast<uint32_t>(remaining_samples));
-    for (int32_t i = 0; i < write_size; ++i) {
-      buffer[i] = sin_nco();
+  uint64_t remaining_samples = total_samples;
+
+  if (use_thread) {
+    jltx::audio::PlaybackOptions options;
+    options.render = [&](std::span<float> out) {
+      JLTX_TRACE_ZONE("NCO");
+      for (float& sample : out) {
+        sample = sin_nco();
+      }
+    };
+    options.lock_memory = true;
+    audio_sink.StartPlayback(options);
+    if (!audio_sink.IsRealtime()) {
+      fprintf(stderr, "Playback thread running without SCHED_FIFO\n");
     }
-    audio_sink.Send(buffer, write_size);
-    remaining_samples -= write_size;
-  };
+    if (!audio_sink.IsMemoryLocked()) {
+      fprintf(stderr, "Could not lock the process memory\n");
+    }
+    std::this_thread::sleep_for(std::chrono::duration<float>(length));
+    audio_sink.StopPlayback();
+    remaining_samples = 0;
+  }
+
+  while (use_mmap && remaining_samples > 0) {
+    JLTX_TRACE_ZONE("Buffer");
+    const std::span<float> area = audio_sink.BeginWrite(static_cast<uint32_t>(
+        std::min<uint64_t>(BUFFER_SIZE, remaining_samples)));
+    if (area.empty()) {
+      break;
+    }
+    {
+      JLTX_TRACE_ZONE("NCO");
+      for (float& sample : area) {
+        sample = sin_nco();
+      }
+    }
+    audio_sink.CommitWrite(static_cast<uint32_t>(area.size()));
+    remaining_samples -= area.size();
+  }
+
+  if (!use_mmap) {
+    Render(audio_sink, sin_nco, remaining_samples);
+  }
+
+  // Build with -DTRACE_ENABLED to open this file in chrome://tracing or
+  // Perfetto
+  if constexpr (jltx::trace::enabled) {
+    jltx::trace::Tracer::Instance().WriteChromeJson("nco_tonegen.trace.json");
+  }
+
+  fputs(jltx::metrics::MetricsRegistry::Global().Snapshot().ToText().c_str(),
+        stderr);
 
   return 0;
 }
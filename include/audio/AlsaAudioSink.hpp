@@ -26,24 +26,339 @@
 #define _JLTX_INCLUDE_AUDIO_ALSA_AUDIO_SINK_HPP_
 
 #include <alsa/asoundlib.h>
+#include <poll.h>
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/AudioSink.hpp"
+#include "audio/FormatConversion.hpp"
+#include "containers/SpscRing.hpp"
+#include "util/Metrics.hpp"
 
 namespace jltx {
 namespace audio {
 
-class AlsaAudioSink {
+/** \brief How samples reach the device */
+enum class AccessMode {
+  RW,   //!< Copied by snd_pcm_writei()
+  MMAP  //!< Written by the caller straight into the device ring buffer
+};
+
+/**
+ * \brief Requested stream setup
+ *
+ * Sizes set to 0 are left to the device. Small periods lower the latency at
+ * the cost of more wakeups; more periods give more headroom against xruns.
+ */
+struct AlsaConfig {
+  /** ALSA PCM name, e.g. "hw:0,0", or "null" to run without sound hardware */
+  const char* device = "default";
+  uint32_t sample_rate = 48000;
+  uint32_t channels = 1;
+
+  /** Device format. Samples are always passed as float and converted. */
+  SampleFormat format = SampleFormat::FLOAT;
+
+  AccessMode access = AccessMode::RW;
+
+  /** Frames the device consumes between interrupts */
+  uint32_t period_frames = 0;
+
+  /** Periods in the device ring buffer */
+  uint32_t periods = 0;
+
+  /** Frames queued before the stream starts. 0 keeps ALSA's default for
+   * Send() and the whole buffer for the playback thread. */
+  uint32_t start_threshold = 0;
+
+  /** Open with SND_PCM_NONBLOCK, so that writes take what fits and return.
+   * One thread can then drive several devices, see AlsaOutputEngine. */
+  bool nonblocking = false;
+};
+
+/** \brief Values the device accepted for an AlsaConfig */
+struct AlsaStreamInfo {
+  uint32_t sample_rate = 0;
+  uint32_t channels = 0;
+  SampleFormat format = SampleFormat::FLOAT;
+  AccessMode access = AccessMode::RW;
+  uint32_t period_frames = 0;
+  uint32_t buffer_frames = 0;
+  uint32_t start_threshold = 0;
+
+  /** One line per value, for logs and command line tools */
+  [[nodiscard]] std::string ToText() const;
+};
+
+/** \brief Fills a span of samples, one period or the part of it before the
+ * end of the device buffer, on the playback thread. Samples are interleaved,
+ * so the span holds frames * channels floats. It must not block, allocate or
+ * take locks. */
+using RenderCallback = std::function<void(std::span<float>)>;
+
+struct PlaybackOptions {
+  /** Source of the samples. If empty, the thread plays what is passed to
+   * Send() or Enqueue(). */
+  RenderCallback render;
+
+  /** Size in periods of the ring between Send()/Enqueue() and the thread */
+  uint32_t ring_periods = 8;
+
+  /** Run the thread with SCHED_FIFO, which needs CAP_SYS_NICE or an
+   * rtprio limit. If refused, the thread runs with normal priority. */
+  bool realtime = true;
+  int priority = 70;
+
+  /** Lock all the process memory with mlockall() to avoid page faults.
+   * This affects the whole process, needs CAP_IPC_LOCK or a large enough
+   * RLIMIT_MEMLOCK, and is not undone by StopPlayback(). Whether it worked
+   * is reported by IsMemoryLocked(). */
+  bool lock_memory = false;
+};
+
+class AlsaAudioSink : public AudioSink {
  public:
-  AlsaAudioSink(uint32_t sample_rate);
-  ~AlsaAudioSink();
+  static constexpr const char* DEFAULT_DEVICE = "default";
+
+  /**
+   * \param sample_rate Requested sample rate, see SampleRate()
+   * \param access Access mode. Send() works in both; BeginWrite() and
+   * CommitWrite() need AccessMode::MMAP.
+   * \param device ALSA PCM name, e.g. "hw:0,0", or "null" to run without
+   * sound hardware
+   */
+  AlsaAudioSink(uint32_t sample_rate, AccessMode access = AccessMode::RW,
+                const char* device = DEFAULT_DEVICE);
+
+  /**
+   * \brief Open and set up the device, checking every step
+   *
+   * On failure IsOpen() is false, Error() holds the ALSA error code and all
+   * the other calls do nothing.
+   */
+  explicit AlsaAudioSink(const AlsaConfig& config);
+  ~AlsaAudioSink() override;
+
+  /**
+   * \brief Write interleaved samples, blocking until they are accepted
+   *
+   * While the playback thread runs without a render callback, the samples
+   * are queued for it instead of written to the device. If the thread has
+   * stopped on a device error, only the frames that fit in its queue are
+   * accepted.
+   *
+   * \param buffer size * Channels() samples
+   * \param size Number of frames
+   * \return Number of frames written
+   */
+  uint32_t Send(const float* buffer, uint32_t size) override;
+
+  /**
+   * \brief Write one buffer per channel, interleaving and converting them
+   * straight into the device format. Not available while the playback thread
+   * runs.
+   *
+   * \param planes Channels() pointers to at least size samples
+   * \param size Number of frames
+   * \return Number of frames written
+   */
+  uint32_t SendPlanar(std::span<const float* const> planes, uint32_t size);
+
+  /**
+   * \brief Start a dedicated thread that refills the device one period per
+   * wakeup, pulling from options.render or from the Send() queue
+   *
+   * The thread records the deviation of its wakeups from the period length
+   * in the audio.alsa.wakeup_jitter_ns histogram, and queue underflows in
+   * audio.alsa.ring_underruns.
+   *
+   * \return false if the thread is already running
+   */
+  bool StartPlayback(PlaybackOptions options = {});
+
+  /** \brief Stop the playback thread, if running */
+  void StopPlayback();
 
-  uint32_t Send(float* buffer, uint32_t size);
+  /**
+   * \brief Queue samples for the playback thread without blocking
+   *
+   * \param buffer size * Channels() samples
+   * \param size Number of frames
+   * \return Number of frames queued
+   */
+  uint32_t Enqueue(const float* buffer, uint32_t size);
 
-  [[nodiscard]] uint32_t SampleRate() const;
+  /**
+   * \brief Descriptors to wait on for room in the device buffer
+   *
+   * Hand what poll() or epoll reports for them to PollRevents().
+   */
+  [[nodiscard]] std::vector<pollfd> PollDescriptors();
+
+  /** \return POLLOUT and/or POLLERR, translated from the revents in fds */
+  unsigned short PollRevents(std::span<pollfd> fds);
+
+  /**
+   * \brief Fill the room the device has right now with samples from render
+   *
+   * Meant for non-blocking mode: it never waits for the device, and xruns
+   * and suspends are recovered without sleeping. A device that is not ready
+   * to resume yet is retried on the next call. Not available while the
+   * playback thread runs.
+   *
+   * \param render Source of the samples, called once per period or less
+   * \param max_frames Maximum number of frames written
+   * \return Frames written
+   */
+  uint32_t Pump(const RenderCallback& render,
+                uint32_t max_frames = UINT32_MAX);
+
+  /** \return true if the playback thread got SCHED_FIFO */
+  [[nodiscard]] bool IsRealtime() const {
+    return m_realtime.load(std::memory_order_relaxed);
+  }
+
+  /** \return true if PlaybackOptions::lock_memory was set and mlockall()
+   * succeeded in the last StartPlayback() */
+  [[nodiscard]] bool IsMemoryLocked() const { return m_memory_locked; }
+
+  /**
+   * \brief Get a writable part of the device ring buffer (mmap mode only)
+   *
+   * Waits until the device has room, or returns an empty span in
+   * non-blocking mode. The stream starts when the ring buffer is full or
+   * when the sink is destroyed. Write the interleaved samples into
+   * the span, then call CommitWrite(). The span may be shorter than
+   * max_frames when the ring buffer wraps around.
+   *
+   * The device memory can only be handed out as floats when the format is
+   * SampleFormat::FLOAT. With other formats use Send().
+   *
+   * \param max_frames Maximum number of frames wanted
+   * \return frames * Channels() samples of device memory, empty on error
+   */
+  std::span<float> BeginWrite(uint32_t max_frames);
+
+  /**
+   * \brief Hand the frames written after BeginWrite() to the device
+   *
+   * \param frames Number of frames written, at most the size of the span
+   * \return Frames committed, 0 on error
+   */
+  uint32_t CommitWrite(uint32_t frames);
+
+  /** \return true if the device was opened and set up */
+  [[nodiscard]] bool IsOpen() const override {
+    return m_pcm_handle != nullptr;
+  }
+
+  /** \return ALSA error code of the failed setup step, 0 if none */
+  [[nodiscard]] int Error() const { return m_error; }
+
+  /** \return Values negotiated with the device */
+  [[nodiscard]] const AlsaStreamInfo& Negotiated() const { return m_info; }
+
+  [[nodiscard]] uint32_t SampleRate() const override;
+
+  [[nodiscard]] uint32_t Channels() const override { return m_info.channels; }
+
+  [[nodiscard]] SampleFormat Format() const { return m_info.format; }
+
+  [[nodiscard]] AccessMode Access() const { return m_info.access; }
+
+  [[nodiscard]] bool NonBlocking() const { return m_nonblocking; }
+
+  /** Number of frames the device consumes between interrupts */
+  [[nodiscard]] uint32_t PeriodFrames() const { return m_info.period_frames; }
+
+  /** Size in frames of the device ring buffer */
+  [[nodiscard]] uint32_t BufferFrames() const { return m_info.buffer_frames; }
 
  private:
-  snd_pcm_t* m_pcm_handle;
-  uint32_t m_sample_rate;
+  snd_pcm_t* m_pcm_handle = nullptr;
+  int m_error = 0;
+  AlsaStreamInfo m_info;
+  uint32_t m_requested_start_threshold;
+  bool m_nonblocking;
+  std::size_t m_frame_bytes;
+
+  // One period rendered in float, when it cannot go straight to the device
+  std::vector<float> m_period_buffer;
+  // One period in the device format, converted before snd_pcm_writei()
+  std::vector<char> m_convert_buffer;
+  // Plane pointers advanced by SendPlanar()
+  std::vector<const float*> m_planes;
+
+  // Area returned by the last BeginWrite()
+  snd_pcm_uframes_t m_mmap_offset = 0;
+  snd_pcm_uframes_t m_mmap_frames = 0;
+
+  // Shared by all the sinks, in the global metrics registry
+  metrics::Counter& m_frames_written;
+  metrics::Counter& m_xruns;
+  metrics::Histogram& m_write_latency;
+  metrics::Histogram& m_wakeup_jitter;
+  metrics::Counter& m_ring_underruns;
+  metrics::Gauge& m_ring_depth;
+
+  // Playback thread
+  RenderCallback m_render;
+  std::unique_ptr<SpscRing<float>> m_ring;
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_realtime{false};
+  // Set when the thread gives up on an unrecoverable device error
+  std::atomic<bool> m_playback_exited{false};
+  bool m_memory_locked = false;
+  std::thread m_playback_thread;
+
+  int Configure(const AlsaConfig& config);
+  int ConfigureSoftware(snd_pcm_uframes_t start_threshold);
+
+  /** Wait for room in the device buffer (unless non-blocking) and map up to
+   * max_frames of it */
+  char* BeginArea(uint32_t max_frames, uint32_t& frames);
+
+  /** snd_pcm_writei() of device format frames */
+  uint32_t WriteDevice(const void* data, uint32_t frames);
+
+  /**
+   * Write frames, letting convert(out, first, count) fill device memory with
+   * frames [first, first + count) in the device format
+   */
+  template <typename Convert>
+  uint32_t WriteConverted(uint32_t frames, Convert&& convert);
+
+  /**
+   * Write frames rendered by source(span) in float, at most one period per
+   * call, straight into device memory when the format allows it
+   */
+  template <typename Source>
+  uint32_t WriteRendered(uint32_t frames, Source&& source);
+
+  void PlaybackLoop(bool realtime, int priority);
+  bool WritePeriod();
+  void RenderPeriod(std::span<float> out);
+
+  /**
+   * Recover from an xrun or suspend, without sleeping in non-blocking mode
+   * \return true if the stream can go on
+   */
+  bool Recover(int error);
+
+  /**
+   * Recover on the playback thread, sleeping while a suspended device is
+   * still resuming
+   *
+   * \return false if the device cannot be recovered
+   */
+  bool RecoverOrWait(int error);
 };
 
 }  // namespace audio
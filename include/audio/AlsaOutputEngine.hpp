@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_AUDIO_ALSA_OUTPUT_ENGINE_HPP_
+#define _JLTX_INCLUDE_AUDIO_ALSA_OUTPUT_ENGINE_HPP_
+
+#include <poll.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "audio/AlsaAudioSink.hpp"
+#include "util/Metrics.hpp"
+
+namespace jltx {
+namespace audio {
+
+/**
+ * \brief Drives several non-blocking AlsaAudioSinks from a single thread
+ *
+ * The poll descriptors of all the sinks share one epoll instance. When a
+ * device has room, AlsaAudioSink::Pump() fills exactly that room from the
+ * sink's render callback. Some descriptors cannot be watched by epoll, such
+ * as the /dev/null behind ALSA's "null" PCM. Those sinks get a timer that
+ * fires once per period instead and are given one period per tick.
+ *
+ * The time spent filling devices after every wakeup is recorded in the
+ * audio.engine.service_ns histogram.
+ */
+class AlsaOutputEngine {
+ public:
+  AlsaOutputEngine();
+  ~AlsaOutputEngine();
+
+  AlsaOutputEngine(const AlsaOutputEngine&) = delete;
+  AlsaOutputEngine& operator=(const AlsaOutputEngine&) = delete;
+
+  /** \return false if the epoll instance could not be created */
+  [[nodiscard]] bool IsValid() const {
+    return m_epoll_fd >= 0 && m_wake_fd >= 0;
+  }
+
+  /**
+   * \brief Start servicing a sink
+   *
+   * Only while the engine thread is stopped. The sink must be open with
+   * AlsaConfig::nonblocking and outlive its registration.
+   *
+   * \param render Source of the sink's samples, called on the engine thread.
+   * It must not block.
+   * \return false if the sink cannot be added
+   */
+  bool Add(AlsaAudioSink& sink, RenderCallback render);
+
+  /** \brief Stop servicing a sink, only while the engine thread is stopped */
+  bool Remove(AlsaAudioSink& sink);
+
+  /** \return Number of sinks serviced */
+  [[nodiscard]] std::size_t Size() const;
+
+  /**
+   * \brief Wait for devices with room and fill them
+   *
+   * \param timeout_ms Maximum wait, -1 to wait forever
+   * \return Number of sinks filled, -1 on error
+   */
+  int RunOnce(int timeout_ms);
+
+  /**
+   * \brief Run RunOnce() on a dedicated thread until Stop()
+   *
+   * \param realtime Run the thread with SCHED_FIFO, see
+   * PlaybackOptions::realtime
+   * \return false if the thread is already running
+   */
+  bool Start(bool realtime = true, int priority = 70);
+
+  /** \brief Stop the engine thread, if running */
+  void Stop();
+
+  /** \return true if the engine thread got SCHED_FIFO */
+  [[nodiscard]] bool IsRealtime() const {
+    return m_realtime.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Device {
+    AlsaAudioSink* sink;
+    RenderCallback render;
+    std::vector<pollfd> fds;
+    int timer_fd = -1;         // Period timer, for descriptors epoll refuses
+    uint64_t timer_ticks = 0;  // Timer periods not pumped yet
+    bool ready = false;
+  };
+
+  int m_epoll_fd;
+  int m_wake_fd;  // eventfd that interrupts the wait on Stop()
+
+  // Indexed by the slot in the epoll data, empty once removed
+  std::vector<std::unique_ptr<Device>> m_devices;
+  std::vector<Device*> m_ready;
+
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_realtime{false};
+  std::thread m_thread;
+
+  metrics::Histogram& m_service_time;
+
+  void Unregister(Device& device);
+};
+
+}  // namespace audio
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_AUDIO_ALSA_OUTPUT_ENGINE_HPP_
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_AUDIO_AUDIO_SINK_HPP_
+#define _JLTX_INCLUDE_AUDIO_AUDIO_SINK_HPP_
+
+#include <cstdint>
+
+namespace jltx {
+namespace audio {
+
+/**
+ * \brief Destination of rendered audio
+ *
+ * Samples are interleaved floats in [-1, 1]; sinks convert them to their own
+ * format. Implemented by AlsaAudioSink for sound cards, FileAudioSink for
+ * WAV and raw files, and NullAudioSink for measurements.
+ */
+class AudioSink {
+ public:
+  virtual ~AudioSink() = default;
+
+  /**
+   * \brief Write interleaved samples
+   *
+   * \param buffer size * Channels() samples
+   * \param size Number of frames
+   * \return Number of frames written
+   */
+  virtual uint32_t Send(const float* buffer, uint32_t size) = 0;
+
+  [[nodiscard]] virtual uint32_t SampleRate() const = 0;
+
+  [[nodiscard]] virtual uint32_t Channels() const = 0;
+
+  /** \return false if the sink could not be set up */
+  [[nodiscard]] virtual bool IsOpen() const = 0;
+};
+
+}  // namespace audio
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_AUDIO_AUDIO_SINK_HPP_
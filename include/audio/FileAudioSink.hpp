@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_AUDIO_FILE_AUDIO_SINK_HPP_
+#define _JLTX_INCLUDE_AUDIO_FILE_AUDIO_SINK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "audio/AudioSink.hpp"
+#include "audio/FormatConversion.hpp"
+
+namespace jltx {
+namespace audio {
+
+enum class FileContainer {
+  WAV,  //!< RIFF/WAVE, sizes filled in by Close(). S24 is stored in the high
+        //!< bits of 32-bit words, as WAV requires.
+  RAW   //!< Samples only, as ConvertFromFloat() writes them
+};
+
+/** \brief How samples reach the file */
+enum class FileWriteMode {
+  BUFFERED,  //!< write() of whole buffers through the page cache
+  DIRECT,    //!< Same, with O_DIRECT to bypass the page cache
+  MMAP       //!< Converted straight into a mapped window of the file
+};
+
+struct FileSinkConfig {
+  const char* path = nullptr;
+  uint32_t sample_rate = 48000;
+  uint32_t channels = 1;
+  SampleFormat format = SampleFormat::FLOAT;
+  FileContainer container = FileContainer::WAV;
+  FileWriteMode mode = FileWriteMode::BUFFERED;
+
+  /** Size of the write buffer or mapped window, rounded up to BLOCK_SIZE */
+  std::size_t buffer_size = std::size_t{1} << 20;
+};
+
+/**
+ * \brief Streams audio to a WAV or raw file
+ *
+ * Samples are converted into a large aligned buffer, which goes to the file
+ * in whole blocks. Nothing is written per Send(), so rendering runs at full
+ * CPU speed, which makes the sink useful for tests and CI without sound
+ * hardware.
+ *
+ * Samples are stored in native byte order, which WAV expects to be little
+ * endian.
+ */
+class FileAudioSink : public AudioSink {
+ public:
+  /** Alignment and granularity of the writes, as O_DIRECT needs */
+  static constexpr std::size_t BLOCK_SIZE = 4096;
+
+  explicit FileAudioSink(const FileSinkConfig& config);
+
+  /** Calls Close() */
+  ~FileAudioSink() override;
+
+  FileAudioSink(const FileAudioSink&) = delete;
+  FileAudioSink& operator=(const FileAudioSink&) = delete;
+
+  /** \return Frames written, less than size after an I/O error */
+  uint32_t Send(const float* buffer, uint32_t size) override;
+
+  /**
+   * \brief Write what is buffered, fill in the WAV sizes and close the file
+   *
+   * \return false if any write failed
+   */
+  bool Close();
+
+  [[nodiscard]] uint32_t SampleRate() const override {
+    return m_config.sample_rate;
+  }
+
+  [[nodiscard]] uint32_t Channels() const override {
+    return m_config.channels;
+  }
+
+  /** \return true until the file is closed */
+  [[nodiscard]] bool IsOpen() const override { return m_fd >= 0; }
+
+  /** \return errno of the first failure, 0 if none */
+  [[nodiscard]] int Error() const { return m_error; }
+
+  [[nodiscard]] uint64_t FramesWritten() const { return m_frames; }
+
+ private:
+  FileSinkConfig m_config;
+  int m_fd = -1;
+  int m_error = 0;
+  uint64_t m_frames = 0;
+  std::size_t m_sample_bytes;
+  std::size_t m_header_bytes;
+
+  // Aligned buffer, or the mapped window of the file in MMAP mode
+  char* m_window = nullptr;
+  std::size_t m_window_size;
+  std::size_t m_fill = 0;
+
+  // File offset of the start of the window
+  uint64_t m_window_offset = 0;
+
+  /** Write the window out, or map the next one, \return false on error */
+  bool Advance();
+
+  bool Fail();
+
+  /** Header for the current sizes, \return its length */
+  std::size_t FormatHeader(char* out) const;
+};
+
+}  // namespace audio
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_AUDIO_FILE_AUDIO_SINK_HPP_
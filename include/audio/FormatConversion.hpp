@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_AUDIO_FORMAT_CONVERSION_HPP_
+#define _JLTX_INCLUDE_AUDIO_FORMAT_CONVERSION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace jltx {
+namespace audio {
+
+/** \brief Sample formats, all in native byte order */
+enum class SampleFormat {
+  FLOAT,  //!< 32-bit float in [-1, 1]
+  S16,    //!< 16-bit signed integer
+  S24,    //!< 24-bit signed integer in the low bits of a 32-bit word
+  S32     //!< 32-bit signed integer
+};
+
+/** \return Bytes taken by one sample in memory */
+constexpr std::size_t BytesPerSample(SampleFormat format) {
+  return format == SampleFormat::S16 ? 2 : 4;
+}
+
+/** \return Format name, as used in reports */
+const char* FormatName(SampleFormat format);
+
+/**
+ * \brief Convert float samples to another format
+ *
+ * Samples are scaled by 2^(bits - 1), rounded to nearest and clipped to the
+ * range of the format, so -1.0 maps to the most negative value and +1.0 to
+ * the most positive one. NaN maps to the most negative value. With
+ * SampleFormat::FLOAT the samples are copied unchanged.
+ *
+ * Uses AVX2 when the CPU supports it and SSE2 otherwise.
+ *
+ * \param in Samples, in any channel layout
+ * \param format Output format
+ * \param out in.size() * BytesPerSample(format) bytes
+ */
+void ConvertFromFloat(std::span<const float> in, SampleFormat format,
+                      void* out);
+
+/**
+ * \brief Interleave planar float channels while converting them, like
+ * ConvertFromFloat()
+ *
+ * \param planes One pointer per channel to at least frames samples
+ * \param frames Number of frames
+ * \param format Output format
+ * \param out frames * planes.size() * BytesPerSample(format) bytes
+ */
+void InterleaveFromFloat(std::span<const float* const> planes,
+                         std::size_t frames, SampleFormat format, void* out);
+
+}  // namespace audio
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_AUDIO_FORMAT_CONVERSION_HPP_
@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_AUDIO_NULL_AUDIO_SINK_HPP_
+#define _JLTX_INCLUDE_AUDIO_NULL_AUDIO_SINK_HPP_
+
+#include <cstdint>
+
+#include "audio/AudioSink.hpp"
+
+namespace jltx {
+namespace audio {
+
+/**
+ * \brief Discards samples, counting them and timing the producer
+ *
+ * Useful to measure how fast a pipeline renders without any I/O cost.
+ */
+class NullAudioSink : public AudioSink {
+ public:
+  explicit NullAudioSink(uint32_t sample_rate, uint32_t channels = 1)
+      : m_sample_rate(sample_rate), m_channels(channels) {}
+
+  uint32_t Send(const float* buffer, uint32_t size) override;
+
+  [[nodiscard]] uint32_t SampleRate() const override { return m_sample_rate; }
+
+  [[nodiscard]] uint32_t Channels() const override { return m_channels; }
+
+  [[nodiscard]] bool IsOpen() const override { return true; }
+
+  [[nodiscard]] uint64_t FramesWritten() const { return m_frames; }
+
+  /** \return Frames per second between the first and the last Send() */
+  [[nodiscard]] double FramesPerSecond() const;
+
+  /** \return FramesPerSecond() over the sample rate: how many times faster
+   * than real time the producer runs */
+  [[nodiscard]] double RealtimeFactor() const;
+
+  /** Forget the frames and times measured so far */
+  void Reset();
+
+ private:
+  uint32_t m_sample_rate;
+  uint32_t m_channels;
+  uint64_t m_frames = 0;
+  uint64_t m_first_frames = 0;
+  int64_t m_first_ns = 0;
+  int64_t m_last_ns = 0;
+};
+
+}  // namespace audio
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_AUDIO_NULL_AUDIO_SINK_HPP_
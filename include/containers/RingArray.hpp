@@ -46,14 +46,11 @@ class RingArray {
     Iterator(RingArray& ring, std::size_t index)
         : m_ring(ring), m_index(index) {}
 
-    bool operator==(const Iterator& other) {
-      return (m_ring.m_array == other.m_ring.m_array) &&
-             (m_ring.m_head == other.m_ring.m_head) &&
-             (m_ring.m_tail == other.m_ring.m_tail) &&
-             (m_index == other.m_index);
+    bool operator==(const Iterator& other) const {
+      return (&m_ring == &other.m_ring) && (m_index == other.m_index);
     }
 
-    bool operator!=(const Iterator& other) { return !(*this == other); }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
 
     Iterator& operator++() {
       m_index++;
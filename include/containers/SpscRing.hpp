@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_CONTAINERS_SPSC_RING_HPP_
+#define _JLTX_INCLUDE_CONTAINERS_SPSC_RING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace jltx {
+
+/**
+ * @brief Wait-free ring buffer for one producer thread and one consumer
+ * thread
+ *
+ * Write() and Read() copy as many elements as fit and never block or
+ * allocate, so either side can be a real-time thread. Each side keeps a
+ * cached copy of the other side's position and only reloads it when the
+ * cache says the ring is full or empty.
+ */
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SpscRing {
+ public:
+  /** @param capacity Minimum number of elements, rounded up to a power of 2 */
+  explicit SpscRing(std::size_t capacity)
+      : m_capacity(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+        m_data(new T[m_capacity]) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  /** Producer side: append up to data.size() elements, return how many */
+  std::size_t Write(std::span<const T> data) {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_capacity - (tail - m_cached_head) < data.size()) {
+      m_cached_head = m_head.load(std::memory_order_acquire);
+    }
+    const std::size_t count =
+        std::min(data.size(), m_capacity - (tail - m_cached_head));
+
+    const std::size_t offset = tail & (m_capacity - 1);
+    const std::size_t first = std::min(count, m_capacity - offset);
+    std::copy_n(data.data(), first, m_data.get() + offset);
+    std::copy_n(data.data() + first, count - first, m_data.get());
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  /** Consumer side: take up to data.size() elements, return how many */
+  std::size_t Read(std::span<T> data) {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (m_cached_tail - head < data.size()) {
+      m_cached_tail = m_tail.load(std::memory_order_acquire);
+    }
+    const std::size_t count = std::min(data.size(), m_cached_tail - head);
+
+    const std::size_t offset = head & (m_capacity - 1);
+    const std::size_t first = std::min(count, m_capacity - offset);
+    std::copy_n(m_data.get() + offset, first, data.data());
+    std::copy_n(m_data.get(), count - first, data.data() + first);
+    m_head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  /** Number of elements waiting to be read, from either thread */
+  [[nodiscard]] std::size_t FillLevel() const {
+    return m_tail.load(std::memory_order_acquire) -
+           m_head.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] std::size_t Capacity() const { return m_capacity; }
+
+ private:
+  const std::size_t m_capacity;
+  const std::unique_ptr<T[]> m_data;
+
+  // Written by the consumer
+  alignas(64) std::atomic<std::size_t> m_head{0};
+  std::size_t m_cached_tail = 0;
+
+  // Written by the producer
+  alignas(64) std::atomic<std::size_t> m_tail{0};
+  std::size_t m_cached_head = 0;
+};
+
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_CONTAINERS_SPSC_RING_HPP_
@@ -0,0 +1,131 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_CONTAINERS_WORK_STEALING_DEQUE_HPP_
+#define _JLTX_INCLUDE_CONTAINERS_WORK_STEALING_DEQUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace jltx {
+
+/**
+ * @brief Fixed-capacity Chase-Lev deque
+ *
+ * The owner thread pushes and pops at the bottom, in LIFO order, so it keeps
+ * working on what it touched last. Any other thread may steal from the top,
+ * taking the oldest element. No operation blocks or allocates. Memory
+ * orderings follow Lê et al., "Correct and Efficient Work-Stealing for Weak
+ * Memory Models" (PPoPP 2013), without the resizing.
+ */
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class WorkStealingDeque {
+ public:
+  /** @param capacity Maximum number of elements, rounded up to a power of 2.
+   * The caller must never hold more. */
+  explicit WorkStealingDeque(std::size_t capacity)
+      : m_mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+        m_items(new std::atomic<T>[m_mask + 1]) {}
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  /** Owner side: add an element at the bottom */
+  void Push(T item) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    m_items[Index(bottom)].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  /** Owner side: take the newest element, return false if empty */
+  bool Pop(T& item) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {  // Empty
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+    item = m_items[Index(bottom)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last element: race the thieves for it
+      const bool won = m_top.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  /** Any thread: take the oldest element, return false if empty or lost to
+   * another thread */
+  bool Steal(T& item) {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return false;
+    }
+    item = m_items[Index(top)].load(std::memory_order_relaxed);
+    return m_top.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed);
+  }
+
+  /** Number of elements, exact only when no other thread is active */
+  [[nodiscard]] std::size_t Size() const {
+    const int64_t size = m_bottom.load(std::memory_order_relaxed) -
+                         m_top.load(std::memory_order_relaxed);
+    return static_cast<std::size_t>(std::max<int64_t>(size, 0));
+  }
+
+  [[nodiscard]] std::size_t Capacity() const { return m_mask + 1; }
+
+ private:
+  const std::size_t m_mask;
+  const std::unique_ptr<std::atomic<T>[]> m_items;
+
+  // Advanced by thieves and by the owner taking the last element
+  alignas(64) std::atomic<int64_t> m_top{0};
+
+  // Written by the owner
+  alignas(64) std::atomic<int64_t> m_bottom{0};
+
+  [[nodiscard]] std::size_t Index(int64_t position) const {
+    return static_cast<std::size_t>(position) & m_mask;
+  }
+};
+
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_CONTAINERS_WORK_STEALING_DEQUE_HPP_
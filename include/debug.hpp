@@ -40,9 +40,12 @@ static constexpr int defined_level = 0;
 template <typename... Args>
 static void log(FILE* file, const char* tag, const char* levelTag,
                 const char* fmt, Args... args) {
+  // Keep the three parts of the line together when several threads log
+  flockfile(file);
   fprintf(file, "[%s] %s: ", levelTag, tag);
   fprintf(file, fmt, args...);
   fprintf(file, "\n");
+  funlockfile(file);
 }
 
 template <typename... Args>
@@ -51,19 +54,27 @@ static void log(FILE* file, const char* tag, const char* levelTag,
   log(file, tag, levelTag, "%s", str);
 }
 
-/** \brief Custom logger to configurable output file */
-class Logger final {
+/** \brief Custom logger to configurable output
+ *
+ * Output is a FILE for Logger. BasicLogger can also be constructed with an
+ * AsyncLogBackend (util/AsyncLog.hpp) or a BinaryLogWriter
+ * (util/BinaryLog.hpp), which must outlive it; those headers provide the
+ * matching log() overloads.
+ */
+template <typename Output>
+class BasicLogger final {
  private:
-  FILE* file;
+  Output* output;
 
  public:
-  explicit Logger(FILE* log_file) : file(log_file) {}
+  explicit BasicLogger(Output* log_output) : output(log_output) {}
+  explicit BasicLogger(Output& log_output) : output(&log_output) {}
 
 #define LOG_FUNCTION(name, level, level_tag)              \
   template <typename... Args>                             \
   inline void name(const char* tag, Args... args) const { \
     if constexpr (defined_level >= level) {               \
-      log(file, tag, level_tag, args...);                 \
+      log(output, tag, level_tag, args...);               \
     }                                                     \
   }
 
@@ -74,6 +85,9 @@ class Logger final {
   LOG_FUNCTION(v, 2, "VERBOSE");
 };
 
+/** \brief Logger writing to a FILE */
+using Logger = BasicLogger<FILE>;
+
 /** Standard Logger to stdout */
 const Logger Log(stdout);
 
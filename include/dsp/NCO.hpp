@@ -27,7 +27,9 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 
 namespace jltx {
 namespace dsp {
@@ -50,6 +52,8 @@ class SineLUT {
     return m_table[i & m_mask];
   }
 
+  [[nodiscard]] const float* Data() const { return m_table.data(); }
+
   static constexpr float ROTATION = 2.0f * (1u << (8 * sizeof(uint32_t) - 1));
 
  private:
@@ -58,6 +62,18 @@ class SineLUT {
   std::array<float, m_length> m_table;
 };
 
+/**
+ * @brief Fill out with amplitude * table[phase_i >> shift], where phase_i =
+ * phase + i * delta modulo 2^32
+ *
+ * Every phase is computed from i, so there is no dependency between samples
+ * and the loop runs 8 samples at a time with AVX2 gathers where available.
+ *
+ * @param table Sine table of 2^(32 - shift) entries
+ */
+void RenderSine(const float* table, uint32_t shift, uint32_t phase,
+                uint32_t delta, float amplitude, float* out, std::size_t n);
+
 template <uint8_t bit_depth>
 class NCO {
  public:
@@ -70,7 +86,7 @@ class NCO {
   }
 
   [[nodiscard]] float operator()() {
-    const unsigned int index = m_phase >> (sizeof(uint32_t) * 8 - bit_depth);
+    const unsigned int index = m_phase >> SHIFT;
     float value = m_table[index];
     m_phase += m_delta_phase;
     return value;
@@ -78,14 +94,70 @@ class NCO {
 
   [[nodiscard]] float operator[](uint32_t i) const { return m_table[i]; }
 
-  [[nodiscard]] float Frequency() const;
-  void SetFrequency(float frequency) { m_frequency = frequency; }
+  /**
+   * @brief Fill a buffer, same as calling operator() for every sample
+   *
+   * @param amplitude Scale of every sample
+   */
+  void Render(std::span<float> out, float amplitude = 1.0f) {
+    RenderSine(m_table.Data(), SHIFT, m_phase, m_delta_phase, amplitude,
+               out.data(), out.size());
+    m_phase += static_cast<uint32_t>(out.size()) * m_delta_phase;
+  }
+
+  [[nodiscard]] float Frequency() const { return m_frequency; }
+
+  /** @brief Change the frequency from the next sample on, keeping the phase,
+   * so the output stays continuous */
+  void SetFrequency(float frequency) {
+    m_frequency = frequency;
+    ResetPhaseDelta();
+  }
 
-  [[nodiscard]] float SampleRate() const;
-  void SetSampleRate(float sample_sate) { m_sample_rate = sample_sate; };
+  [[nodiscard]] float SampleRate() const { return m_sample_rate; }
+  void SetSampleRate(float sample_rate) {
+    m_sample_rate = sample_rate;
+    ResetPhaseDelta();
+  }
 
   void ResetPhase() { m_phase = 0; }
 
+  /** @return Phase increment per sample of a frequency, out of 2^32.
+   * Frequencies outside [0, sample_rate) wrap around like their aliases; a
+   * ratio that is not finite gives 0. */
+  [[nodiscard]] static uint32_t PhaseDelta(float frequency,
+                                           float sample_rate) {
+    constexpr float ROTATION = SineLUT<bit_depth>::ROTATION;
+    const float delta = frequency * ROTATION / sample_rate;
+    if (delta >= 0.0f && delta < ROTATION) {
+      return static_cast<uint32_t>(delta);
+    }
+    if (!std::isfinite(delta)) {
+      return 0;
+    }
+    // Brought into [0, 2^32] first: converting a value outside the range of
+    // uint32_t is undefined
+    float wrapped = std::fmod(delta, ROTATION);
+    if (wrapped < 0.0f) {
+      wrapped += ROTATION;
+    }
+    return static_cast<uint32_t>(static_cast<uint64_t>(wrapped));
+  }
+
+  /** Right shift from the phase to the table index */
+  static constexpr uint32_t SHIFT = sizeof(uint32_t) * 8 - bit_depth;
+
+  /**
+   * @brief Jump to the phase of a sample as if rendering from phase 0
+   *
+   * The phase accumulator wraps modulo 2^32, so the phase of sample n is
+   * n * delta in closed form and matches the running sum exactly. Separate
+   * parts of a signal can then be rendered independently.
+   */
+  void Seek(uint64_t sample) {
+    m_phase = static_cast<uint32_t>(sample * m_delta_phase);
+  }
+
  private:
   const SineLUT<bit_depth>& m_table;
 
@@ -96,8 +168,7 @@ class NCO {
   float m_sample_rate;
 
   void ResetPhaseDelta() {
-    m_delta_phase =
-        (uint32_t)(m_frequency * SineLUT<bit_depth>::ROTATION / m_sample_rate);
+    m_delta_phase = PhaseDelta(m_frequency, m_sample_rate);
   }
 };
 
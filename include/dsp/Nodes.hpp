@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_DSP_NODES_HPP_
+#define _JLTX_INCLUDE_DSP_NODES_HPP_
+
+#include <cstdint>
+#include <span>
+
+#include "dsp/NCO.hpp"
+#include "dsp/ProcessingGraph.hpp"
+
+namespace jltx {
+namespace dsp {
+
+/** \brief Mono sine source */
+template <uint8_t bit_depth>
+class NcoNode : public Node {
+ public:
+  NcoNode(float frequency, float sample_rate, const SineLUT<bit_depth>& table,
+          float amplitude = 1.0f)
+      : m_nco(frequency, sample_rate, table), m_amplitude(amplitude) {}
+
+  void Process(std::span<const Block> /*inputs*/,
+               const Block& output) override {
+    float* out = output.Channel(0);
+    for (uint32_t i = 0; i < output.frames; ++i) {
+      out[i] = m_amplitude * m_nco();
+    }
+  }
+
+ private:
+  NCO<bit_depth> m_nco;
+  float m_amplitude;
+};
+
+/**
+ * \brief Scales its first input
+ *
+ * A mono input is copied to every output channel.
+ */
+class GainNode : public Node {
+ public:
+  explicit GainNode(float gain, uint32_t channels = 1)
+      : m_gain(gain), m_channels(channels) {}
+
+  [[nodiscard]] uint32_t Channels() const override { return m_channels; }
+
+  void Process(std::span<const Block> inputs, const Block& output) override;
+
+  void SetGain(float gain) { m_gain = gain; }
+
+ private:
+  float m_gain;
+  const uint32_t m_channels;
+};
+
+/**
+ * \brief Sums its inputs
+ *
+ * Mono inputs are added to every output channel. Inputs with fewer channels
+ * than the output otherwise only reach the first ones.
+ */
+class MixerNode : public Node {
+ public:
+  explicit MixerNode(uint32_t channels = 1) : m_channels(channels) {}
+
+  [[nodiscard]] uint32_t Channels() const override { return m_channels; }
+
+  void Process(std::span<const Block> inputs, const Block& output) override;
+
+ private:
+  const uint32_t m_channels;
+};
+
+}  // namespace dsp
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_DSP_NODES_HPP_
@@ -0,0 +1,179 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_DSP_PROCESSING_GRAPH_HPP_
+#define _JLTX_INCLUDE_DSP_PROCESSING_GRAPH_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "audio/AudioSink.hpp"
+#include "containers/WorkStealingDeque.hpp"
+#include "util/Metrics.hpp"
+#include "util/ThreadPool.hpp"
+
+namespace jltx {
+namespace dsp {
+
+/** \brief One block of planar audio: channels runs of frames samples */
+struct Block {
+  float* data = nullptr;
+  uint32_t channels = 0;
+  uint32_t frames = 0;
+
+  [[nodiscard]] float* Channel(uint32_t channel) const {
+    return data + std::size_t{channel} * frames;
+  }
+};
+
+/**
+ * \brief Processing stage of a ProcessingGraph
+ *
+ * Nodes of independent branches run concurrently, so a node must only touch
+ * its own state and its blocks.
+ */
+class Node {
+ public:
+  virtual ~Node() = default;
+
+  /** \return Number of output channels, fixed for the life of the node */
+  [[nodiscard]] virtual uint32_t Channels() const { return 1; }
+
+  /**
+   * \brief Compute one block
+   *
+   * \param inputs Outputs of the input nodes, in the order given to
+   * ProcessingGraph::Add(). They must not be written.
+   * \param output Block to fill completely. Its previous contents are
+   * undefined, as buffers are shared between nodes.
+   */
+  virtual void Process(std::span<const Block> inputs, const Block& output) = 0;
+};
+
+/**
+ * \brief Directed acyclic graph of nodes processed one block at a time
+ *
+ * Nodes can only take inputs from nodes added before them, which keeps the
+ * graph acyclic and makes the insertion order a valid sequential schedule.
+ *
+ * Compile() preallocates every buffer. A node's output buffer is reused by a
+ * later node only when that node depends on the owner and on all of the
+ * owner's consumers, so the sharing is safe under any parallel schedule.
+ *
+ * With a ThreadPool, Process() runs every node as soon as its inputs are
+ * ready. Each worker keeps the nodes it unblocks in its own deque and steals
+ * from the others when it runs dry. The processing time of every block is
+ * recorded in the dsp.graph.block_ns histogram.
+ */
+class ProcessingGraph {
+ public:
+  using NodeId = uint32_t;
+  static constexpr NodeId INVALID_NODE = UINT32_MAX;
+
+  /** \param block_frames Frames per block for every node */
+  explicit ProcessingGraph(uint32_t block_frames);
+
+  ProcessingGraph(const ProcessingGraph&) = delete;
+  ProcessingGraph& operator=(const ProcessingGraph&) = delete;
+
+  /**
+   * \brief Add a node fed by existing nodes
+   *
+   * \return Id of the node, INVALID_NODE if an input does not exist
+   */
+  NodeId Add(std::unique_ptr<Node> node, std::vector<NodeId> inputs = {});
+
+  /**
+   * \brief Assign and allocate the buffers and prepare the schedule
+   *
+   * Needed after adding nodes and before processing.
+   *
+   * \param output Node whose blocks are the result of the graph
+   * \return false if output does not exist
+   */
+  bool Compile(NodeId output);
+
+  /** \brief Compute one block, in parallel if a pool is given */
+  void Process(ThreadPool* pool = nullptr);
+
+  /** \return Output block of the last Process() */
+  [[nodiscard]] const Block& Output() const;
+
+  /**
+   * \brief Process blocks and send the output, interleaved, to a sink
+   *
+   * The last block is processed whole but only sent up to frames.
+   *
+   * \return Frames accepted by the sink, 0 if the channel counts differ
+   */
+  uint64_t Render(audio::AudioSink& sink, uint64_t frames,
+                  ThreadPool* pool = nullptr);
+
+  [[nodiscard]] std::size_t Size() const { return m_nodes.size(); }
+
+  [[nodiscard]] uint32_t BlockFrames() const { return m_block_frames; }
+
+  /** \return Number of distinct buffers after Compile() */
+  [[nodiscard]] std::size_t BufferCount() const { return m_buffer_count; }
+
+ private:
+  struct Entry {
+    std::unique_ptr<Node> node;
+    std::vector<NodeId> inputs;
+    std::vector<NodeId> consumers;
+    Block output;
+    std::size_t first_input = 0;  // In m_input_blocks
+  };
+
+  const uint32_t m_block_frames;
+  std::vector<Entry> m_nodes;
+  NodeId m_output = INVALID_NODE;
+  bool m_compiled = false;
+
+  std::vector<float> m_storage;
+  std::size_t m_buffer_count = 0;
+  std::vector<Block> m_input_blocks;
+  std::vector<float> m_interleaved;
+  std::vector<const float*> m_planes;
+
+  // Parallel schedule
+  std::vector<NodeId> m_sources;
+  std::unique_ptr<std::atomic<uint32_t>[]> m_pending;
+  std::atomic<std::size_t> m_remaining{0};
+  std::vector<std::unique_ptr<WorkStealingDeque<NodeId>>> m_deques;
+
+  metrics::Histogram& m_block_time;
+
+  void Run(NodeId id);
+  void WorkerLoop(std::size_t worker);
+};
+
+}  // namespace dsp
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_DSP_PROCESSING_GRAPH_HPP_
@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_DSP_TONE_SCHEDULER_HPP_
+#define _JLTX_INCLUDE_DSP_TONE_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+
+namespace jltx {
+namespace dsp {
+
+/** \brief Tone change taking effect on a given sample */
+struct ToneEvent {
+  uint64_t sample;  // Counted from the first sample rendered
+  float frequency;  // Hz, in [0, sample rate)
+  float amplitude;
+};
+
+/**
+ * \brief Renders a timeline of tone changes, such as DTMF digits, FSK symbols
+ * or frequency hops
+ *
+ * Each event takes effect exactly on its sample, whatever the block
+ * boundaries. The phase carries over from one tone to the next, so switches
+ * are continuous, without clicks. The output is the same as an NCO whose
+ * SetFrequency() is called on those samples.
+ *
+ * Between events whole runs go through RenderSine(), with no per-sample check
+ * for events. The phase step of each event is computed when it is scheduled,
+ * so applying it while rendering is two stores.
+ *
+ * The output is silent until the first event.
+ */
+template <uint8_t bit_depth>
+class ToneScheduler {
+ public:
+  ToneScheduler(float sample_rate, const SineLUT<bit_depth>& table)
+      : m_table(table), m_sample_rate(sample_rate) {}
+
+  /**
+   * \brief Append an event to the timeline
+   *
+   * \return false if the event is before the last one scheduled or before
+   * the next sample to render, or if its frequency is outside
+   * [0, sample rate)
+   */
+  bool Schedule(const ToneEvent& event) {
+    const uint64_t earliest = m_events.size() > m_next
+                                  ? std::max(m_events.back().sample, m_position)
+                                  : m_position;
+    // Written so that NaN is rejected too
+    if (event.sample < earliest ||
+        !(event.frequency >= 0.0f && event.frequency < m_sample_rate)) {
+      return false;
+    }
+    if (m_events.size() == m_events.capacity() && m_next > 0) {
+      // Drop the events already applied rather than grow
+      m_events.erase(m_events.begin(),
+                     m_events.begin() + static_cast<std::ptrdiff_t>(m_next));
+      m_next = 0;
+    }
+    m_events.push_back(
+        {event.sample,
+         NCO<bit_depth>::PhaseDelta(event.frequency, m_sample_rate),
+         event.amplitude});
+    return true;
+  }
+
+  /** \brief Schedule() every event, stop at the first rejected one */
+  bool Schedule(std::span<const ToneEvent> events) {
+    return std::all_of(events.begin(), events.end(),
+                       [this](const ToneEvent& e) { return Schedule(e); });
+  }
+
+  /** \brief Render the next out.size() samples */
+  void Render(std::span<float> out) {
+    // The state stays in registers: the output stores could alias members
+    const float* table = m_table.Data();
+    const Step* events = m_events.data();
+    const std::size_t count = m_events.size();
+    std::size_t next = m_next;
+    uint64_t position = m_position;
+    uint32_t phase = m_phase;
+    uint32_t delta = m_delta;
+    float amplitude = m_amplitude;
+
+    std::size_t done = 0;
+    while (done < out.size()) {
+      while (next < count && events[next].sample <= position) {
+        delta = events[next].delta;
+        amplitude = events[next].amplitude;
+        ++next;
+      }
+      std::size_t run = out.size() - done;
+      if (next < count) {
+        run = static_cast<std::size_t>(
+            std::min<uint64_t>(run, events[next].sample - position));
+      }
+      float* dst = out.data() + done;
+      if (run < SHORT_RUN && done + SHORT_RUN <= out.size()) {
+        // Always SHORT_RUN samples, so the work does not branch on the run
+        // length. The extra samples are overwritten by the next runs.
+        for (uint32_t i = 0; i < SHORT_RUN; ++i) {
+          dst[i] = amplitude * table[(phase + i * delta) >> SHIFT];
+        }
+      } else {
+        RenderSine(table, SHIFT, phase, delta, amplitude, dst, run);
+      }
+      phase += static_cast<uint32_t>(run) * delta;
+      done += run;
+      position += run;
+    }
+
+    m_next = next;
+    m_position = position;
+    m_phase = phase;
+    m_delta = delta;
+    m_amplitude = amplitude;
+  }
+
+  /** \return Index of the next sample to render */
+  [[nodiscard]] uint64_t Position() const { return m_position; }
+
+  /** \return Number of events not reached yet */
+  [[nodiscard]] std::size_t Pending() const {
+    return m_events.size() - m_next;
+  }
+
+  /** \brief Drop the events not reached yet, keep the current tone */
+  void Clear() {
+    m_events.clear();
+    m_next = 0;
+  }
+
+ private:
+  static constexpr uint32_t SHIFT = NCO<bit_depth>::SHIFT;
+  static constexpr uint32_t SHORT_RUN = 8;
+
+  struct Step {
+    uint64_t sample;
+    uint32_t delta;
+    float amplitude;
+  };
+
+  const SineLUT<bit_depth>& m_table;
+  const float m_sample_rate;
+
+  uint32_t m_phase = 0;
+  uint32_t m_delta = 0;
+  float m_amplitude = 0.0f;
+  uint64_t m_position = 0;
+  std::vector<Step> m_events;
+  std::size_t m_next = 0;  // First event not applied yet
+};
+
+}  // namespace dsp
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_DSP_TONE_SCHEDULER_HPP_
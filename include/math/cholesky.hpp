@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_MATH_CHOLESKY_HPP_
+#define _JLTX_INCLUDE_MATH_CHOLESKY_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace jltx {
+namespace math {
+
+/**
+ * @brief Dot product of two contiguous arrays
+ *
+ * Uses four independent accumulators so that the loop has no single
+ * dependency chain and can be vectorized without reassociating the sum.
+ */
+template <typename T>
+T Dot(const T* a, const T* b, std::size_t n) {
+  T acc[4] = {0, 0, 0, 0};
+  std::size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    acc[0] += a[k] * b[k];
+    acc[1] += a[k + 1] * b[k + 1];
+    acc[2] += a[k + 2] * b[k + 2];
+    acc[3] += a[k + 3] * b[k + 3];
+  }
+  for (; k < n; ++k) {
+    acc[0] += a[k] * b[k];
+  }
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+/**
+ * @brief In-place Cholesky factorization A = L * L^T
+ *
+ * Meant for the small dense systems of least-squares solvers. Only the lower
+ * triangle of the row-major matrix is read; on return it holds L. The upper
+ * triangle is left untouched.
+ *
+ * @tparam n Matrix dimension
+ * @param a Symmetric positive definite n x n matrix in row-major order
+ * @return false if the matrix is not positive definite
+ */
+template <typename T, std::size_t n>
+bool CholeskyDecompose(std::array<T, n * n>& a) {
+  for (std::size_t i = 0; i < n; ++i) {
+    T* row_i = &a[i * n];
+    for (std::size_t j = 0; j <= i; ++j) {
+      const T* row_j = &a[j * n];
+      const T sum = row_i[j] - Dot(row_i, row_j, j);
+      if (i == j) {
+        if (!(sum > 0)) {
+          return false;
+        }
+        row_i[i] = std::sqrt(sum);
+      } else {
+        row_i[j] = sum / row_j[j];
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Solve L * L^T * x = b in place for a factorized matrix
+ *
+ * @param l Factor computed by CholeskyDecompose()
+ * @param b Right-hand side; holds the solution x on return
+ */
+template <typename T, std::size_t n>
+void CholeskySolve(const std::array<T, n * n>& l, std::array<T, n>& b) {
+  // Forward substitution: L * z = b
+  for (std::size_t i = 0; i < n; ++i) {
+    b[i] = (b[i] - Dot(&l[i * n], b.data(), i)) / l[i * n + i];
+  }
+
+  // Backward substitution: L^T * x = z
+  for (std::size_t i = n; i-- > 0;) {
+    T sum = b[i];
+    for (std::size_t k = i + 1; k < n; ++k) {
+      sum -= l[k * n + i] * b[k];
+    }
+    b[i] = sum / l[i * n + i];
+  }
+}
+
+}  // namespace math
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_MATH_CHOLESKY_HPP_
@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_MEMORY_ALIGNED_BLOCK_HPP_
+#define _JLTX_INCLUDE_MEMORY_ALIGNED_BLOCK_HPP_
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace jltx {
+namespace memory {
+
+/** Size of a cache line, also enough alignment for any SIMD load */
+inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/** \return value rounded up to a multiple of alignment, a power of 2 */
+constexpr std::size_t AlignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Owning handle of an aligned array
+ *
+ * Starts on a cache line by default, so it can be loaded with aligned SIMD
+ * instructions and does not share a line with other data. The elements are
+ * value-initialized. Movable, not copyable.
+ *
+ * @tparam T Trivial element type, such as float
+ */
+template <typename T, std::size_t alignment = CACHE_LINE_SIZE>
+  requires std::is_trivial_v<T> && (alignment >= alignof(T)) &&
+           ((alignment & (alignment - 1)) == 0)
+class AlignedBlock {
+ public:
+  AlignedBlock() = default;
+
+  explicit AlignedBlock(std::size_t size)
+      : m_data(size > 0 ? static_cast<T*>(::operator new(
+                              AlignUp(size * sizeof(T), alignment),
+                              std::align_val_t{alignment}))
+                        : nullptr),
+        m_size(size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      m_data[i] = T{};
+    }
+  }
+
+  ~AlignedBlock() { Release(); }
+
+  AlignedBlock(AlignedBlock&& other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)) {}
+
+  AlignedBlock& operator=(AlignedBlock&& other) noexcept {
+    if (this != &other) {
+      Release();
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+  }
+
+  AlignedBlock(const AlignedBlock&) = delete;
+  AlignedBlock& operator=(const AlignedBlock&) = delete;
+
+  [[nodiscard]] T* data() { return m_data; }
+  [[nodiscard]] const T* data() const { return m_data; }
+  [[nodiscard]] std::size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+
+  [[nodiscard]] T* begin() { return m_data; }
+  [[nodiscard]] T* end() { return m_data + m_size; }
+  [[nodiscard]] const T* begin() const { return m_data; }
+  [[nodiscard]] const T* end() const { return m_data + m_size; }
+
+  T& operator[](std::size_t i) { return m_data[i]; }
+  const T& operator[](std::size_t i) const { return m_data[i]; }
+
+  [[nodiscard]] std::span<T> Span() { return {m_data, m_size}; }
+  [[nodiscard]] std::span<const T> Span() const { return {m_data, m_size}; }
+
+ private:
+  T* m_data = nullptr;
+  std::size_t m_size = 0;
+
+  void Release() {
+    if (m_data != nullptr) {
+      ::operator delete(m_data, std::align_val_t{alignment});
+      m_data = nullptr;
+      m_size = 0;
+    }
+  }
+};
+
+}  // namespace memory
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_MEMORY_ALIGNED_BLOCK_HPP_
@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_MEMORY_ARENA_HPP_
+#define _JLTX_INCLUDE_MEMORY_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "memory/AlignedBlock.hpp"
+
+namespace jltx {
+namespace memory {
+
+/**
+ * @brief Monotonic bump allocator
+ *
+ * Allocation is a pointer increment into the current chunk. Memory is only
+ * reclaimed all at once by Reset(), which keeps the chunks for the next round,
+ * so a loop that resets the arena once per block or per record stops calling
+ * malloc after its first iterations. std::pmr::monotonic_buffer_resource
+ * instead gives its chunks back on release().
+ *
+ * Not thread-safe: use one arena per thread.
+ */
+class MonotonicArena {
+ public:
+  /** @param chunk_size Bytes per chunk. Larger requests get their own. */
+  explicit MonotonicArena(std::size_t chunk_size = 64 * 1024);
+  ~MonotonicArena();
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  /** \return size bytes aligned to alignment, a power of 2 */
+  [[nodiscard]] void* Allocate(std::size_t size,
+                               std::size_t alignment = alignof(
+                                   std::max_align_t)) {
+    const auto base = reinterpret_cast<uintptr_t>(m_chunk);
+    const std::size_t offset = AlignUp(base + m_offset, alignment) - base;
+    if (offset + size <= m_capacity) {
+      m_offset = offset + size;
+      return m_chunk + offset;
+    }
+    return AllocateSlow(size, alignment);
+  }
+
+  /** \brief Forget every allocation, keeping the memory */
+  void Reset();
+
+  /** \return Bytes handed out since the last Reset() */
+  [[nodiscard]] std::size_t BytesUsed() const;
+
+  /** \return Bytes held from the system */
+  [[nodiscard]] std::size_t BytesReserved() const;
+
+ private:
+  struct Chunk {
+    std::byte* data;
+    std::size_t size;
+  };
+
+  const std::size_t m_chunk_size;
+  std::vector<Chunk> m_chunks;
+  std::size_t m_current = 0;  // Index of m_chunk in m_chunks
+  std::byte* m_chunk = nullptr;
+  std::size_t m_capacity = 0;
+  std::size_t m_offset = 0;
+  std::size_t m_used_before = 0;  // In the chunks before the current one
+
+  void* AllocateSlow(std::size_t size, std::size_t alignment);
+};
+
+/**
+ * @brief std::pmr adapter of a MonotonicArena
+ *
+ * Deallocation does nothing, the memory comes back on MonotonicArena::Reset().
+ * Lets std::pmr containers and strings allocate from the arena.
+ */
+class ArenaResource : public std::pmr::memory_resource {
+ public:
+  explicit ArenaResource(MonotonicArena& arena) : m_arena(arena) {}
+
+ private:
+  MonotonicArena& m_arena;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    return m_arena.Allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* /*p*/, std::size_t /*bytes*/,
+                     std::size_t /*alignment*/) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    const auto* arena = dynamic_cast<const ArenaResource*>(&other);
+    return arena != nullptr && &arena->m_arena == &m_arena;
+  }
+};
+
+}  // namespace memory
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_MEMORY_ARENA_HPP_
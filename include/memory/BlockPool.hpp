@@ -0,0 +1,220 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_MEMORY_BLOCK_POOL_HPP_
+#define _JLTX_INCLUDE_MEMORY_BLOCK_POOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "memory/AlignedBlock.hpp"
+
+namespace jltx {
+namespace memory {
+
+/**
+ * @brief Lock-free pool of fixed-size blocks
+ *
+ * All blocks are carved out of one aligned region at construction, so
+ * allocation never calls malloc. Free blocks sit on a lock-free stack shared
+ * by every thread. Each thread also keeps a small cache of blocks for each
+ * of the last 8 pools it used, so most Allocate()/Free() pairs touch no
+ * shared cache line.
+ * The cache is moved to the shared stack in batches when it overflows and
+ * when the thread exits.
+ *
+ * Blocks may be freed by a different thread than the one that allocated
+ * them. A thread's cache can hold blocks that no other thread can take, so
+ * Allocate() may fail a little before every block is in use; size the pool
+ * with some headroom per thread.
+ */
+class BlockPool {
+ public:
+  /**
+   * @param block_size Usable bytes per block
+   * @param block_count Number of blocks
+   * @param alignment Alignment of every block, a power of 2
+   */
+  BlockPool(std::size_t block_size, std::size_t block_count,
+            std::size_t alignment = CACHE_LINE_SIZE);
+  ~BlockPool();
+
+  BlockPool(const BlockPool&) = delete;
+  BlockPool& operator=(const BlockPool&) = delete;
+
+  /** \return A block, nullptr if none is left */
+  [[nodiscard]] void* Allocate();
+
+  /** \brief Return a block from Allocate(). nullptr is ignored. */
+  void Free(void* block);
+
+  /** \return true if block points into this pool's blocks */
+  [[nodiscard]] bool Owns(const void* block) const;
+
+  [[nodiscard]] std::size_t BlockSize() const { return m_block_size; }
+  [[nodiscard]] std::size_t Alignment() const { return m_alignment; }
+  [[nodiscard]] std::size_t Capacity() const { return m_count; }
+
+  /**
+   * @brief Owning handle of a block of T, returned to the pool on
+   * destruction
+   */
+  template <typename T>
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(BlockPool* pool, void* block)
+        : m_pool(pool), m_data(static_cast<T*>(block)) {}
+    ~Handle() { Reset(); }
+
+    Handle(Handle&& other) noexcept
+        : m_pool(std::exchange(other.m_pool, nullptr)),
+          m_data(std::exchange(other.m_data, nullptr)) {}
+
+    Handle& operator=(Handle&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_data = std::exchange(other.m_data, nullptr);
+      }
+      return *this;
+    }
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    [[nodiscard]] T* data() const { return m_data; }
+    /** Number of T that fit in the block */
+    [[nodiscard]] std::size_t size() const {
+      return m_data ? m_pool->BlockSize() / sizeof(T) : 0;
+    }
+    explicit operator bool() const { return m_data != nullptr; }
+    T& operator[](std::size_t i) const { return m_data[i]; }
+
+    void Reset() {
+      if (m_data != nullptr) {
+        m_pool->Free(m_data);
+        m_data = nullptr;
+      }
+    }
+
+   private:
+    BlockPool* m_pool = nullptr;
+    T* m_data = nullptr;
+  };
+
+  /** \return Handle of a new block, empty if the pool is exhausted */
+  template <typename T>
+  [[nodiscard]] Handle<T> Acquire() {
+    static_assert(std::is_trivial_v<T>);
+    return Handle<T>(this, Allocate());
+  }
+
+  /** Blocks a thread keeps for itself before returning half of them */
+  static constexpr uint32_t CACHE_BLOCKS = 32;
+
+ private:
+  static constexpr uint32_t NIL = UINT32_MAX;
+
+  const std::size_t m_block_size;
+  const std::size_t m_alignment;
+  const std::size_t m_stride;
+  const uint32_t m_count;
+  const uint64_t m_id;
+  std::byte* m_storage;
+
+  // Free stack: index of the top block in the low half, a counter bumped on
+  // every change in the high half so a stale compare-exchange fails (ABA)
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_head;
+  std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+
+  struct ThreadCache;
+  friend struct ThreadCache;
+
+  std::byte* Block(uint32_t index) const {
+    return m_storage + std::size_t{index} * m_stride;
+  }
+  uint32_t Index(const void* block) const {
+    return static_cast<uint32_t>(
+        (static_cast<const std::byte*>(block) - m_storage) / m_stride);
+  }
+
+  /** Push blocks on the free stack */
+  void Give(const uint32_t* blocks, uint32_t count);
+  /** Pop up to max blocks into out, return how many */
+  uint32_t Take(uint32_t* out, uint32_t max);
+};
+
+/**
+ * @brief std::pmr adapter of a BlockPool
+ *
+ * Requests that fit in a block come from the pool, anything else, or any
+ * request made while the pool is exhausted, from the upstream resource.
+ */
+class PoolResource : public std::pmr::memory_resource {
+ public:
+  explicit PoolResource(
+      BlockPool& pool,
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+      : m_pool(pool), m_upstream(upstream) {}
+
+ private:
+  BlockPool& m_pool;
+  std::pmr::memory_resource* m_upstream;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (bytes <= m_pool.BlockSize() && alignment <= m_pool.Alignment()) {
+      if (void* block = m_pool.Allocate()) {
+        return block;
+      }
+    }
+    return m_upstream->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    if (m_pool.Owns(p)) {
+      m_pool.Free(p);
+    } else {
+      m_upstream->deallocate(p, bytes, alignment);
+    }
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    const auto* pool = dynamic_cast<const PoolResource*>(&other);
+    return pool != nullptr && &pool->m_pool == &m_pool &&
+           pool->m_upstream == m_upstream;
+  }
+};
+
+}  // namespace memory
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_MEMORY_BLOCK_POOL_HPP_
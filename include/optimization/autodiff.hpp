@@ -0,0 +1,377 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_OPTIMIZATION_AUTODIFF_HPP_
+#define _JLTX_INCLUDE_OPTIMIZATION_AUTODIFF_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "optimization/gradient.hpp"
+
+namespace jltx {
+namespace opt {
+
+/**
+ * @brief Call f(i) for every lane i in [0, N)
+ *
+ * Expands to straight-line code, so the lanes of a Dual stay in registers and
+ * can be vectorized without relying on the loop unrolling heuristics of the
+ * optimization level in use.
+ */
+template <std::size_t N, typename F>
+inline void ForEachLane(F&& f) {
+  [&]<std::size_t... i>(std::index_sequence<i...>) {
+    (f(i), ...);
+  }(std::make_index_sequence<N>{});
+}
+
+/**
+ * @brief Dual number for forward-mode automatic differentiation
+ *
+ * Carries a value together with its partial derivatives with respect to N
+ * variables. The derivatives are a fixed-size array, so arithmetic never
+ * allocates and every operation is a short loop over N lanes that the
+ * compiler can vectorize.
+ *
+ * @tparam T Number type
+ * @tparam N Number of variables
+ */
+template <typename T, std::size_t N>
+struct Dual {
+  T value{};
+  std::array<T, N> grad{};
+
+  Dual() = default;
+
+  /** Constant: all derivatives are zero */
+  Dual(T v) : value(v) {}
+
+  /** Independent variable number index, with derivative 1 in its own lane */
+  [[nodiscard]] static Dual Variable(T v, std::size_t index) {
+    Dual d(v);
+    d.grad[index] = 1;
+    return d;
+  }
+
+  Dual& operator+=(const Dual& other) {
+    value += other.value;
+    ForEachLane<N>([&](std::size_t i) {
+      grad[i] += other.grad[i];
+    });
+    return *this;
+  }
+
+  Dual& operator-=(const Dual& other) {
+    value -= other.value;
+    ForEachLane<N>([&](std::size_t i) {
+      grad[i] -= other.grad[i];
+    });
+    return *this;
+  }
+
+  Dual& operator*=(const Dual& other) {
+    ForEachLane<N>([&](std::size_t i) {
+      grad[i] = grad[i] * other.value + value * other.grad[i];
+    });
+    value *= other.value;
+    return *this;
+  }
+
+  Dual& operator/=(const Dual& other) {
+    const T inv = 1 / other.value;
+    const T quotient = value * inv;
+    ForEachLane<N>([&](std::size_t i) {
+      grad[i] = (grad[i] - quotient * other.grad[i]) * inv;
+    });
+    value = quotient;
+    return *this;
+  }
+};
+
+template <typename T, std::size_t N>
+Dual<T, N> operator-(const Dual<T, N>& a) {
+  Dual<T, N> r;
+  r.value = -a.value;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = -a.grad[i];
+  });
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator+(const Dual<T, N>& a, const Dual<T, N>& b) {
+  Dual<T, N> r;
+  r.value = a.value + b.value;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = a.grad[i] + b.grad[i];
+  });
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator-(const Dual<T, N>& a, const Dual<T, N>& b) {
+  Dual<T, N> r;
+  r.value = a.value - b.value;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = a.grad[i] - b.grad[i];
+  });
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator*(const Dual<T, N>& a, const Dual<T, N>& b) {
+  Dual<T, N> r;
+  r.value = a.value * b.value;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = a.grad[i] * b.value + a.value * b.grad[i];
+  });
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator/(const Dual<T, N>& a, const Dual<T, N>& b) {
+  const T inv = 1 / b.value;
+  Dual<T, N> r;
+  r.value = a.value * inv;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = (a.grad[i] - r.value * b.grad[i]) * inv;
+  });
+  return r;
+}
+
+// Mixed operations with constants skip the derivative products
+
+template <typename T, std::size_t N>
+Dual<T, N> operator+(const Dual<T, N>& a, T b) {
+  Dual<T, N> r = a;
+  r.value += b;
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator+(T a, const Dual<T, N>& b) {
+  return b + a;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator-(const Dual<T, N>& a, T b) {
+  Dual<T, N> r = a;
+  r.value -= b;
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator-(T a, const Dual<T, N>& b) {
+  Dual<T, N> r = -b;
+  r.value += a;
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator*(const Dual<T, N>& a, T b) {
+  Dual<T, N> r;
+  r.value = a.value * b;
+  ForEachLane<N>([&](std::size_t i) {
+    r.grad[i] = a.grad[i] * b;
+  });
+  return r;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator*(T a, const Dual<T, N>& b) {
+  return b * a;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator/(const Dual<T, N>& a, T b) {
+  return a * (1 / b);
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> operator/(T a, const Dual<T, N>& b) {
+  return Dual<T, N>(a) / b;
+}
+
+/** Apply the chain rule: f(a) with f'(a) = derivative */
+template <typename T, std::size_t N>
+Dual<T, N> Chain(const Dual<T, N>& a, T value, T derivative) {
+  Dual<T, N> result(value);
+  ForEachLane<N>([&](std::size_t i) {
+    result.grad[i] = derivative * a.grad[i];
+  });
+  return result;
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> sin(const Dual<T, N>& a) {
+  return Chain(a, std::sin(a.value), std::cos(a.value));
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> cos(const Dual<T, N>& a) {
+  return Chain(a, std::cos(a.value), -std::sin(a.value));
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> exp(const Dual<T, N>& a) {
+  const T e = std::exp(a.value);
+  return Chain(a, e, e);
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> log(const Dual<T, N>& a) {
+  return Chain(a, std::log(a.value), 1 / a.value);
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> sqrt(const Dual<T, N>& a) {
+  const T s = std::sqrt(a.value);
+  return Chain(a, s, 1 / (2 * s));
+}
+
+template <typename T, std::size_t N>
+Dual<T, N> pow(const Dual<T, N>& a, T exponent) {
+  return Chain(a, std::pow(a.value, exponent),
+               exponent * std::pow(a.value, exponent - 1));
+}
+
+/**
+ * @brief Least-squares problem with gradients from forward-mode automatic
+ * differentiation
+ *
+ * The derived class only provides the model as a template over the parameter
+ * type:
+ *
+ *   template <typename S>
+ *   S Evaluate(T x, const std::array<S, nparams>& w) const;
+ *
+ * Estimate, Error (mean squared error), Gradient and ErrorAndGradient are
+ * implemented on top of it. The gradient is computed in a single pass over
+ * the data by evaluating the model on Dual numbers that carry all nparams
+ * partial derivatives.
+ *
+ * @tparam Derived Class implementing Evaluate (CRTP)
+ */
+template <typename T, uint32_t nparams, typename Derived>
+struct AutoDiffProblem : public OptimizationProblem<T, nparams> {
+  using Param = Dual<T, nparams>;
+
+  std::vector<T> Estimate(const std::vector<T>& x,
+                          const std::array<T, nparams>& w) override {
+    std::vector<T> estimates(x.size());
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      estimates[n] = Model().Evaluate(x[n], w);
+    }
+    return estimates;
+  }
+
+  T Error(const std::vector<T>& x, const std::array<T, nparams>& w,
+          const std::vector<T>& y) override {
+    if (x.empty()) {
+      return 0;
+    }
+
+    T error = 0;
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const T residual = y[n] - Model().Evaluate(x[n], w);
+      error += residual * residual;
+    }
+    return error / static_cast<T>(x.size());
+  }
+
+  std::array<T, nparams> Gradient(const std::vector<T>& x,
+                                  const std::array<T, nparams>& w,
+                                  const std::vector<T>& y) override {
+    std::array<T, nparams> gradient{};
+    if (x.empty()) {
+      return gradient;
+    }
+
+    gradient = PartialGradient(std::span<const T>(x), w, std::span<const T>(y));
+    for (T& g : gradient) {
+      g /= static_cast<T>(x.size());
+    }
+    return gradient;
+  }
+
+  T ErrorAndGradient(const std::vector<T>& x, const std::array<T, nparams>& w,
+                     const std::vector<T>& y,
+                     std::array<T, nparams>& gradient) override {
+    gradient = {};
+    if (x.empty()) {
+      return 0;
+    }
+
+    const T squared_sum = ResidualSums(std::span<const T>(x), w,
+                                       std::span<const T>(y), gradient);
+    for (T& g : gradient) {
+      g /= static_cast<T>(x.size());
+    }
+    return squared_sum / static_cast<T>(x.size());
+  }
+
+  std::array<T, nparams> PartialGradient(std::span<const T> x,
+                                         const std::array<T, nparams>& w,
+                                         std::span<const T> y) override {
+    std::array<T, nparams> gradient{};
+    ResidualSums(x, w, y, gradient);
+    return gradient;
+  }
+
+ private:
+  const Derived& Model() const { return static_cast<const Derived&>(*this); }
+
+  // Adds the per-sample gradient terms to gradient and returns the sum of
+  // the squared residuals, both from the same Dual evaluation
+  T ResidualSums(std::span<const T> x, const std::array<T, nparams>& w,
+                 std::span<const T> y, std::array<T, nparams>& gradient) const {
+    std::array<Param, nparams> params;
+    for (uint32_t i = 0; i < nparams; ++i) {
+      params[i] = Param::Variable(w[i], i);
+    }
+
+    T squared_sum = 0;
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const Param estimate = Model().Evaluate(x[n], params);
+      const T residual = y[n] - estimate.value;
+      squared_sum += residual * residual;
+      const T factor = -2 * residual;
+      ForEachLane<nparams>([&](std::size_t i) {
+        gradient[i] += factor * estimate.grad[i];
+      });
+    }
+    return squared_sum;
+  }
+};
+
+}  // namespace opt
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_OPTIMIZATION_AUTODIFF_HPP_
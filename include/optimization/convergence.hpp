@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_OPTIMIZATION_CONVERGENCE_HPP_
+#define _JLTX_INCLUDE_OPTIMIZATION_CONVERGENCE_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace jltx {
+namespace opt {
+
+/** Reason why an iterative solver stopped */
+enum class SolveStatus {
+  GRADIENT_TOLERANCE,
+  LOSS_TOLERANCE,
+  MAX_ITERATIONS,
+  STEP_TOLERANCE,
+  LINE_SEARCH_FAILED,
+  STOPPED_BY_CALLBACK
+};
+
+template <typename T>
+struct ConvergenceCriteria {
+  uint32_t max_iterations = 100;
+
+  /** Stop when the euclidean norm of the gradient falls below this value */
+  T gradient_tolerance = static_cast<T>(1e-6);
+
+  /** Stop when |loss_prev - loss| <= tolerance * max(|loss_prev|, |loss|) */
+  T relative_loss_tolerance = static_cast<T>(1e-9);
+
+  /** Stop when the step is smaller than tolerance * (|w| + tolerance) */
+  T step_tolerance = static_cast<T>(1e-12);
+};
+
+/** Telemetry passed to the iteration callback after every iteration */
+template <typename T>
+struct IterationReport {
+  uint32_t iteration;
+  T loss;
+  T gradient_norm;
+  /** Euclidean length of the step taken */
+  T step;
+  /** Function evaluations so far, one per loss and gradient pair */
+  uint32_t evaluations;
+  /** Wall time since the start of Solve() */
+  std::chrono::duration<double> elapsed;
+};
+
+/** Return false to stop the solver */
+template <typename T>
+using IterationCallback = std::function<bool(const IterationReport<T>&)>;
+
+template <typename T, uint32_t nparams>
+struct SolveResult {
+  std::array<T, nparams> w;
+  T loss;
+  uint32_t iterations;
+  uint32_t evaluations;
+  SolveStatus status;
+};
+
+}  // namespace opt
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_OPTIMIZATION_CONVERGENCE_HPP_
@@ -25,14 +25,19 @@
 #ifndef _JLTX_INCLUDE_OPTIMIZATION_GRADIENT_HPP_
 #define _JLTX_INCLUDE_OPTIMIZATION_GRADIENT_HPP_
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <random>
+#include <span>
 #include <vector>
 
+#include "util/ThreadPool.hpp"
+
 namespace jltx {
 namespace opt {
 
@@ -47,22 +52,109 @@ struct OptimizationProblem {
   virtual std::array<T, nparams> Gradient(const std::vector<T>& x,
                                           const std::array<T, nparams>& w,
                                           const std::vector<T>& y) = 0;
+
+  /**
+   * @brief Error() and Gradient() at the same point
+   *
+   * The default implementation makes the two calls; problems that can get
+   * both from a single pass over the data should override it.
+   *
+   * @param gradient Set to the gradient
+   * @return The error
+   */
+  virtual T ErrorAndGradient(const std::vector<T>& x,
+                             const std::array<T, nparams>& w,
+                             const std::vector<T>& y,
+                             std::array<T, nparams>& gradient) {
+    gradient = Gradient(x, w, y);
+    return Error(x, w, y);
+  }
+
+  /**
+   * @brief Sum of the per-sample gradient terms over a contiguous shard of
+   * the data
+   *
+   * For an error that is a mean over the samples, the gradient of the whole
+   * data set is the sum of the partial gradients of its shards divided by the
+   * total number of samples. The default implementation copies the shard and
+   * calls Gradient(); problems should override it to avoid the copy.
+   */
+  virtual std::array<T, nparams> PartialGradient(
+      std::span<const T> x, const std::array<T, nparams>& w,
+      std::span<const T> y) {
+    std::array<T, nparams> gradient =
+        Gradient(std::vector<T>(x.begin(), x.end()), w,
+                 std::vector<T>(y.begin(), y.end()));
+    for (T& g : gradient) {
+      g *= static_cast<T>(x.size());
+    }
+    return gradient;
+  }
+
+  virtual ~OptimizationProblem() = default;
 };
 
+/**
+ * @brief Draw initial parameters uniformly from [-scale, scale]
+ *
+ * @param seed Seed of the random generator. The same seed always produces the
+ * same parameters.
+ * @param scale Half-width of the interval
+ */
+template <typename T, uint32_t nparams>
+std::array<T, nparams> RandomInitParams(uint64_t seed,
+                                        T scale = static_cast<T>(0.1)) {
+  std::mt19937_64 generator(seed);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  std::array<T, nparams> params;
+  for (T& w : params) {
+    w = static_cast<T>(distribution(generator)) * scale;
+  }
+  return params;
+}
+
 template <typename T, uint32_t nparams>
 class GradientSolver {
  public:
-  GradientSolver(OptimizationProblem<T, nparams>* problem, T alpha)
-      : m_problem(problem), m_alpha(alpha) {
-    std::srand(std::time(nullptr));
-  }
+  /** Default number of samples per shard when solving on a thread pool */
+  static constexpr std::size_t DEFAULT_SHARD_SIZE = 1 << 16;
+
+  /**
+   * @brief Create a fixed-step gradient descent solver
+   *
+   * @param problem Problem to solve
+   * @param alpha Step size
+   * @param pool Optional thread pool. If set, the gradient is evaluated in
+   * shards of shard_size samples on the pool and the partial gradients are
+   * reduced with a fixed pairwise tree, so the result does not depend on the
+   * number of threads.
+   * @param shard_size Number of samples per shard
+   */
+  GradientSolver(OptimizationProblem<T, nparams>* problem, T alpha,
+                 ThreadPool* pool = nullptr,
+                 std::size_t shard_size = DEFAULT_SHARD_SIZE)
+      : m_problem(problem),
+        m_alpha(alpha),
+        m_pool(pool),
+        m_shard_size(std::max<std::size_t>(1, shard_size)),
+        m_seed(static_cast<uint64_t>(std::time(nullptr))) {}
+
+  /** Seed the random initialization used by Solve() without initial params */
+  void SetSeed(uint64_t seed) { m_seed = seed; }
 
   std::array<T, nparams> Solve(uint32_t iterations, const std::vector<T>& x,
                                const std::vector<T>& y) {
-    std::array<T, nparams> w = GetRandomInitParams();
+    return Solve(iterations, x, y, GetRandomInitParams());
+  }
 
+  /** Solve starting from the given parameters */
+  std::array<T, nparams> Solve(uint32_t iterations, const std::vector<T>& x,
+                               const std::vector<T>& y,
+                               std::array<T, nparams> w) {
     for (uint32_t i = 0; i < iterations; ++i) {
-      auto grad = m_problem->Gradient(x, w, y);
+      auto grad = (m_pool != nullptr) ? ShardedGradient(x, w, y)
+                                      : m_problem->Gradient(x, w, y);
 
       // // Optionally print error
       // const T error = problem->Error(x, w, y);
@@ -84,63 +176,208 @@ class GradientSolver {
 
   T m_alpha;
 
+  ThreadPool* m_pool;
+  std::size_t m_shard_size;
+  std::vector<std::array<T, nparams>> m_partials;
+
+  uint64_t m_seed;
+
   std::array<T, nparams> GetRandomInitParams() {
-    std::array<T, nparams> params;
-    for (T& w : params) {
-      w = std::rand();
+    return RandomInitParams<T, nparams>(m_seed++);
+  }
+
+  std::array<T, nparams> ShardedGradient(const std::vector<T>& x,
+                                         const std::array<T, nparams>& w,
+                                         const std::vector<T>& y) {
+    const std::size_t size = x.size();
+    std::array<T, nparams> gradient{};
+    if (size == 0) {
+      return gradient;
+    }
+
+    const std::size_t num_shards = (size + m_shard_size - 1) / m_shard_size;
+    m_partials.resize(num_shards);
+
+    const std::span<const T> x_span(x);
+    const std::span<const T> y_span(y);
+    m_pool->ParallelFor(num_shards, [&](std::size_t shard) {
+      const std::size_t offset = shard * m_shard_size;
+      const std::size_t count = std::min(m_shard_size, size - offset);
+      m_partials[shard] = m_problem->PartialGradient(
+          x_span.subspan(offset, count), w, y_span.subspan(offset, count));
+    });
+
+    // Pairwise reduction with a fixed shape for reproducible results
+    for (std::size_t stride = 1; stride < num_shards; stride *= 2) {
+      for (std::size_t i = 0; i + stride < num_shards; i += 2 * stride) {
+        for (uint32_t k = 0; k < nparams; ++k) {
+          m_partials[i][k] += m_partials[i + stride][k];
+        }
+      }
+    }
+
+    for (uint32_t k = 0; k < nparams; ++k) {
+      gradient[k] = m_partials[0][k] / static_cast<T>(size);
     }
-    return params;
+    return gradient;
   }
 };
 
+/**
+ * @brief Least-squares fit of a polynomial w[0] + w[1] * x + ... + w[n-1] *
+ * x^(n-1) to the samples (x, y).
+ *
+ * The error is the mean squared error. Estimates are evaluated with Horner's
+ * scheme and the gradient is computed in a single fused pass over the data,
+ * streaming the powers of each sample instead of calling pow() for every
+ * coefficient.
+ */
 template <typename T, uint32_t nparams>
 struct PolynomicFitProblem : public OptimizationProblem<T, nparams> {
-  std::vector<T> Estimate(const std::vector<T>& x,
-                          const std::array<T, nparams>& w) override {
-    std::vector<T> estimates;
+  static_assert(nparams > 0, "A polynomial needs at least one coefficient");
 
-    for (uint32_t n = 0; n < x.size(); ++n) {
-      T estimate = 0;
-      for (uint32_t i = 0; i < nparams; ++i) {
-        estimate += w[i] * pow(x[n], i);
-      }
-      estimates.push_back(estimate);
+  /** Evaluate the polynomial at x using Horner's scheme */
+  [[nodiscard]] static T Evaluate(T x, const std::array<T, nparams>& w) {
+    T estimate = w[nparams - 1];
+    for (uint32_t i = nparams - 1; i-- > 0;) {
+      estimate = estimate * x + w[i];
     }
+    return estimate;
+  }
 
+  std::vector<T> Estimate(const std::vector<T>& x,
+                          const std::array<T, nparams>& w) override {
+    std::vector<T> estimates(x.size());
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      estimates[n] = Evaluate(x[n], w);
+    }
     return estimates;
   }
 
   T Error(const std::vector<T>& x, const std::array<T, nparams>& w,
           const std::vector<T>& y) override {
-    auto estimates = Estimate(x, w);
+    if (x.empty()) {
+      return 0;
+    }
+
     T error = 0;
-    for (uint32_t i = 0; i < x.size(); ++i) {
-      error += pow((y[i] - x[i]), 2) / x.size();
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const T residual = y[n] - Evaluate(x[n], w);
+      error += residual * residual;
     }
-    return error;
+    return error / static_cast<T>(x.size());
   }
 
   std::array<T, nparams> Gradient(const std::vector<T>& x,
                                   const std::array<T, nparams>& w,
                                   const std::vector<T>& y) override {
-    std::array<T, nparams> gradient;
+    std::array<T, nparams> gradient{};
+    if (x.empty()) {
+      return gradient;
+    }
+
+    gradient = PartialGradient(std::span<const T>(x), w, std::span<const T>(y));
+    for (T& g : gradient) {
+      g /= static_cast<T>(x.size());
+    }
+    return gradient;
+  }
 
-    std::vector<T> partial_terms;
-    std::vector<T> estimates = Estimate(x, w);
-    for (uint32_t n = 0; n < x.size(); ++n) {
-      partial_terms.push_back(-2 * (y[n] - estimates[n]));
+  T ErrorAndGradient(const std::vector<T>& x, const std::array<T, nparams>& w,
+                     const std::vector<T>& y,
+                     std::array<T, nparams>& gradient) override {
+    gradient = {};
+    if (x.empty()) {
+      return 0;
     }
 
-    for (uint32_t i = 0; i < nparams; ++i) {
-      T grad = 0;
-      for (uint32_t n = 0; n < x.size(); ++n) {
-        grad += partial_terms[n] * pow(x[i], n);
-      }
-      gradient[i] = grad;
+    T squared_sum = 0;
+    gradient = ResidualPowerSums<true>(x.data(), y.data(), x.size(), w,
+                                       &squared_sum);
+    const auto count = static_cast<T>(x.size());
+    for (T& g : gradient) {
+      g *= static_cast<T>(-2) / count;
     }
+    return squared_sum / count;
+  }
 
+  std::array<T, nparams> PartialGradient(std::span<const T> x,
+                                         const std::array<T, nparams>& w,
+                                         std::span<const T> y) override {
+    std::array<T, nparams> gradient =
+        ResidualPowerSums(x.data(), y.data(), x.size(), w);
+    for (T& g : gradient) {
+      g *= static_cast<T>(-2);
+    }
     return gradient;
   }
+
+ protected:
+  /** Number of samples processed side by side in the fused gradient pass */
+  static constexpr std::size_t LANES = 8;
+
+  /**
+   * @brief Compute sum(r[n] * x[n]^i) for every coefficient i, where r are the
+   * residuals y - estimate.
+   *
+   * Samples are processed in groups of LANES with one accumulator per lane so
+   * that the inner loops have no loop-carried dependencies and can be
+   * vectorized. Powers of x are streamed per group and never stored.
+   *
+   * @tparam with_squares Also add up r[n]^2 into *squared_sum
+   */
+  template <bool with_squares = false>
+  static std::array<T, nparams> ResidualPowerSums(
+      const T* x, const T* y, std::size_t count,
+      const std::array<T, nparams>& w, T* squared_sum = nullptr) {
+    std::array<std::array<T, LANES>, nparams> acc{};
+    std::array<T, LANES> squares{};
+
+    std::size_t n = 0;
+    for (; n + LANES <= count; n += LANES) {
+      std::array<T, LANES> residual;
+      std::array<T, LANES> power;
+      for (std::size_t l = 0; l < LANES; ++l) {
+        residual[l] = y[n + l] - Evaluate(x[n + l], w);
+        power[l] = 1;
+        if constexpr (with_squares) {
+          squares[l] += residual[l] * residual[l];
+        }
+      }
+      for (uint32_t i = 0; i < nparams; ++i) {
+        for (std::size_t l = 0; l < LANES; ++l) {
+          acc[i][l] += residual[l] * power[l];
+          power[l] *= x[n + l];
+        }
+      }
+    }
+
+    for (; n < count; ++n) {
+      const T residual = y[n] - Evaluate(x[n], w);
+      if constexpr (with_squares) {
+        squares[0] += residual * residual;
+      }
+      T power = 1;
+      for (uint32_t i = 0; i < nparams; ++i) {
+        acc[i][0] += residual * power;
+        power *= x[n];
+      }
+    }
+
+    std::array<T, nparams> sums{};
+    for (uint32_t i = 0; i < nparams; ++i) {
+      for (std::size_t l = 0; l < LANES; ++l) {
+        sums[i] += acc[i][l];
+      }
+    }
+    if constexpr (with_squares) {
+      *squared_sum = 0;
+      for (const T square : squares) {
+        *squared_sum += square;
+      }
+    }
+    return sums;
+  }
 };
 
 }  // namespace opt
@@ -0,0 +1,392 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_OPTIMIZATION_LBFGS_HPP_
+#define _JLTX_INCLUDE_OPTIMIZATION_LBFGS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "optimization/convergence.hpp"
+#include "optimization/gradient.hpp"
+
+namespace jltx {
+namespace opt {
+
+enum class LineSearchMethod {
+  /** Backtracking until the sufficient decrease (Armijo) condition holds */
+  ARMIJO,
+  /** Bracketing and zoom until the strong Wolfe conditions hold */
+  WOLFE
+};
+
+template <typename T>
+struct LineSearchOptions {
+  LineSearchMethod method = LineSearchMethod::WOLFE;
+
+  /** Sufficient decrease constant */
+  T c1 = static_cast<T>(1e-4);
+
+  /** Curvature constant for the strong Wolfe conditions */
+  T c2 = static_cast<T>(0.9);
+
+  /** Maximum number of function evaluations per line search */
+  uint32_t max_evaluations = 20;
+};
+
+/**
+ * @brief Limited-memory BFGS solver with a line search
+ *
+ * Builds a quasi-Newton search direction from the last `history` parameter
+ * and gradient differences and stops as soon as one of the convergence
+ * criteria is met, instead of running a fixed number of fixed-size steps.
+ *
+ * @tparam history Number of correction pairs kept
+ */
+template <typename T, uint32_t nparams, std::size_t history = 8>
+class LbfgsSolver {
+ public:
+  using Params = std::array<T, nparams>;
+
+  LbfgsSolver(OptimizationProblem<T, nparams>* problem,
+              ConvergenceCriteria<T> criteria = {},
+              LineSearchOptions<T> line_search = {})
+      : m_problem(problem), m_criteria(criteria), m_line_search(line_search) {}
+
+  /** Set a callback that receives the telemetry of every iteration */
+  void SetCallback(IterationCallback<T> callback) {
+    m_callback = std::move(callback);
+  }
+
+  SolveResult<T, nparams> Solve(const std::vector<T>& x,
+                                const std::vector<T>& y, Params w) {
+    const auto start = std::chrono::steady_clock::now();
+    m_evaluations = 0;
+    m_num_pairs = 0;
+    m_newest = 0;
+
+    Point current;
+    current.w = w;
+    Evaluate(x, y, current);
+
+    SolveResult<T, nparams> result{current.w, current.loss, 0, m_evaluations,
+                                   SolveStatus::MAX_ITERATIONS};
+    if (Norm(current.grad) <= m_criteria.gradient_tolerance) {
+      result.status = SolveStatus::GRADIENT_TOLERANCE;
+      return result;
+    }
+
+    for (uint32_t iteration = 1; iteration <= m_criteria.max_iterations;
+         ++iteration) {
+      Params direction = Direction(current.grad);
+      T slope = Dot(current.grad, direction);
+      if (!(slope < 0)) {
+        // Not a descent direction: drop the history and use steepest descent
+        m_num_pairs = 0;
+        direction = Direction(current.grad);
+        slope = Dot(current.grad, direction);
+      }
+
+      // Without curvature information the first step is normalized
+      const T initial_step =
+          (m_num_pairs == 0) ? (1 / std::max(Norm(direction), Epsilon())) : 1;
+
+      Point next;
+      T step;
+      if (!LineSearch(x, y, current, direction, slope, initial_step, next,
+                      step)) {
+        result.status = SolveStatus::LINE_SEARCH_FAILED;
+        break;
+      }
+
+      UpdateHistory(current, next);
+
+      const T previous_loss = current.loss;
+      const T step_length = step * Norm(direction);
+      const T w_norm = Norm(current.w);
+      current = next;
+      result.w = current.w;
+      result.loss = current.loss;
+      result.iterations = iteration;
+      result.evaluations = m_evaluations;
+
+      const T gradient_norm = Norm(current.grad);
+      if (m_callback) {
+        const IterationReport<T> report{
+            iteration,
+            current.loss,
+            gradient_norm,
+            step_length,
+            m_evaluations,
+            std::chrono::steady_clock::now() - start};
+        if (!m_callback(report)) {
+          result.status = SolveStatus::STOPPED_BY_CALLBACK;
+          break;
+        }
+      }
+
+      if (gradient_norm <= m_criteria.gradient_tolerance) {
+        result.status = SolveStatus::GRADIENT_TOLERANCE;
+        break;
+      }
+      if (step_length <= m_criteria.step_tolerance *
+                             (w_norm + m_criteria.step_tolerance)) {
+        result.status = SolveStatus::STEP_TOLERANCE;
+        break;
+      }
+      const T scale = std::max(std::abs(previous_loss), std::abs(current.loss));
+      if (std::abs(previous_loss - current.loss) <=
+          m_criteria.relative_loss_tolerance * scale) {
+        result.status = SolveStatus::LOSS_TOLERANCE;
+        break;
+      }
+    }
+
+    result.evaluations = m_evaluations;
+    return result;
+  }
+
+ private:
+  struct Point {
+    Params w;
+    T loss;
+    Params grad;
+  };
+
+  OptimizationProblem<T, nparams>* m_problem;
+  ConvergenceCriteria<T> m_criteria;
+  LineSearchOptions<T> m_line_search;
+  IterationCallback<T> m_callback;
+
+  uint32_t m_evaluations = 0;
+
+  // Ring of correction pairs s = w_next - w, q = grad_next - grad
+  std::array<Params, history> m_s;
+  std::array<Params, history> m_q;
+  std::array<T, history> m_rho;
+  std::size_t m_num_pairs = 0;
+  std::size_t m_newest = 0;
+
+  static constexpr T Epsilon() { return std::numeric_limits<T>::epsilon(); }
+
+  static T Dot(const Params& a, const Params& b) {
+    T dot = 0;
+    for (uint32_t i = 0; i < nparams; ++i) {
+      dot += a[i] * b[i];
+    }
+    return dot;
+  }
+
+  static T Norm(const Params& a) { return std::sqrt(Dot(a, a)); }
+
+  void Evaluate(const std::vector<T>& x, const std::vector<T>& y, Point& p) {
+    p.loss = m_problem->ErrorAndGradient(x, p.w, y, p.grad);
+    ++m_evaluations;
+  }
+
+  /** Two-loop recursion: approximate -H * grad */
+  Params Direction(const Params& grad) const {
+    Params q = grad;
+    std::array<T, history> alpha;
+
+    for (std::size_t k = 0; k < m_num_pairs; ++k) {
+      const std::size_t j = (m_newest + history - k) % history;
+      alpha[j] = m_rho[j] * Dot(m_s[j], q);
+      for (uint32_t i = 0; i < nparams; ++i) {
+        q[i] -= alpha[j] * m_q[j][i];
+      }
+    }
+
+    if (m_num_pairs > 0) {
+      const T gamma = Dot(m_s[m_newest], m_q[m_newest]) /
+                      Dot(m_q[m_newest], m_q[m_newest]);
+      for (T& value : q) {
+        value *= gamma;
+      }
+    }
+
+    for (std::size_t k = m_num_pairs; k-- > 0;) {
+      const std::size_t j = (m_newest + history - k) % history;
+      const T beta = m_rho[j] * Dot(m_q[j], q);
+      for (uint32_t i = 0; i < nparams; ++i) {
+        q[i] += (alpha[j] - beta) * m_s[j][i];
+      }
+    }
+
+    for (T& value : q) {
+      value = -value;
+    }
+    return q;
+  }
+
+  void UpdateHistory(const Point& current, const Point& next) {
+    Params s, q;
+    for (uint32_t i = 0; i < nparams; ++i) {
+      s[i] = next.w[i] - current.w[i];
+      q[i] = next.grad[i] - current.grad[i];
+    }
+
+    // Skip pairs without positive curvature to keep H positive definite
+    const T curvature = Dot(s, q);
+    if (!(curvature > Epsilon() * Norm(s) * Norm(q))) {
+      return;
+    }
+
+    m_newest = (m_num_pairs == 0) ? 0 : (m_newest + 1) % history;
+    m_s[m_newest] = s;
+    m_q[m_newest] = q;
+    m_rho[m_newest] = 1 / curvature;
+    m_num_pairs = std::min(m_num_pairs + 1, history);
+  }
+
+  /** Evaluate the point at w + step * direction and return its slope */
+  T Probe(const std::vector<T>& x, const std::vector<T>& y, const Point& from,
+          const Params& direction, T step, Point& p) {
+    for (uint32_t i = 0; i < nparams; ++i) {
+      p.w[i] = from.w[i] + step * direction[i];
+    }
+    Evaluate(x, y, p);
+    return Dot(p.grad, direction);
+  }
+
+  bool LineSearch(const std::vector<T>& x, const std::vector<T>& y,
+                  const Point& from, const Params& direction, T slope,
+                  T initial_step, Point& next, T& step) {
+    if (m_line_search.method == LineSearchMethod::ARMIJO) {
+      return Backtrack(x, y, from, direction, slope, initial_step, next, step);
+    }
+    return Wolfe(x, y, from, direction, slope, initial_step, next, step);
+  }
+
+  bool Backtrack(const std::vector<T>& x, const std::vector<T>& y,
+                 const Point& from, const Params& direction, T slope,
+                 T initial_step, Point& next, T& step) {
+    step = initial_step;
+    for (uint32_t k = 0; k < m_line_search.max_evaluations; ++k) {
+      Probe(x, y, from, direction, step, next);
+      if (next.loss <= from.loss + m_line_search.c1 * step * slope) {
+        return true;
+      }
+      step /= 2;
+    }
+    return false;
+  }
+
+  // Nocedal & Wright, Numerical Optimization, algorithms 3.5 and 3.6
+  bool Wolfe(const std::vector<T>& x, const std::vector<T>& y,
+             const Point& from, const Params& direction, T slope,
+             T initial_step, Point& next, T& step) {
+    const T c1 = m_line_search.c1;
+    const T c2 = m_line_search.c2;
+
+    T lo = 0;
+    T lo_loss = from.loss;
+    T lo_slope = slope;
+    T hi = 0;
+    T hi_loss = 0;
+    T hi_slope = 0;
+    Point lo_point = from;
+    bool bracketed = false;
+
+    step = initial_step;
+    Point trial;
+    for (uint32_t k = 0; k < m_line_search.max_evaluations; ++k) {
+      if (bracketed) {
+        step = Interpolate(lo, lo_loss, lo_slope, hi, hi_loss, hi_slope);
+      }
+
+      const T trial_slope = Probe(x, y, from, direction, step, trial);
+      const bool sufficient_decrease =
+          trial.loss <= from.loss + c1 * step * slope;
+
+      if (!sufficient_decrease || (trial.loss >= lo_loss)) {
+        hi = step;
+        hi_loss = trial.loss;
+        hi_slope = trial_slope;
+        bracketed = true;
+        continue;
+      }
+
+      if (std::abs(trial_slope) <= -c2 * slope) {
+        next = trial;
+        return true;
+      }
+
+      if ((bracketed && (trial_slope * (hi - lo) >= 0)) ||
+          (!bracketed && (trial_slope >= 0))) {
+        hi = lo;
+        hi_loss = lo_loss;
+        hi_slope = lo_slope;
+        bracketed = true;
+      }
+
+      lo = step;
+      lo_loss = trial.loss;
+      lo_slope = trial_slope;
+      lo_point = trial;
+      if (!bracketed) {
+        step *= 2;
+      }
+    }
+
+    // Out of evaluations: fall back to the best point with sufficient decrease
+    if (lo > 0) {
+      next = lo_point;
+      step = lo;
+      return true;
+    }
+    return false;
+  }
+
+  /** Safeguarded cubic interpolation between two bracketing steps */
+  static T Interpolate(T lo, T lo_loss, T lo_slope, T hi, T hi_loss,
+                       T hi_slope) {
+    const T d1 = lo_slope + hi_slope - 3 * (lo_loss - hi_loss) / (lo - hi);
+    const T discriminant = d1 * d1 - lo_slope * hi_slope;
+    const T width = std::abs(hi - lo);
+    const T low = std::min(lo, hi) + width / 10;
+    const T high = std::max(lo, hi) - width / 10;
+
+    if (discriminant >= 0) {
+      const T d2 = std::copysign(std::sqrt(discriminant), hi - lo);
+      const T step = hi - (hi - lo) * (hi_slope + d2 - d1) /
+                              (hi_slope - lo_slope + 2 * d2);
+      if (std::isfinite(step) && (step >= low) && (step <= high)) {
+        return step;
+      }
+    }
+    return (lo + hi) / 2;
+  }
+};
+
+}  // namespace opt
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_OPTIMIZATION_LBFGS_HPP_
@@ -0,0 +1,352 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_OPTIMIZATION_LEVENBERG_MARQUARDT_HPP_
+#define _JLTX_INCLUDE_OPTIMIZATION_LEVENBERG_MARQUARDT_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "math/cholesky.hpp"
+#include "optimization/convergence.hpp"
+#include "optimization/gradient.hpp"
+
+namespace jltx {
+namespace opt {
+
+/**
+ * @brief Least-squares problem that exposes the Jacobian of its model
+ *
+ * The error is the mean squared error between y and the model estimates.
+ */
+template <typename T, uint32_t nparams>
+struct LeastSquaresProblem : public OptimizationProblem<T, nparams> {
+  /**
+   * @brief Evaluate the model and its Jacobian on a block of samples
+   *
+   * @param x Samples
+   * @param w Parameters
+   * @param estimates Output, one model estimate per sample
+   * @param jacobian Output, x.size() rows of nparams partial derivatives of
+   * the estimate with respect to w, in row-major order
+   */
+  virtual void Jacobian(std::span<const T> x, const std::array<T, nparams>& w,
+                        std::span<T> estimates, std::span<T> jacobian) = 0;
+};
+
+/**
+ * @brief Levenberg-Marquardt solver for LeastSquaresProblem
+ *
+ * Every iteration accumulates the normal equations J^T * J and J^T * r over
+ * the data in fixed-size blocks, so the Jacobian is never stored for the whole
+ * data set. The damped system is solved with a dense Cholesky factorization.
+ * All workspaces are allocated by the constructor.
+ */
+template <typename T, uint32_t nparams>
+class LevenbergMarquardtSolver {
+ public:
+  using Params = std::array<T, nparams>;
+  using Matrix = std::array<T, nparams * nparams>;
+
+  /** Number of samples per Jacobian block */
+  static constexpr std::size_t BLOCK_SIZE = 256;
+
+  LevenbergMarquardtSolver(LeastSquaresProblem<T, nparams>* problem,
+                           ConvergenceCriteria<T> criteria = {})
+      : m_problem(problem),
+        m_criteria(criteria),
+        m_estimates(BLOCK_SIZE),
+        m_jacobian(BLOCK_SIZE * nparams) {}
+
+  /** Set a callback that receives the telemetry of every iteration */
+  void SetCallback(IterationCallback<T> callback) {
+    m_callback = std::move(callback);
+  }
+
+  SolveResult<T, nparams> Solve(const std::vector<T>& x,
+                                const std::vector<T>& y, Params w) {
+    const auto start = std::chrono::steady_clock::now();
+    const T num_samples = static_cast<T>(std::max<std::size_t>(1, x.size()));
+
+    uint32_t evaluations = 1;
+    T loss = Linearize(x, y, w);
+
+    // Damping starts relative to the curvature of the problem
+    T lambda = 0;
+    for (uint32_t i = 0; i < nparams; ++i) {
+      lambda = std::max(lambda, m_jtj[i * nparams + i]);
+    }
+    lambda *= static_cast<T>(1e-3);
+    T lambda_factor = 2;
+
+    SolveResult<T, nparams> result{w, loss / num_samples, 0, evaluations,
+                                   SolveStatus::MAX_ITERATIONS};
+
+    for (uint32_t iteration = 1; iteration <= m_criteria.max_iterations;
+         ++iteration) {
+      // Gradient of the mean squared error
+      const T gradient_norm = 2 * Norm(m_jtr) / num_samples;
+      if (gradient_norm <= m_criteria.gradient_tolerance) {
+        result.status = SolveStatus::GRADIENT_TOLERANCE;
+        break;
+      }
+
+      // Solve (J^T J + lambda * diag(J^T J)) * delta = J^T r
+      Matrix damped = m_jtj;
+      Params delta = m_jtr;
+      for (uint32_t i = 0; i < nparams; ++i) {
+        damped[i * nparams + i] +=
+            lambda * std::max(m_jtj[i * nparams + i], Epsilon());
+      }
+      if (!math::CholeskyDecompose<T, nparams>(damped)) {
+        lambda *= lambda_factor;
+        lambda_factor *= 2;
+        continue;
+      }
+      math::CholeskySolve<T, nparams>(damped, delta);
+
+      const T step = Norm(delta);
+      if (step <= m_criteria.step_tolerance *
+                      (Norm(w) + m_criteria.step_tolerance)) {
+        result.status = SolveStatus::STEP_TOLERANCE;
+        break;
+      }
+
+      Params w_new;
+      for (uint32_t i = 0; i < nparams; ++i) {
+        w_new[i] = w[i] + delta[i];
+      }
+      const T loss_new = m_problem->Error(x, w_new, y) * num_samples;
+      ++evaluations;
+
+      // Gain ratio: actual reduction over the one predicted by the linear
+      // model, ||r||^2 - ||r - J delta||^2 = delta^T (2 J^T r - J^T J delta)
+      T predicted = 0;
+      for (uint32_t i = 0; i < nparams; ++i) {
+        const T jtj_delta =
+            math::Dot(&m_jtj[i * nparams], delta.data(), nparams);
+        predicted += delta[i] * (2 * m_jtr[i] - jtj_delta);
+      }
+      const T rho = (loss - loss_new) / predicted;
+
+      if ((predicted > 0) && (rho > 0)) {
+        const T previous_loss = loss;
+        w = w_new;
+        loss = Linearize(x, y, w);
+        ++evaluations;
+
+        const T r = 2 * rho - 1;
+        lambda *= std::max(static_cast<T>(1) / 3, 1 - r * r * r);
+        lambda_factor = 2;
+
+        result.w = w;
+        result.loss = loss / num_samples;
+        result.iterations = iteration;
+        result.evaluations = evaluations;
+
+        if (m_callback) {
+          const IterationReport<T> report{
+              iteration,
+              result.loss,
+              2 * Norm(m_jtr) / num_samples,
+              step,
+              evaluations,
+              std::chrono::steady_clock::now() - start};
+          if (!m_callback(report)) {
+            result.status = SolveStatus::STOPPED_BY_CALLBACK;
+            break;
+          }
+        }
+
+        if (std::abs(previous_loss - loss) <=
+            m_criteria.relative_loss_tolerance *
+                std::max(std::abs(previous_loss), std::abs(loss))) {
+          result.status = SolveStatus::LOSS_TOLERANCE;
+          break;
+        }
+      } else {
+        lambda *= lambda_factor;
+        lambda_factor *= 2;
+      }
+    }
+
+    result.evaluations = evaluations;
+    return result;
+  }
+
+ private:
+  LeastSquaresProblem<T, nparams>* m_problem;
+  ConvergenceCriteria<T> m_criteria;
+  IterationCallback<T> m_callback;
+
+  std::vector<T> m_estimates;
+  std::vector<T> m_jacobian;
+  Matrix m_jtj;
+  Params m_jtr;
+
+  static constexpr T Epsilon() { return std::numeric_limits<T>::epsilon(); }
+
+  static T Norm(const Params& a) {
+    return std::sqrt(math::Dot(a.data(), a.data(), nparams));
+  }
+
+  /**
+   * @brief Accumulate J^T * J and J^T * r at w
+   *
+   * @return Sum of squared residuals
+   */
+  T Linearize(const std::vector<T>& x, const std::vector<T>& y,
+              const Params& w) {
+    m_jtj = {};
+    m_jtr = {};
+    T loss = 0;
+
+    for (std::size_t offset = 0; offset < x.size(); offset += BLOCK_SIZE) {
+      const std::size_t count = std::min(BLOCK_SIZE, x.size() - offset);
+      m_problem->Jacobian(std::span<const T>(x.data() + offset, count), w,
+                          std::span<T>(m_estimates.data(), count),
+                          std::span<T>(m_jacobian.data(), count * nparams));
+
+      for (std::size_t n = 0; n < count; ++n) {
+        const T* row = &m_jacobian[n * nparams];
+        const T residual = y[offset + n] - m_estimates[n];
+        loss += residual * residual;
+
+        // Rank-one update of the lower triangle, contiguous in k
+        for (uint32_t i = 0; i < nparams; ++i) {
+          const T row_i = row[i];
+          T* jtj_row = &m_jtj[i * nparams];
+          for (uint32_t k = 0; k <= i; ++k) {
+            jtj_row[k] += row_i * row[k];
+          }
+          m_jtr[i] += row_i * residual;
+        }
+      }
+    }
+
+    // Mirror the lower triangle
+    for (uint32_t i = 0; i < nparams; ++i) {
+      for (uint32_t k = i + 1; k < nparams; ++k) {
+        m_jtj[i * nparams + k] = m_jtj[k * nparams + i];
+      }
+    }
+    return loss;
+  }
+};
+
+/**
+ * @brief Fit of a sinusoid y = amplitude * sin(2 * PI * frequency * x + phase)
+ *
+ * x is the sample time in seconds. The parameters are ordered as
+ * {amplitude, frequency, phase}.
+ */
+template <typename T>
+struct SinusoidFitProblem : public LeastSquaresProblem<T, 3> {
+  enum { AMPLITUDE = 0, FREQUENCY = 1, PHASE = 2 };
+
+  [[nodiscard]] static T Evaluate(T x, const std::array<T, 3>& w) {
+    return w[AMPLITUDE] * std::sin(TWO_PI * w[FREQUENCY] * x + w[PHASE]);
+  }
+
+  std::vector<T> Estimate(const std::vector<T>& x,
+                          const std::array<T, 3>& w) override {
+    std::vector<T> estimates(x.size());
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      estimates[n] = Evaluate(x[n], w);
+    }
+    return estimates;
+  }
+
+  T Error(const std::vector<T>& x, const std::array<T, 3>& w,
+          const std::vector<T>& y) override {
+    if (x.empty()) {
+      return 0;
+    }
+
+    T error = 0;
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const T residual = y[n] - Evaluate(x[n], w);
+      error += residual * residual;
+    }
+    return error / static_cast<T>(x.size());
+  }
+
+  std::array<T, 3> Gradient(const std::vector<T>& x, const std::array<T, 3>& w,
+                            const std::vector<T>& y) override {
+    std::array<T, 3> gradient{};
+    if (x.empty()) {
+      return gradient;
+    }
+
+    gradient = PartialGradient(std::span<const T>(x), w, std::span<const T>(y));
+    for (T& g : gradient) {
+      g /= static_cast<T>(x.size());
+    }
+    return gradient;
+  }
+
+  std::array<T, 3> PartialGradient(std::span<const T> x,
+                                   const std::array<T, 3>& w,
+                                   std::span<const T> y) override {
+    std::array<T, 3> gradient{};
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const T angle = TWO_PI * w[FREQUENCY] * x[n] + w[PHASE];
+      const T sin = std::sin(angle);
+      const T cos = std::cos(angle);
+      const T factor = -2 * (y[n] - w[AMPLITUDE] * sin);
+      gradient[AMPLITUDE] += factor * sin;
+      gradient[FREQUENCY] += factor * w[AMPLITUDE] * cos * TWO_PI * x[n];
+      gradient[PHASE] += factor * w[AMPLITUDE] * cos;
+    }
+    return gradient;
+  }
+
+  void Jacobian(std::span<const T> x, const std::array<T, 3>& w,
+                std::span<T> estimates, std::span<T> jacobian) override {
+    for (std::size_t n = 0; n < x.size(); ++n) {
+      const T angle = TWO_PI * w[FREQUENCY] * x[n] + w[PHASE];
+      const T sin = std::sin(angle);
+      const T cos = std::cos(angle);
+      estimates[n] = w[AMPLITUDE] * sin;
+      jacobian[3 * n + AMPLITUDE] = sin;
+      jacobian[3 * n + FREQUENCY] = w[AMPLITUDE] * cos * TWO_PI * x[n];
+      jacobian[3 * n + PHASE] = w[AMPLITUDE] * cos;
+    }
+  }
+
+ private:
+  static constexpr T TWO_PI = static_cast<T>(2 * M_PI);
+};
+
+}  // namespace opt
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_OPTIMIZATION_LEVENBERG_MARQUARDT_HPP_
@@ -0,0 +1,301 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_OPTIMIZATION_SGD_HPP_
+#define _JLTX_INCLUDE_OPTIMIZATION_SGD_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "optimization/gradient.hpp"
+
+namespace jltx {
+namespace opt {
+
+/**
+ * @brief Streaming source of training samples
+ *
+ * The solver pulls mini-batches from the source, so the data set never has to
+ * be in memory as a whole.
+ */
+template <typename T>
+struct BatchSource {
+  /**
+   * Fill x and y with the next samples and return how many were written. A
+   * return value of 0 marks the end of the data.
+   */
+  std::function<std::size_t(std::span<T> x, std::span<T> y)> next;
+
+  /** Go back to the first sample. Empty for sources that can only be read
+   * once, in which case only a single epoch can be run. */
+  std::function<void()> rewind;
+};
+
+/** Batch source reading from a pair of forward iterator ranges */
+template <typename T, typename XIterator, typename YIterator>
+BatchSource<T> IteratorBatchSource(XIterator x_begin, XIterator x_end,
+                                   YIterator y_begin) {
+  struct State {
+    XIterator x_begin, x_end, x;
+    YIterator y_begin, y;
+  };
+  auto state = std::make_shared<State>(
+      State{x_begin, x_end, x_begin, y_begin, y_begin});
+
+  BatchSource<T> source;
+  source.next = [state](std::span<T> x, std::span<T> y) {
+    std::size_t count = 0;
+    while ((count < x.size()) && (state->x != state->x_end)) {
+      x[count] = *state->x++;
+      y[count] = *state->y++;
+      ++count;
+    }
+    return count;
+  };
+  source.rewind = [state]() {
+    state->x = state->x_begin;
+    state->y = state->y_begin;
+  };
+  return source;
+}
+
+/** Learning rate as a function of the number of steps taken */
+template <typename T>
+using LearningRateSchedule = std::function<T(uint64_t step)>;
+
+/** Constant learning rate */
+template <typename T>
+LearningRateSchedule<T> ConstantRate(T rate) {
+  return [rate](uint64_t) { return rate; };
+}
+
+/** Multiply the learning rate by factor every period steps (period 0 is 1) */
+template <typename T>
+LearningRateSchedule<T> StepDecay(T rate, T factor, uint64_t period) {
+  const uint64_t divisor = std::max<uint64_t>(1, period);
+  return [=](uint64_t step) {
+    return rate * static_cast<T>(std::pow(factor, step / divisor));
+  };
+}
+
+/** rate * gamma^step */
+template <typename T>
+LearningRateSchedule<T> ExponentialDecay(T rate, T gamma) {
+  return [=](uint64_t step) {
+    return rate * static_cast<T>(std::pow(gamma, static_cast<T>(step)));
+  };
+}
+
+/** rate / (1 + decay * step) */
+template <typename T>
+LearningRateSchedule<T> InverseTimeDecay(T rate, T decay) {
+  return [=](uint64_t step) {
+    return rate / (1 + decay * static_cast<T>(step));
+  };
+}
+
+/** Cosine annealing from rate down to min_rate over total_steps */
+template <typename T>
+LearningRateSchedule<T> CosineDecay(T rate, T min_rate, uint64_t total_steps) {
+  return [=](uint64_t step) {
+    const double progress =
+        static_cast<double>(std::min(step, total_steps)) /
+        static_cast<double>(std::max<uint64_t>(1, total_steps));
+    return min_rate + (rate - min_rate) *
+                          static_cast<T>(0.5 * (1 + std::cos(M_PI * progress)));
+  };
+}
+
+/** Update rule of the stochastic solver */
+enum class SgdMethod { SGD, MOMENTUM, NESTEROV, ADAM };
+
+template <typename T>
+struct SgdOptions {
+  SgdMethod method = SgdMethod::ADAM;
+
+  /** Number of samples per mini-batch */
+  std::size_t batch_size = 256;
+
+  LearningRateSchedule<T> learning_rate = ConstantRate(static_cast<T>(1e-2));
+
+  /** Momentum coefficient for MOMENTUM and NESTEROV */
+  T momentum = static_cast<T>(0.9);
+
+  /** Adam decay rates and denominator offset */
+  T beta1 = static_cast<T>(0.9);
+  T beta2 = static_cast<T>(0.999);
+  T epsilon = static_cast<T>(1e-8);
+};
+
+/**
+ * @brief Mini-batch stochastic gradient descent
+ *
+ * Samples are pulled from a BatchSource into a preallocated batch buffer and
+ * the gradient of each batch is evaluated through
+ * OptimizationProblem::PartialGradient().
+ */
+template <typename T, uint32_t nparams>
+class StochasticGradientSolver {
+ public:
+  StochasticGradientSolver(OptimizationProblem<T, nparams>* problem,
+                           SgdOptions<T> options = {})
+      : m_problem(problem),
+        m_options(std::move(options)),
+        m_x(std::max<std::size_t>(1, m_options.batch_size)),
+        m_y(m_x.size()) {}
+
+  /**
+   * @brief Run a number of epochs over the source
+   *
+   * The optimizer state (momentum, Adam moments and step count) is kept
+   * between calls; use Reset() to start over.
+   */
+  std::array<T, nparams> Solve(BatchSource<T>& source, uint32_t epochs,
+                               std::array<T, nparams> w) {
+    for (uint32_t epoch = 0; epoch < epochs; ++epoch) {
+      if (epoch > 0) {
+        if (!source.rewind) {
+          break;
+        }
+        source.rewind();
+      }
+
+      std::size_t count;
+      while ((count = source.next(m_x, m_y)) > 0) {
+        Step(std::span<const T>(m_x.data(), count),
+             std::span<const T>(m_y.data(), count), w);
+      }
+    }
+    return w;
+  }
+
+  /** Take a single step using the given mini-batch */
+  void Step(std::span<const T> x, std::span<const T> y,
+            std::array<T, nparams>& w) {
+    if (x.empty()) {
+      return;
+    }
+
+    const T rate = m_options.learning_rate(m_step);
+    ++m_step;
+
+    switch (m_options.method) {
+      case SgdMethod::SGD: {
+        const auto grad = BatchGradient(x, w, y);
+        for (uint32_t i = 0; i < nparams; ++i) {
+          w[i] -= rate * grad[i];
+        }
+        break;
+      }
+
+      case SgdMethod::MOMENTUM: {
+        const auto grad = BatchGradient(x, w, y);
+        for (uint32_t i = 0; i < nparams; ++i) {
+          m_velocity[i] = m_options.momentum * m_velocity[i] - rate * grad[i];
+          w[i] += m_velocity[i];
+        }
+        break;
+      }
+
+      case SgdMethod::NESTEROV: {
+        // Evaluate the gradient at the look-ahead point
+        std::array<T, nparams> look_ahead;
+        for (uint32_t i = 0; i < nparams; ++i) {
+          look_ahead[i] = w[i] + m_options.momentum * m_velocity[i];
+        }
+        const auto grad = BatchGradient(x, look_ahead, y);
+        for (uint32_t i = 0; i < nparams; ++i) {
+          m_velocity[i] = m_options.momentum * m_velocity[i] - rate * grad[i];
+          w[i] += m_velocity[i];
+        }
+        break;
+      }
+
+      case SgdMethod::ADAM: {
+        const auto grad = BatchGradient(x, w, y);
+        m_beta1_power *= m_options.beta1;
+        m_beta2_power *= m_options.beta2;
+        const T correction1 = 1 - m_beta1_power;
+        const T correction2 = 1 - m_beta2_power;
+        for (uint32_t i = 0; i < nparams; ++i) {
+          m_velocity[i] = m_options.beta1 * m_velocity[i] +
+                          (1 - m_options.beta1) * grad[i];
+          m_second_moment[i] = m_options.beta2 * m_second_moment[i] +
+                               (1 - m_options.beta2) * grad[i] * grad[i];
+          const T m_hat = m_velocity[i] / correction1;
+          const T v_hat = m_second_moment[i] / correction2;
+          w[i] -= rate * m_hat / (std::sqrt(v_hat) + m_options.epsilon);
+        }
+        break;
+      }
+    }
+  }
+
+  /** Clear the optimizer state */
+  void Reset() {
+    m_step = 0;
+    m_velocity = {};
+    m_second_moment = {};
+    m_beta1_power = 1;
+    m_beta2_power = 1;
+  }
+
+  /** Number of steps taken since construction or the last Reset() */
+  [[nodiscard]] uint64_t Steps() const { return m_step; }
+
+ private:
+  OptimizationProblem<T, nparams>* m_problem;
+  SgdOptions<T> m_options;
+
+  std::vector<T> m_x;
+  std::vector<T> m_y;
+
+  uint64_t m_step = 0;
+  std::array<T, nparams> m_velocity{};  // Momentum or Adam first moment
+  std::array<T, nparams> m_second_moment{};
+  T m_beta1_power = 1;
+  T m_beta2_power = 1;
+
+  std::array<T, nparams> BatchGradient(std::span<const T> x,
+                                       const std::array<T, nparams>& w,
+                                       std::span<const T> y) {
+    std::array<T, nparams> grad = m_problem->PartialGradient(x, w, y);
+    for (T& g : grad) {
+      g /= static_cast<T>(x.size());
+    }
+    return grad;
+  }
+};
+
+}  // namespace opt
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_OPTIMIZATION_SGD_HPP_
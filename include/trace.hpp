@@ -0,0 +1,288 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_TRACE_HPP_
+#define _JLTX_INCLUDE_TRACE_HPP_
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/Clock.hpp"
+
+namespace jltx {
+namespace trace {
+
+#ifdef TRACE_ENABLED
+static constexpr bool enabled = true;
+#else
+static constexpr bool enabled = false;
+#endif
+
+/** \brief A finished zone */
+struct Event {
+  const char* name;
+  int64_t begin;  //!< Ticks() when the zone was entered
+  int64_t end;    //!< Ticks() when the zone was left
+};
+
+/** \brief Collects the zones of all threads and exports them
+ *
+ * Every thread records into its own fixed-size buffer without locking; the
+ * only lock is taken the first time a thread records a zone. Zones that do
+ * not fit are dropped. When a thread exits, its zones are moved to a buffer
+ * of their size, so the trace can still be exported, and its fixed-size
+ * buffer is reused by the next thread.
+ */
+class Tracer final {
+ public:
+  static constexpr std::size_t EVENTS_PER_THREAD = 1 << 16;
+
+  /** \return The process-wide tracer */
+  static Tracer& Instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  /** \brief Store a zone of the calling thread */
+  void Record(const char* name, int64_t begin, int64_t end) {
+    ThreadBuffer& buffer = CurrentBuffer();
+    const std::size_t count = buffer.count.load(std::memory_order_relaxed);
+    if (count == buffer.capacity) {
+      buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    buffer.events[count] = {name, begin, end};
+    buffer.count.store(count + 1, std::memory_order_release);
+  }
+
+  /** \brief Name the calling thread in the exported trace */
+  void SetThreadName(const std::string& name) {
+    ThreadBuffer& buffer = CurrentBuffer();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer.name = name;
+  }
+
+  /** \brief Write all the zones recorded so far in the Chrome trace event
+   * format, which chrome://tracing and Perfetto open
+   *
+   * \return false if the file could not be written
+   */
+  bool WriteChromeJson(FILE* file) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const double us_per_tick = m_start.NsPerTick(TickCalibration()) / 1000.0;
+    const int pid = static_cast<int>(getpid());
+
+    bool first = true;
+    auto separator = [&] {
+      const char* str = first ? "\n" : ",\n";
+      first = false;
+      return str;
+    };
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (std::size_t tid = 0; tid < m_buffers.size(); ++tid) {
+      const ThreadBuffer& buffer = *m_buffers[tid];
+      if (!buffer.name.empty()) {
+        fprintf(file,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                separator(), pid, tid, Escape(buffer.name.c_str()).c_str());
+      }
+      const std::size_t count = buffer.count.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < count; ++i) {
+        const Event& event = buffer.events[i];
+        fprintf(file,
+                "%s{\"name\":\"%s\",\"cat\":\"jltx\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%zu}",
+                separator(), Escape(event.name).c_str(),
+                static_cast<double>(event.begin - m_start.ticks) * us_per_tick,
+                static_cast<double>(event.end - event.begin) * us_per_tick, pid,
+                tid);
+      }
+    }
+    fprintf(file, "\n]}\n");
+    return ferror(file) == 0;
+  }
+
+  /** \brief Write the trace to a file, see WriteChromeJson(FILE*) */
+  bool WriteChromeJson(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+      return false;
+    }
+    const bool written = WriteChromeJson(file);
+    return fclose(file) == 0 && written;
+  }
+
+  /** \brief Forget the recorded zones. No thread may be recording. */
+  void Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::erase_if(m_buffers, [](const auto& buffer) { return buffer->exited; });
+    for (auto& buffer : m_buffers) {
+      buffer->count.store(0, std::memory_order_relaxed);
+      buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** \return Number of zones that did not fit in their thread's buffer */
+  [[nodiscard]] uint64_t Dropped() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : m_buffers) {
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+  }
+
+ private:
+  struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    std::size_t capacity = EVENTS_PER_THREAD;
+    std::atomic<std::size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    std::string name;
+    bool exited = false;
+  };
+
+  // Hands the buffer of a thread back to the tracer when the thread exits
+  struct BufferOwner {
+    ~BufferOwner() {
+      if (buffer != nullptr) {
+        Instance().Release(*buffer);
+      }
+    }
+
+    ThreadBuffer* buffer = nullptr;
+  };
+
+  Tracer() = default;
+
+  ThreadBuffer& CurrentBuffer() {
+    // Zones recorded after the owner is destroyed go to the exited buffer,
+    // which is full
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+      static thread_local BufferOwner owner;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_buffers.push_back(std::make_unique<ThreadBuffer>());
+      buffer = m_buffers.back().get();
+      if (m_free_events.empty()) {
+        buffer->events.reset(new Event[EVENTS_PER_THREAD]);
+      } else {
+        buffer->events = std::move(m_free_events.back());
+        m_free_events.pop_back();
+      }
+      owner.buffer = buffer;
+    }
+    return *buffer;
+  }
+
+  // Keep the zones of an exiting thread in a buffer of their size
+  void Release(ThreadBuffer& buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::size_t count = buffer.count.load(std::memory_order_relaxed);
+    std::unique_ptr<Event[]> events(new Event[count]);
+    std::copy_n(buffer.events.get(), count, events.get());
+    m_free_events.push_back(std::move(buffer.events));
+    buffer.events = std::move(events);
+    buffer.capacity = count;
+    buffer.exited = true;
+  }
+
+  static std::string Escape(const char* str) {
+    std::string escaped;
+    for (; *str != '\0'; ++str) {
+      const auto ch = static_cast<unsigned char>(*str);
+      if (ch < 0x20) {
+        char code[7];
+        snprintf(code, sizeof(code), "\\u%04x", ch);
+        escaped += code;
+        continue;
+      }
+      if (*str == '"' || *str == '\\') {
+        escaped += '\\';
+      }
+      escaped += *str;
+    }
+    return escaped;
+  }
+
+  const TickCalibration m_start;
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+  // Fixed-size buffers of exited threads
+  std::vector<std::unique_ptr<Event[]>> m_free_events;
+};
+
+/** \brief Records the time between its construction and destruction
+ *
+ * Does nothing unless TRACE_ENABLED is defined. Use it through
+ * JLTX_TRACE_ZONE().
+ */
+class Zone final {
+ public:
+  /** \param name Name of the zone, must be a string literal */
+  explicit Zone(const char* name) {
+    if constexpr (enabled) {
+      m_name = name;
+      m_begin = Ticks();
+    }
+  }
+
+  ~Zone() {
+    if constexpr (enabled) {
+      Tracer::Instance().Record(m_name, m_begin, Ticks());
+    }
+  }
+
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+ private:
+  const char* m_name = nullptr;
+  int64_t m_begin = 0;
+};
+
+#define JLTX_TRACE_CONCAT_IMPL(a, b) a##b
+#define JLTX_TRACE_CONCAT(a, b) JLTX_TRACE_CONCAT_IMPL(a, b)
+
+/** \brief Trace the rest of the enclosing scope as a zone called name */
+#define JLTX_TRACE_ZONE(name) \
+  const jltx::trace::Zone JLTX_TRACE_CONCAT(jltx_trace_zone_, __LINE__)(name)
+
+/** \brief Trace the rest of the enclosing function under its name */
+#define JLTX_TRACE_FUNCTION() JLTX_TRACE_ZONE(__func__)
+
+}  // namespace trace
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_TRACE_HPP_
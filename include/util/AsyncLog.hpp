@@ -0,0 +1,466 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_ASYNC_LOG_HPP_
+#define _JLTX_INCLUDE_UTIL_ASYNC_LOG_HPP_
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jltx {
+namespace debug {
+
+/** \brief What AsyncLogBackend does when a thread's ring is full */
+enum class OverflowPolicy {
+  DROP,  //!< Discard the line immediately
+  BLOCK  //!< Wait for the writer thread up to block_timeout, then discard
+};
+
+struct AsyncLogOptions {
+  /** Bytes of the ring of every logging thread, rounded up to a power of 2 */
+  std::size_t ring_size = 64 << 10;
+
+  OverflowPolicy policy = OverflowPolicy::DROP;
+
+  /** Longest time a BLOCK caller waits for space */
+  std::chrono::microseconds block_timeout{1000};
+
+  /** Longest time a line stays in a ring before being written */
+  std::chrono::milliseconds flush_interval{10};
+};
+
+/** \brief Asynchronous output for BasicLogger
+ *
+ * Every calling thread formats its lines into its own single-producer ring,
+ * so logging takes no lock and never waits for the output file (except
+ * under OverflowPolicy::BLOCK with a full ring). A background thread
+ * collects the pending bytes of all rings and writes them with a single
+ * writev() call.
+ * <br>
+ * Lines are never interleaved, but lines of different threads are only
+ * ordered within every thread. Lines longer than MAX_LINE_SIZE are
+ * truncated. Everything logged before Flush() or the destructor is written
+ * when they return, so a static backend is flushed on exit().
+ * <br>
+ * Example:
+ * static AsyncLogBackend backend(STDOUT_FILENO);
+ * BasicLogger log(backend);
+ * log.i("TAG", "value %d", 42);
+ */
+class AsyncLogBackend final {
+ public:
+  static constexpr std::size_t MAX_LINE_SIZE = 512;
+
+  explicit AsyncLogBackend(int fd, const AsyncLogOptions& options = {})
+      : m_fd(fd),
+        m_options(options),
+        m_ring_size(std::bit_ceil(std::max<std::size_t>(
+            options.ring_size, 2 * MAX_LINE_SIZE))),
+        m_id(NextId()),
+        m_writer([this] { Run(); }) {}
+
+  ~AsyncLogBackend() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake_cv.notify_one();
+    m_writer.join();
+  }
+
+  AsyncLogBackend(const AsyncLogBackend&) = delete;
+  AsyncLogBackend& operator=(const AsyncLogBackend&) = delete;
+
+  /** \brief Format a line as Logger does and queue it
+   *
+   * \return false if the line was dropped
+   */
+  template <typename... Args>
+  bool Log(const char* tag, const char* level_tag, const char* fmt,
+           Args... args) {
+    char line[MAX_LINE_SIZE];
+    // Keep room for the line break
+    const std::size_t capacity = sizeof(line) - 1;
+    std::size_t size = 0;
+    auto append = [&](const char* str) {
+      const std::size_t length = std::min(std::strlen(str), capacity - size);
+      std::memcpy(line + size, str, length);
+      size += length;
+    };
+    append("[");
+    append(level_tag);
+    append("] ");
+    append(tag);
+    append(": ");
+    size += Clamp(std::snprintf(line + size, capacity - size, fmt, args...),
+                  capacity - size);
+    line[size++] = '\n';
+    return Write(line, size);
+  }
+
+  bool Log(const char* tag, const char* level_tag, const char* str) {
+    return Log(tag, level_tag, "%s", str);
+  }
+
+  /** \brief Queue raw bytes, written as one piece
+   *
+   * \return false if they were dropped
+   */
+  bool Write(const char* data, std::size_t size) {
+    Ring& ring = ThreadRing();
+    if (size > m_ring_size) {
+      ring.dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (!WaitForSpace(ring, head, size)) {
+      ring.dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    const std::size_t offset = head & (m_ring_size - 1);
+    const std::size_t first = std::min(size, m_ring_size - offset);
+    std::memcpy(ring.data.get() + offset, data, first);
+    std::memcpy(ring.data.get(), data + first, size - first);
+    ring.head.store(head + size, std::memory_order_release);
+
+    // Only wake the writer early when the ring starts filling up
+    if (head + size - ring.tail.load(std::memory_order_relaxed) >
+        m_ring_size / 2) {
+      Wake();
+    }
+    return true;
+  }
+
+  /** \brief Wait until everything queued so far has been written */
+  void Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t request = ++m_flush_requested;
+    m_wake_cv.notify_one();
+    m_flushed_cv.wait(lock, [&] { return m_flushed >= request; });
+  }
+
+  /** \return Number of lines dropped because a ring was full */
+  [[nodiscard]] uint64_t Dropped() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t dropped = m_reclaimed_dropped;
+    for (const auto& ring : m_rings) {
+      dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+  }
+
+  /** \return Number of rings allocated. Rings of exited threads are freed
+   * once the writer thread has written their lines.
+   */
+  [[nodiscard]] std::size_t RingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rings.size();
+  }
+
+ private:
+  struct Ring {
+    explicit Ring(std::size_t size) : data(new char[size]) {}
+
+    std::unique_ptr<char[]> data;
+    std::thread::id owner = std::this_thread::get_id();
+    std::atomic<uint64_t> dropped{0};
+    // Set once the owner thread has exited and can no longer write
+    std::atomic<bool> exited{false};
+    // Written by the logging thread and the writer thread respectively
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+  };
+
+  static constexpr std::size_t RING_CACHE_SIZE = 8;
+
+  struct CachedRing {
+    uint64_t backend_id = 0;
+    Ring* ring = nullptr;
+  };
+
+  // Trivially destructible, so still usable while the thread exits
+  struct ThreadState {
+    std::array<CachedRing, RING_CACHE_SIZE> cache;
+    std::size_t next_slot = 0;
+    bool exited = false;
+  };
+
+  // Marks the rings of a thread as exited when the thread ends
+  class RingOwner final {
+   public:
+    explicit RingOwner(ThreadState& state) : m_state(state) {}
+    ~RingOwner() {
+      m_state.cache.fill({});
+      m_state.exited = true;
+      for (const auto& weak : m_rings) {
+        if (const auto ring = weak.lock()) {
+          ring->exited.store(true, std::memory_order_release);
+        }
+      }
+    }
+
+    RingOwner(const RingOwner&) = delete;
+    RingOwner& operator=(const RingOwner&) = delete;
+
+    void Add(const std::shared_ptr<Ring>& ring) {
+      // Forget the rings of destroyed backends
+      std::erase_if(m_rings, [](const auto& weak) { return weak.expired(); });
+      m_rings.push_back(ring);
+    }
+
+   private:
+    ThreadState& m_state;
+    std::vector<std::weak_ptr<Ring>> m_rings;
+  };
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static std::size_t Clamp(int written, std::size_t capacity) {
+    return written < 0 ? 0
+                       : std::min(static_cast<std::size_t>(written),
+                                  capacity > 0 ? capacity - 1 : 0);
+  }
+
+  // Ring of the calling thread, registered on its first line. Every thread
+  // remembers its rings in the last RING_CACHE_SIZE backends it used.
+  // Lines logged after the thread's RingOwner is destroyed go to a ring
+  // that is only freed with the backend.
+  Ring& ThreadRing() {
+    static thread_local ThreadState state;
+    for (const CachedRing& cached : state.cache) {
+      if (cached.backend_id == m_id) {
+        return *cached.ring;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::thread::id self = std::this_thread::get_id();
+    // An exited ring may belong to an earlier thread with the same id
+    auto found = std::find_if(m_rings.begin(), m_rings.end(),
+                              [&](const auto& ring) {
+                                return ring->owner == self &&
+                                       !ring->exited.load(
+                                           std::memory_order_relaxed);
+                              });
+    if (found == m_rings.end()) {
+      m_rings.push_back(std::make_shared<Ring>(m_ring_size));
+      found = m_rings.end() - 1;
+      if (!state.exited) {
+        static thread_local RingOwner owner(state);
+        owner.Add(*found);
+      }
+    }
+    state.cache[state.next_slot] = {m_id, found->get()};
+    state.next_slot = (state.next_slot + 1) % RING_CACHE_SIZE;
+    return **found;
+  }
+
+  bool WaitForSpace(Ring& ring, uint64_t head, std::size_t size) {
+    auto has_space = [&] {
+      return head + size - ring.tail.load(std::memory_order_acquire) <=
+             m_ring_size;
+    };
+    if (has_space()) {
+      return true;
+    }
+    if (m_options.policy == OverflowPolicy::DROP) {
+      return false;
+    }
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + m_options.block_timeout;
+    Wake();
+    while (!has_space()) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  void Wake() {
+    if (!m_wake.exchange(true, std::memory_order_relaxed)) {
+      m_wake_cv.notify_one();
+    }
+  }
+
+  void Run() {
+    std::vector<Ring*> rings;
+    for (;;) {
+      bool stop;
+      uint64_t flush_requested;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake_cv.wait_for(lock, m_options.flush_interval, [&] {
+          return m_stop || m_flush_requested != m_flushed ||
+                 m_wake.load(std::memory_order_relaxed);
+        });
+        m_wake.store(false, std::memory_order_relaxed);
+        stop = m_stop;
+        flush_requested = m_flush_requested;
+        rings.clear();
+        for (const auto& ring : m_rings) {
+          rings.push_back(ring.get());
+        }
+      }
+
+      Drain(rings);
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ReclaimRings();
+        m_flushed = flush_requested;
+      }
+      m_flushed_cv.notify_all();
+      if (stop) {
+        return;
+      }
+    }
+  }
+
+  // Free the rings of exited threads that have nothing left to write.
+  // Called with m_mutex held.
+  void ReclaimRings() {
+    std::erase_if(m_rings, [&](const auto& ring) {
+      // exited first: it is set after the last head update of the thread
+      if (!ring->exited.load(std::memory_order_acquire) ||
+          (ring->head.load(std::memory_order_acquire) !=
+           ring->tail.load(std::memory_order_relaxed))) {
+        return false;
+      }
+      m_reclaimed_dropped += ring->dropped.load(std::memory_order_relaxed);
+      return true;
+    });
+  }
+
+  // Write the pending bytes of all rings, at most two pieces per ring
+  void Drain(const std::vector<Ring*>& rings) {
+    m_iov.clear();
+    m_heads.clear();
+    for (Ring* ring : rings) {
+      const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      const uint64_t head = ring->head.load(std::memory_order_acquire);
+      m_heads.push_back(head);
+      if (head == tail) {
+        continue;
+      }
+      const std::size_t offset = tail & (m_ring_size - 1);
+      const std::size_t size = static_cast<std::size_t>(head - tail);
+      const std::size_t first = std::min(size, m_ring_size - offset);
+      m_iov.push_back({ring->data.get() + offset, first});
+      if (first < size) {
+        m_iov.push_back({ring->data.get(), size - first});
+      }
+    }
+
+    WriteAll();
+    for (std::size_t i = 0; i < rings.size(); ++i) {
+      rings[i]->tail.store(m_heads[i], std::memory_order_release);
+    }
+  }
+
+  // writev() everything in m_iov, resuming after partial writes. Data that
+  // cannot be written because of an error is discarded.
+  void WriteAll() {
+    iovec* iov = m_iov.data();
+    std::size_t count = m_iov.size();
+    while (count > 0) {
+      const int batch = static_cast<int>(std::min<std::size_t>(count, IOV_MAX));
+      const ssize_t written = writev(m_fd, iov, batch);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+
+      auto remaining = static_cast<std::size_t>(written);
+      while (count > 0 && remaining >= iov->iov_len) {
+        remaining -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if (count > 0) {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+        iov->iov_len -= remaining;
+      }
+    }
+  }
+
+  const int m_fd;
+  const AsyncLogOptions m_options;
+  const std::size_t m_ring_size;
+  const uint64_t m_id;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake_cv;
+  std::condition_variable m_flushed_cv;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+  uint64_t m_reclaimed_dropped = 0;
+  std::atomic<bool> m_wake{false};
+  bool m_stop = false;
+  uint64_t m_flush_requested = 0;
+  uint64_t m_flushed = 0;
+
+  // Only used by the writer thread
+  std::vector<iovec> m_iov;
+  std::vector<uint64_t> m_heads;
+
+  // Last member, so that everything else exists when it starts
+  std::thread m_writer;
+};
+
+/** \brief Output of a BasicLogger constructed with an AsyncLogBackend */
+template <typename... Args>
+bool log(AsyncLogBackend* backend, const char* tag, const char* level_tag,
+         Args... args) {
+  return backend->Log(tag, level_tag, args...);
+}
+
+}  // namespace debug
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_ASYNC_LOG_HPP_
@@ -0,0 +1,636 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_BINARY_LOG_HPP_
+#define _JLTX_INCLUDE_UTIL_BINARY_LOG_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "util/Clock.hpp"
+
+namespace jltx {
+namespace debug {
+
+/** \brief Layout of the files written by BinaryLogWriter
+ *
+ * The file starts with a FileHeader, followed by records aligned to 8 bytes.
+ * Every record starts with a RecordHeader. Format records (id with
+ * FORMAT_FLAG set) define an id: number of arguments, one ArgType per
+ * argument, then the level tag, tag and format as null-terminated strings.
+ * Message records hold a jltx::Ticks() timestamp and the raw
+ * arguments; strings are stored as a uint16_t length and their characters.
+ * The id is stored plus one and written last, so 0 marks a record that was
+ * never completed. A record with size 0 ends the log.
+ */
+namespace binlog {
+
+static constexpr char MAGIC[8] = {'J', 'L', 'T', 'X', 'B', 'L', 'O', 'G'};
+static constexpr uint32_t VERSION = 1;
+static constexpr uint32_t FORMAT_FLAG = 1u << 31;
+static constexpr std::size_t MAX_STRING_SIZE = UINT16_MAX;
+
+enum class ArgType : uint8_t { INT32, UINT32, INT64, UINT64, DOUBLE, STRING };
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  int64_t start_ticks;    //!< Ticks() when the log was created
+  int64_t start_ns;       //!< Steady clock time at the same moment
+  int64_t start_unix_ns;  //!< System time at the same moment
+  int64_t end_ticks;      //!< Ticks() when the log was closed, 0 if it was not
+  int64_t end_ns;         //!< Steady clock time at the same moment
+};
+
+struct RecordHeader {
+  uint32_t size;  //!< Size of the record, including this header
+  uint32_t id;
+};
+
+/** \brief How an argument of type T is stored */
+template <typename T>
+consteval ArgType TypeOf() {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+    return ArgType::STRING;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return ArgType::DOUBLE;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) <= 4) {
+    return std::is_signed_v<U> || sizeof(U) < 4 ? ArgType::INT32
+                                                : ArgType::UINT32;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) == 8) {
+    return std::is_signed_v<U> ? ArgType::INT64 : ArgType::UINT64;
+  } else {
+    static_assert(sizeof(U) == 0, "Unsupported binary log argument type");
+  }
+}
+
+/** \brief Argument types of a call, one array per type list */
+template <typename... Args>
+struct Signature {
+  static constexpr std::array<ArgType, sizeof...(Args)> TYPES = {
+      TypeOf<Args>()...};
+};
+
+inline std::size_t StringSize(const char* str) {
+  return str == nullptr ? 0 : strnlen(str, MAX_STRING_SIZE);
+}
+
+template <typename T>
+std::size_t ArgSize(const T& arg) {
+  if constexpr (TypeOf<T>() == ArgType::STRING) {
+    return sizeof(uint16_t) + StringSize(arg);
+  } else if constexpr (TypeOf<T>() == ArgType::INT32 ||
+                       TypeOf<T>() == ArgType::UINT32) {
+    return 4;
+  } else {
+    return 8;
+  }
+}
+
+template <typename T>
+char* WriteArg(char* out, const T& arg) {
+  constexpr ArgType type = TypeOf<T>();
+  if constexpr (type == ArgType::STRING) {
+    const auto size = static_cast<uint16_t>(StringSize(arg));
+    std::memcpy(out, &size, sizeof(size));
+    std::memcpy(out + sizeof(size), arg, size);
+    return out + sizeof(size) + size;
+  } else {
+    using Stored = std::conditional_t<
+        type == ArgType::INT32, int32_t,
+        std::conditional_t<
+            type == ArgType::UINT32, uint32_t,
+            std::conditional_t<type == ArgType::INT64, int64_t,
+                               std::conditional_t<type == ArgType::UINT64,
+                                                  uint64_t, double>>>>;
+    const auto value = static_cast<Stored>(arg);
+    std::memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+  }
+}
+
+}  // namespace binlog
+
+/** \brief Deferred binary output for BasicLogger
+ *
+ * Instead of formatting, every call stores an id of its format, a timestamp
+ * and the raw bytes of its arguments into a memory-mapped file. The file is
+ * turned back into text offline with DecodeBinaryLog(), e.g. with the
+ * binlog_decode tool.
+ * <br>
+ * Formats are interned by the addresses of the level tag, tag and format
+ * together with the argument types, so tags and formats must be string
+ * literals or otherwise outlive the writer. Ids are cached per thread, so
+ * after the first call of a format a record costs one atomic addition and a
+ * few copies. Records that do not fit in the file are dropped.
+ * <br>
+ * Example:
+ * static BinaryLogWriter writer("/tmp/app.blog");
+ * BasicLogger log(writer);
+ * log.i("TAG", "value %d", 42);
+ */
+class BinaryLogWriter final {
+ public:
+  /** \param path File to create
+   * \param capacity Maximum size of the log. The file is created sparse with
+   * this size and truncated to the used size when the writer is destroyed.
+   */
+  explicit BinaryLogWriter(const std::string& path,
+                           std::size_t capacity = 256 << 20)
+      : m_id(NextId()) {
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+      return;
+    }
+    capacity = std::max(capacity, sizeof(binlog::FileHeader)) & ~std::size_t{7};
+    if (ftruncate(m_fd, static_cast<off_t>(capacity)) != 0) {
+      return;
+    }
+    void* data =
+        mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+      return;
+    }
+    m_data = static_cast<char*>(data);
+    m_capacity = capacity;
+
+    binlog::FileHeader header{};
+    std::memcpy(header.magic, binlog::MAGIC, sizeof(header.magic));
+    header.version = binlog::VERSION;
+    header.start_ticks = Ticks();
+    header.start_ns = NowNs();
+    header.start_unix_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    std::memcpy(m_data, &header, sizeof(header));
+  }
+
+  ~BinaryLogWriter() {
+    if (m_data != nullptr) {
+      auto* header = reinterpret_cast<binlog::FileHeader*>(m_data);
+      header->end_ticks = Ticks();
+      header->end_ns = NowNs();
+      munmap(m_data, m_capacity);
+      const uint64_t used = std::min<uint64_t>(
+          m_offset.load(std::memory_order_relaxed), m_capacity);
+      // The writer is the only user left, so the ftruncate error can only
+      // leave unused zeros at the end, which the decoder ignores
+      [[maybe_unused]] const int result =
+          ftruncate(m_fd, static_cast<off_t>(used));
+    }
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+  }
+
+  BinaryLogWriter(const BinaryLogWriter&) = delete;
+  BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+  /** \return true if the file could be created and mapped */
+  [[nodiscard]] bool IsOpen() const { return m_data != nullptr; }
+
+  /** \brief Store one message with the format and arguments of printf
+   *
+   * \return false if the record was dropped
+   */
+  template <typename... Args>
+  bool Record(const char* tag, const char* level_tag, const char* fmt,
+              Args... args) {
+    if (m_data == nullptr) {
+      return false;
+    }
+    const uint32_t id = Intern(tag, level_tag, fmt,
+                               binlog::Signature<Args...>::TYPES.data(),
+                               sizeof...(Args));
+    const std::size_t size = sizeof(binlog::RecordHeader) + sizeof(int64_t) +
+                             (binlog::ArgSize(args) + ... + 0);
+    char* record = Reserve(size);
+    if (record == nullptr) {
+      return false;
+    }
+
+    const int64_t now = Ticks();
+    char* out = record + sizeof(binlog::RecordHeader);
+    std::memcpy(out, &now, sizeof(now));
+    out += sizeof(now);
+    ((out = binlog::WriteArg(out, args)), ...);
+    Publish(record, id);
+    return true;
+  }
+
+  /** \brief Store a plain string, like Logger does with a single argument */
+  bool Record(const char* tag, const char* level_tag, const char* str) {
+    return Record(tag, level_tag, "%s", str);
+  }
+
+  /** \return Number of records that did not fit in the file */
+  [[nodiscard]] uint64_t Dropped() const {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct FormatKey {
+    const char* tag;
+    const char* level_tag;
+    const char* fmt;
+    const binlog::ArgType* types;
+
+    bool operator==(const FormatKey&) const = default;
+  };
+
+  struct FormatKeyHash {
+    std::size_t operator()(const FormatKey& key) const {
+      std::size_t hash = reinterpret_cast<std::uintptr_t>(key.fmt);
+      hash = hash * 31 + reinterpret_cast<std::uintptr_t>(key.tag);
+      hash = hash * 31 + reinterpret_cast<std::uintptr_t>(key.level_tag);
+      return hash * 31 + reinterpret_cast<std::uintptr_t>(key.types);
+    }
+  };
+
+  // Direct-mapped per-thread cache of interned ids
+  struct CacheEntry {
+    uint64_t writer_id = 0;
+    FormatKey key{};
+    uint32_t id = 0;
+  };
+  static constexpr std::size_t CACHE_SIZE = 256;
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t Intern(const char* tag, const char* level_tag, const char* fmt,
+                  const binlog::ArgType* types, std::size_t num_args) {
+    static thread_local std::array<CacheEntry, CACHE_SIZE> cache;
+    const FormatKey key{tag, level_tag, fmt, types};
+    CacheEntry& entry = cache[FormatKeyHash()(key) % CACHE_SIZE];
+    if (entry.writer_id == m_id && entry.key == key) {
+      return entry.id;
+    }
+
+    std::lock_guard<std::mutex> lock(m_formats_mutex);
+    auto found = m_formats.find(key);
+    if (found == m_formats.end()) {
+      const auto id = static_cast<uint32_t>(m_formats.size());
+      WriteFormat(key, num_args, id);
+      found = m_formats.emplace(key, id).first;
+    }
+    entry = {m_id, key, found->second};
+    return found->second;
+  }
+
+  // Format records are reserved before their id is used anywhere, so they
+  // always precede the messages that refer to them
+  void WriteFormat(const FormatKey& key, std::size_t num_args, uint32_t id) {
+    const std::size_t tag_size = std::strlen(key.tag) + 1;
+    const std::size_t level_size = std::strlen(key.level_tag) + 1;
+    const std::size_t fmt_size = std::strlen(key.fmt) + 1;
+    char* record = Reserve(sizeof(binlog::RecordHeader) + 1 + num_args +
+                           level_size + tag_size + fmt_size);
+    if (record == nullptr) {
+      return;
+    }
+    char* out = record + sizeof(binlog::RecordHeader);
+    *out++ = static_cast<char>(num_args);
+    std::memcpy(out, key.types, num_args);
+    out += num_args;
+    std::memcpy(out, key.level_tag, level_size);
+    out += level_size;
+    std::memcpy(out, key.tag, tag_size);
+    out += tag_size;
+    std::memcpy(out, key.fmt, fmt_size);
+    Publish(record, id | binlog::FORMAT_FLAG);
+  }
+
+  // Space for a record of size bytes, rounded up to 8, or nullptr
+  char* Reserve(std::size_t size) {
+    size = (size + 7) & ~std::size_t{7};
+    const uint64_t offset = m_offset.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size > m_capacity) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    char* record = m_data + offset;
+    binlog::RecordHeader header{static_cast<uint32_t>(size), 0};
+    std::memcpy(record, &header, sizeof(header));
+    return record;
+  }
+
+  // Setting the id last marks the record as complete
+  static void Publish(char* record, uint32_t id) {
+    std::atomic_ref<uint32_t>(
+        reinterpret_cast<binlog::RecordHeader*>(record)->id)
+        .store(id + 1, std::memory_order_release);
+  }
+
+  const uint64_t m_id;
+  int m_fd = -1;
+  char* m_data = nullptr;
+  std::size_t m_capacity = 0;
+  std::atomic<uint64_t> m_offset{sizeof(binlog::FileHeader)};
+  std::atomic<uint64_t> m_dropped{0};
+
+  std::mutex m_formats_mutex;
+  std::unordered_map<FormatKey, uint32_t, FormatKeyHash> m_formats;
+};
+
+/** \brief Output of a BasicLogger constructed with a BinaryLogWriter */
+template <typename... Args>
+bool log(BinaryLogWriter* writer, const char* tag, const char* level_tag,
+         Args... args) {
+  return writer->Record(tag, level_tag, args...);
+}
+
+/** \brief Write the messages of a binary log as text lines
+ *
+ * Lines look like the ones of a Logger writing to a file, optionally
+ * preceded by the time since the log was created, "[+1.000000000] ".
+ *
+ * \param data Contents of a file written by BinaryLogWriter
+ * \param out Output file
+ * \param timestamps Print the time of every message
+ * \return false if data is not a binary log or is truncated
+ */
+inline bool DecodeBinaryLog(std::string_view data, FILE* out,
+                            bool timestamps = true) {
+  using binlog::ArgType;
+
+  struct Format {
+    std::vector<ArgType> types;
+    const char* level_tag;
+    const char* tag;
+    const char* fmt;
+  };
+  struct Arg {
+    ArgType type;
+    int64_t i;
+    uint64_t u;
+    double d;
+    std::string s;
+  };
+
+  binlog::FileHeader header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, binlog::MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != binlog::VERSION) {
+    return false;
+  }
+
+  // Read fixed-size values without alignment requirements, failing instead
+  // of reading past the end of the record
+  auto read = [](const char*& in, const char* end, auto& value) {
+    if (static_cast<std::size_t>(end - in) < sizeof(value)) {
+      return false;
+    }
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return true;
+  };
+  auto read_string = [](const char*& in, const char* end, const char*& str) {
+    const void* terminator = std::memchr(in, '\0', end - in);
+    if (terminator == nullptr) {
+      return false;
+    }
+    str = in;
+    in = static_cast<const char*>(terminator) + 1;
+    return true;
+  };
+
+  // Without the closing clock pair ticks are assumed to be ns
+  const double ns_per_tick =
+      TickCalibration{header.start_ticks, header.start_ns}.NsPerTick(
+          {header.end_ticks, header.end_ns});
+
+  std::unordered_map<uint32_t, Format> formats;
+  std::vector<Arg> args;
+  std::size_t pos = sizeof(header);
+  while (pos + sizeof(binlog::RecordHeader) <= data.size()) {
+    binlog::RecordHeader record;
+    std::memcpy(&record, data.data() + pos, sizeof(record));
+    if (record.size == 0) {
+      break;
+    }
+    if (record.size < sizeof(record) || pos + record.size > data.size()) {
+      return false;
+    }
+    const char* in = data.data() + pos + sizeof(record);
+    const char* end = data.data() + pos + record.size;
+    pos += record.size;
+    if (record.id == 0) {
+      continue;  // Reserved but never completed
+    }
+    const uint32_t id = record.id - 1;
+
+    if (id & binlog::FORMAT_FLAG) {
+      Format format;
+      uint8_t num_args;
+      if (!read(in, end, num_args)) {
+        return false;
+      }
+      for (uint8_t i = 0; i < num_args; ++i) {
+        uint8_t type;
+        if (!read(in, end, type) ||
+            type > static_cast<uint8_t>(ArgType::STRING)) {
+          return false;
+        }
+        format.types.push_back(static_cast<ArgType>(type));
+      }
+      if (!read_string(in, end, format.level_tag) ||
+          !read_string(in, end, format.tag) ||
+          !read_string(in, end, format.fmt)) {
+        return false;
+      }
+      formats[id & ~binlog::FORMAT_FLAG] = std::move(format);
+      continue;
+    }
+
+    const auto found = formats.find(id);
+    if (found == formats.end()) {
+      continue;  // Its format did not fit in the file
+    }
+    const Format& format = found->second;
+
+    int64_t timestamp;
+    if (!read(in, end, timestamp)) {
+      return false;
+    }
+    args.resize(format.types.size());
+    for (std::size_t i = 0; i < args.size(); ++i) {
+      Arg& arg = args[i];
+      arg = {format.types[i], 0, 0, 0.0, {}};
+      bool complete = false;
+      switch (arg.type) {
+        case ArgType::INT32: {
+          int32_t value = 0;
+          complete = read(in, end, value);
+          arg.i = value;
+          break;
+        }
+        case ArgType::UINT32: {
+          uint32_t value = 0;
+          complete = read(in, end, value);
+          arg.u = value;
+          break;
+        }
+        case ArgType::INT64:
+          complete = read(in, end, arg.i);
+          break;
+        case ArgType::UINT64:
+          complete = read(in, end, arg.u);
+          break;
+        case ArgType::DOUBLE:
+          complete = read(in, end, arg.d);
+          break;
+        case ArgType::STRING: {
+          uint16_t size;
+          complete = read(in, end, size) &&
+                     static_cast<std::size_t>(end - in) >= size;
+          if (complete) {
+            arg.s.assign(in, size);
+            in += size;
+          }
+          break;
+        }
+      }
+      if (!complete) {
+        return false;
+      }
+      if (arg.type == ArgType::INT32 || arg.type == ArgType::INT64) {
+        arg.u = static_cast<uint64_t>(arg.i);
+      } else if (arg.type == ArgType::UINT32 || arg.type == ArgType::UINT64) {
+        arg.i = static_cast<int64_t>(arg.u);
+      }
+    }
+
+    if (timestamps) {
+      const auto elapsed = static_cast<int64_t>(
+          static_cast<double>(timestamp - header.start_ticks) * ns_per_tick);
+      fprintf(out, "[+%lld.%09lld] ",
+              static_cast<long long>(elapsed / 1000000000),
+              static_cast<long long>(elapsed % 1000000000));
+    }
+    fprintf(out, "[%s] %s: ", format.level_tag, format.tag);
+
+    // Print the format, converting every argument with the type it was
+    // stored with and the length modifier that matches it
+    std::size_t next_arg = 0;
+    for (const char* c = format.fmt; *c != '\0'; ++c) {
+      if (*c != '%') {
+        fputc(*c, out);
+        continue;
+      }
+      if (c[1] == '%') {
+        fputc('%', out);
+        ++c;
+        continue;
+      }
+
+      std::string spec = "%";
+      for (++c; *c != '\0' && std::strchr("-+ #0123456789.*", *c); ++c) {
+        if (*c == '*' && next_arg < args.size()) {
+          spec += std::to_string(args[next_arg++].i);
+        } else {
+          spec += *c;
+        }
+      }
+      while (*c != '\0' && std::strchr("hlLqjzt", *c)) {
+        ++c;
+      }
+      if (*c == '\0') {
+        fputs(spec.c_str(), out);
+        break;
+      }
+      const char conversion = *c;
+      if (next_arg >= args.size()) {
+        fputs((spec + conversion).c_str(), out);
+        continue;
+      }
+      const Arg& arg = args[next_arg++];
+
+      if (std::strchr("di", conversion)) {
+        spec += "lld";
+        fprintf(out, spec.c_str(),
+                static_cast<long long>(arg.type == ArgType::DOUBLE
+                                           ? static_cast<int64_t>(arg.d)
+                                           : arg.i));
+      } else if (std::strchr("ouxX", conversion)) {
+        // 32-bit arguments keep their width, as printf prints -1 with %x
+        const bool narrow =
+            arg.type == ArgType::INT32 || arg.type == ArgType::UINT32;
+        spec += "ll";
+        spec += conversion;
+        fprintf(out, spec.c_str(),
+                static_cast<unsigned long long>(
+                    narrow ? static_cast<uint32_t>(arg.u) : arg.u));
+      } else if (std::strchr("eEfFgGaA", conversion)) {
+        spec += conversion;
+        fprintf(out, spec.c_str(),
+                arg.type == ArgType::DOUBLE ? arg.d
+                                            : static_cast<double>(arg.i));
+      } else if (conversion == 'c') {
+        spec += 'c';
+        fprintf(out, spec.c_str(), static_cast<int>(arg.i));
+      } else if (conversion == 's') {
+        spec += 's';
+        fprintf(out, spec.c_str(),
+                arg.type == ArgType::STRING ? arg.s.c_str() : "?");
+      } else if (conversion == 'p') {
+        fprintf(out, "0x%llx", static_cast<unsigned long long>(arg.u));
+      } else {
+        fputs((spec + conversion).c_str(), out);
+      }
+    }
+    fputc('\n', out);
+  }
+  return true;
+}
+
+}  // namespace debug
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_BINARY_LOG_HPP_
@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_CLOCK_HPP_
+#define _JLTX_INCLUDE_UTIL_CLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace jltx {
+
+/** \return Steady clock time in ns */
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/** \brief Cheap timestamp for tracing and logging
+ *
+ * The time stamp counter on x86, which is about twice as fast to read as
+ * the steady clock, and ns elsewhere. Convert it to time with a
+ * TickCalibration.
+ */
+inline int64_t Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return static_cast<int64_t>(__rdtsc());
+#else
+  return NowNs();
+#endif
+}
+
+/** \brief Pair of Ticks() and NowNs() taken at the same moment. Two of them
+ * give the length of a tick. */
+struct TickCalibration {
+  int64_t ticks = Ticks();
+  int64_t ns = NowNs();
+
+  /** \return ns per tick between this and a later calibration point, or 1 if
+   * they are too close to tell */
+  [[nodiscard]] double NsPerTick(const TickCalibration& later) const {
+    return later.ticks > ticks ? static_cast<double>(later.ns - ns) /
+                                     static_cast<double>(later.ticks - ticks)
+                               : 1.0;
+  }
+};
+
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_CLOCK_HPP_
@@ -0,0 +1,263 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_COLUMN_PARSER_HPP_
+#define _JLTX_INCLUDE_UTIL_COLUMN_PARSER_HPP_
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "util/TextUtils.hpp"
+
+namespace jltx {
+namespace TextUtils {
+
+enum class ParseStatus {
+  OK,            //!< The whole field is a number
+  EMPTY,         //!< The field is empty or only contains whitespace
+  INVALID,       //!< The field is not a number or has trailing characters
+  OUT_OF_RANGE,  //!< The number does not fit in the requested type
+  MISSING        //!< The row has fewer fields than expected
+};
+
+/** \brief Value of 8 ASCII digits, or -1 if any of them is not a digit
+ *
+ * The digits are combined in a 64 bit register with 3 multiplications
+ * instead of one per digit.
+ */
+inline int64_t ParseEightDigits(const char* digits) {
+  uint64_t v;
+  std::memcpy(&v, digits, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  // Every byte must be in 0x30-0x39: high nibble 3, and still 3 after
+  // adding 6 to the low nibble
+  if ((v & 0xF0F0F0F0F0F0F0F0) != 0x3030303030303030 ||
+      ((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) !=
+          0x3030303030303030) {
+    return -1;
+  }
+  v -= 0x3030303030303030;
+  v = (v * 10) + (v >> 8);  // Pairs of digits in every other byte
+  v = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+      32;
+  return static_cast<int64_t>(v);
+}
+
+/** \brief Parse a whole field as a number, without allocating and
+ * independently of the locale
+ *
+ * Surrounding whitespace and a leading '+' are accepted, like std::stof and
+ * std::stoi do; any other trailing character makes the field INVALID.
+ * Integers of up to 19 digits are parsed 8 digits at a time with
+ * ParseEightDigits(), everything else with std::from_chars.
+ *
+ * \param field Text of the field
+ * \param value Parsed number, only written if the result is OK
+ * \return Status of the conversion
+ */
+template <typename T>
+  requires(std::integral<T> && !std::same_as<T, bool>) ||
+           std::floating_point<T>
+ParseStatus ParseNumber(std::string_view field, T& value) {
+  field = TrimView(field);
+  if (field.empty()) {
+    return ParseStatus::EMPTY;
+  }
+  if (field.front() == '+' && field.size() > 1 && field[1] != '-') {
+    field.remove_prefix(1);
+  }
+
+  if constexpr (std::integral<T>) {
+    const bool negative = field.front() == '-';
+    const std::string_view digits = field.substr(negative ? 1 : 0);
+    if (!digits.empty() && digits.size() <= 19 &&
+        (!negative || std::is_signed_v<T>)) {
+      // 19 digits always fit in 64 bits unsigned
+      uint64_t magnitude = 0;
+      std::size_t i = 0;
+      for (; i + 8 <= digits.size(); i += 8) {
+        const int64_t chunk = ParseEightDigits(digits.data() + i);
+        if (chunk < 0) {
+          return ParseStatus::INVALID;
+        }
+        magnitude = magnitude * 100000000 + static_cast<uint64_t>(chunk);
+      }
+      for (; i < digits.size(); ++i) {
+        const auto digit =
+            static_cast<unsigned>(static_cast<unsigned char>(digits[i])) -
+            unsigned{'0'};
+        if (digit > 9) {
+          return ParseStatus::INVALID;
+        }
+        magnitude = magnitude * 10 + digit;
+      }
+
+      using Unsigned = std::make_unsigned_t<T>;
+      const uint64_t limit =
+          static_cast<uint64_t>(std::numeric_limits<T>::max()) +
+          (negative ? 1 : 0);
+      if (magnitude > limit) {
+        return ParseStatus::OUT_OF_RANGE;
+      }
+      const Unsigned bits = static_cast<Unsigned>(magnitude);
+      value = static_cast<T>(negative ? static_cast<Unsigned>(0 - bits) : bits);
+      return ParseStatus::OK;
+    }
+  }
+
+  const char* end = field.data() + field.size();
+  T parsed;
+  const auto [ptr, ec] = std::from_chars(field.data(), end, parsed);
+  if (ec == std::errc::result_out_of_range) {
+    return ParseStatus::OUT_OF_RANGE;
+  }
+  if (ec != std::errc() || ptr != end) {
+    return ParseStatus::INVALID;
+  }
+  value = parsed;
+  return ParseStatus::OK;
+}
+
+/** \brief Field that could not be converted by ColumnParser */
+struct FieldError {
+  std::size_t row;     //!< Row number, counting from 0
+  std::size_t column;  //!< Index of the column in the parser
+  ParseStatus status;  //!< Reason of the failure
+};
+
+/** \brief Converts rows of split fields into one typed vector per column
+ *
+ * Fields that cannot be converted store a value-initialized number, so all
+ * columns always have one value per row, and are listed in Errors().
+ * <br>
+ * Example, reading columns 0 and 2 of a CSV file:
+ * ColumnParser<int64_t, float> parser({0, 2});
+ * CsvReader(file.Data()).ForEachRow(
+ *     [&](const CsvRow& row) { parser.Append(row.fields); });
+ * std::span<const float> y = parser.Column<1>();
+ *
+ * \tparam Ts Numeric type of every column
+ */
+template <typename... Ts>
+class ColumnParser {
+ public:
+  static constexpr std::size_t NUM_COLUMNS = sizeof...(Ts);
+
+  /** \param fields Index of the field read into every column */
+  explicit ColumnParser(const std::array<std::size_t, NUM_COLUMNS>& fields)
+      : m_fields(fields) {}
+
+  /** \brief Columns read from the first fields of every row, in order */
+  ColumnParser() {
+    for (std::size_t i = 0; i < NUM_COLUMNS; ++i) {
+      m_fields[i] = i;
+    }
+  }
+
+  /** \brief Convert the fields of one row and append them to the columns
+   *
+   * \return true if all the fields were converted
+   */
+  bool Append(std::span<const std::string_view> fields) {
+    const std::size_t errors = m_errors.size();
+    AppendColumns(fields, std::index_sequence_for<Ts...>());
+    ++m_rows;
+    return m_errors.size() == errors;
+  }
+
+  /** \brief Reserve space for a number of rows in every column */
+  void Reserve(std::size_t rows) {
+    std::apply([rows](auto&... column) { (column.reserve(rows), ...); },
+               m_columns);
+  }
+
+  /** \brief Remove all the rows and errors */
+  void Clear() {
+    std::apply([](auto&... column) { (column.clear(), ...); }, m_columns);
+    m_errors.clear();
+    m_rows = 0;
+  }
+
+  /** \return Values of column I, one per row */
+  template <std::size_t I>
+  [[nodiscard]] const auto& Column() const {
+    return std::get<I>(m_columns);
+  }
+
+  /** \brief Take the values of column I, leaving it empty */
+  template <std::size_t I>
+  [[nodiscard]] auto TakeColumn() {
+    return std::move(std::get<I>(m_columns));
+  }
+
+  /** \return Fields that could not be converted, in row order */
+  [[nodiscard]] const std::vector<FieldError>& Errors() const {
+    return m_errors;
+  }
+
+  /** \return Number of rows appended */
+  [[nodiscard]] std::size_t Rows() const { return m_rows; }
+
+ private:
+  template <std::size_t... Is>
+  void AppendColumns(std::span<const std::string_view> fields,
+                     std::index_sequence<Is...>) {
+    (AppendField<Is>(fields), ...);
+  }
+
+  template <std::size_t I>
+  void AppendField(std::span<const std::string_view> fields) {
+    auto& column = std::get<I>(m_columns);
+    auto& value = column.emplace_back();
+    const ParseStatus status = m_fields[I] < fields.size()
+                                   ? ParseNumber(fields[m_fields[I]], value)
+                                   : ParseStatus::MISSING;
+    if (status != ParseStatus::OK) {
+      m_errors.push_back({m_rows, I, status});
+    }
+  }
+
+  std::array<std::size_t, NUM_COLUMNS> m_fields{};
+  std::tuple<std::vector<Ts>...> m_columns;
+  std::vector<FieldError> m_errors;
+  std::size_t m_rows = 0;
+};
+
+}  // namespace TextUtils
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_COLUMN_PARSER_HPP_
@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_CSV_READER_HPP_
+#define _JLTX_INCLUDE_UTIL_CSV_READER_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "util/ThreadPool.hpp"
+
+namespace jltx {
+namespace TextUtils {
+
+/** \brief Read-only memory mapping of a whole file */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /** \return true if the file could be opened and mapped */
+  [[nodiscard]] bool IsOpen() const { return m_open; }
+
+  /** \return The contents of the file, valid while the object lives */
+  [[nodiscard]] std::string_view Data() const { return {m_data, m_size}; }
+
+ private:
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+  bool m_open = false;
+};
+
+struct CsvOptions {
+  /** Field delimiter */
+  char delimiter = ',';
+
+  /** Quote character. Fields starting with it may contain delimiters, line
+   * breaks and doubled quotes. A quoted field followed by other characters
+   * before the next delimiter, such as "ab"c, is reported as it is, quotes
+   * included. '\0' disables quoting. */
+  char quote = '"';
+
+  /** Do not report lines without any character */
+  bool skip_empty_lines = true;
+
+  /** Approximate number of bytes parsed by every task in parallel mode */
+  std::size_t chunk_size = 4 << 20;
+};
+
+/** \brief Row passed to the CsvReader callback */
+struct CsvRow {
+  /** Row number, counting from 0 */
+  std::size_t index;
+
+  /** Fields of the row. Only valid during the callback. */
+  std::span<const std::string_view> fields;
+};
+
+/** \brief Streaming tokenizer for delimited text such as CSV files
+ *
+ * Rows are reported as views into the input, so nothing is copied. Line and
+ * field boundaries are found with SSE2 when available. Quoted fields are
+ * reported without their enclosing quotes; doubled quotes inside them are
+ * left as they are and can be collapsed with Unquote().
+ * <br>
+ * Example:
+ * MappedFile file("data.csv");
+ * CsvReader(file.Data()).ForEachRow([](const CsvRow& row) { ... });
+ */
+class CsvReader {
+ public:
+  using Callback = std::function<void(const CsvRow&)>;
+
+  explicit CsvReader(std::string_view data, CsvOptions options = {});
+
+  /** \brief Parse all rows and call callback for each of them in order
+   *
+   * \param callback Function called with every row
+   * \param pool Optional thread pool. If set, chunks of chunk_size bytes,
+   * split at line boundaries outside quotes, are parsed in parallel and the
+   * rows are still reported in order on the calling thread.
+   */
+  void ForEachRow(const Callback& callback, ThreadPool* pool = nullptr) const;
+
+  /** \brief Collapse the doubled quotes of a quoted field */
+  [[nodiscard]] static std::string Unquote(std::string_view field,
+                                           char quote = '"');
+
+ private:
+  std::string_view m_data;
+  CsvOptions m_options;
+};
+
+}  // namespace TextUtils
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_CSV_READER_HPP_
@@ -0,0 +1,256 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_METRICS_HPP_
+#define _JLTX_INCLUDE_UTIL_METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jltx {
+namespace metrics {
+
+/** Number of independent copies of every counter and histogram */
+static constexpr std::size_t NUM_SHARDS = 8;
+
+/** \return Shard of the calling thread, assigned round robin */
+std::size_t ThreadShard();
+
+/**
+ * @brief Monotonic counter that threads can increment without contending
+ *
+ * Every thread adds to one of NUM_SHARDS cache-line sized atomics, so
+ * increments from different threads rarely touch the same line.
+ */
+class Counter {
+ public:
+  void Add(uint64_t value = 1) {
+    m_shards[ThreadShard()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /** Sum of all shards */
+  [[nodiscard]] uint64_t Value() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value{0};
+  };
+  std::array<Shard, NUM_SHARDS> m_shards;
+};
+
+/** @brief Value that can go up and down, such as a queue depth */
+class Gauge {
+ public:
+  void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  void Add(int64_t value) {
+    m_value.fetch_add(value, std::memory_order_relaxed);
+  }
+  [[nodiscard]] int64_t Value() const {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+ private:
+  alignas(64) std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * @brief Contents of a Histogram at one point in time
+ *
+ * Buckets follow the HDR layout: values below 2^SUB_BUCKET_BITS have their own
+ * bucket and every further power of two is split in 2^SUB_BUCKET_BITS
+ * buckets, so every value is known within 1/16 of itself.
+ */
+struct HistogramSnapshot {
+  static constexpr unsigned SUB_BUCKET_BITS = 4;
+  static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+  static constexpr std::size_t NUM_BUCKETS = (65 - SUB_BUCKET_BITS) *
+                                             SUB_BUCKETS;
+
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+  std::vector<uint64_t> buckets = std::vector<uint64_t>(NUM_BUCKETS, 0);
+
+  /** Bucket that counts value */
+  static std::size_t BucketOf(uint64_t value) {
+    const auto msb =
+        63u - static_cast<unsigned>(std::countl_zero(value | 1));
+    if (msb < SUB_BUCKET_BITS) {
+      return static_cast<std::size_t>(value);
+    }
+    const unsigned shift = msb - SUB_BUCKET_BITS;
+    return ((shift + 1) << SUB_BUCKET_BITS) +
+           static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+  }
+
+  /** Smallest value counted by a bucket */
+  static uint64_t LowestOf(std::size_t bucket);
+
+  /** Add the values of another snapshot */
+  void Merge(const HistogramSnapshot& other);
+
+  [[nodiscard]] double Mean() const;
+
+  /**
+   * @brief Value below which a fraction of the recorded values lie
+   *
+   * @param percentile Percentile between 0 and 100
+   * @return Upper bound of the bucket holding the percentile, clamped to the
+   * recorded maximum, or 0 if the histogram is empty
+   */
+  [[nodiscard]] uint64_t Percentile(double percentile) const;
+};
+
+/**
+ * @brief Distribution of values such as latencies in ns
+ *
+ * Record() is lock-free: it increments a bucket and a few statistics of the
+ * calling thread's shard. Snapshot() merges all the shards.
+ */
+class Histogram {
+ public:
+  Histogram();
+
+  void Record(uint64_t value) {
+    Shard& shard = *m_shards[ThreadShard()];
+    shard.buckets[HistogramSnapshot::BucketOf(value)].fetch_add(
+        1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t min = shard.min.load(std::memory_order_relaxed);
+    while (value < min && !shard.min.compare_exchange_weak(
+                              min, value, std::memory_order_relaxed)) {
+    }
+    uint64_t max = shard.max.load(std::memory_order_relaxed);
+    while (value > max && !shard.max.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  [[nodiscard]] HistogramSnapshot Snapshot() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets{};
+  };
+  std::array<std::unique_ptr<Shard>, NUM_SHARDS> m_shards;
+};
+
+/** @brief Values of all the metrics of a registry at one point in time */
+struct MetricsSnapshot {
+  std::map<std::string, uint64_t> counters;
+  std::map<std::string, int64_t> gauges;
+  std::map<std::string, HistogramSnapshot> histograms;
+
+  /**
+   * @brief Combine with another snapshot, e.g. of another process
+   *
+   * Counters and histograms are added, gauges take the value of other.
+   */
+  void Merge(const MetricsSnapshot& other);
+
+  /** One line per metric; histograms show count, mean and percentiles */
+  [[nodiscard]] std::string ToText() const;
+
+  /** JSON object with "counters", "gauges" and "histograms" members */
+  [[nodiscard]] std::string ToJson() const;
+};
+
+/**
+ * @brief Named metrics
+ *
+ * Creating or looking up a metric takes a lock, so real-time code should
+ * get its metrics once during setup and keep the references, which stay
+ * valid as long as the registry.
+ */
+class MetricsRegistry {
+ public:
+  /** Registry shared by the whole library */
+  static MetricsRegistry& Global();
+
+  Counter& GetCounter(const std::string& name);
+  Gauge& GetGauge(const std::string& name);
+  Histogram& GetHistogram(const std::string& name);
+
+  [[nodiscard]] MetricsSnapshot Snapshot() const;
+
+ private:
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<Counter>> m_counters;
+  std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+  std::map<std::string, std::unique_ptr<Histogram>> m_histograms;
+};
+
+/**
+ * @brief Background thread that takes a snapshot of a registry every period
+ * and passes it to a callback, e.g. to dump it to a file
+ */
+class PeriodicSnapshot {
+ public:
+  using Callback = std::function<void(const MetricsSnapshot&)>;
+
+  PeriodicSnapshot(const MetricsRegistry& registry,
+                   std::chrono::milliseconds period, Callback callback);
+
+  /** Stops the thread after a last snapshot */
+  ~PeriodicSnapshot();
+
+  PeriodicSnapshot(const PeriodicSnapshot&) = delete;
+  PeriodicSnapshot& operator=(const PeriodicSnapshot&) = delete;
+
+ private:
+  const MetricsRegistry& m_registry;
+  const std::chrono::milliseconds m_period;
+  const Callback m_callback;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop = false;
+  std::thread m_thread;
+
+  void Run();
+};
+
+}  // namespace metrics
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_METRICS_HPP_
@@ -25,7 +25,12 @@
 #ifndef _JLTX_INCLUDE_UTIL_TEXT_UTILS_HPP_
 #define _JLTX_INCLUDE_UTIL_TEXT_UTILS_HPP_
 
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <ranges>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace jltx {
@@ -41,6 +46,21 @@ namespace TextUtils {
  */
 bool Equals(const std::string& str1, const std::string& str2);
 
+/** \brief Find the first occurrence of a delimiter at or after pos.
+ *
+ * Same result as std::string_view::find(). Delimiters of up to 16 characters
+ * are searched with SSE2/AVX2 when available, matching the first and last
+ * delimiter characters 16 or 32 positions at a time and verifying only the
+ * candidates.
+ *
+ * \param str String
+ * \param delimiter Delimiter string
+ * \param pos Position to start searching from
+ * \return Position of the delimiter, or std::string_view::npos
+ */
+std::size_t Find(std::string_view str, std::string_view delimiter,
+                 std::size_t pos = 0);
+
 /** \brief Split a string into substrings using another string as a delimiter.
  *
  * The substrings are returned in a std:vector<std::string>.
@@ -48,17 +68,178 @@ bool Equals(const std::string& str1, const std::string& str2);
  * Example: Split("127.0.0.1", ".") -> {"127", "0", "0", "1"}
  *
  * \param str String
- * \param str Delimiter string
+ * \param delimiter Delimiter string
  * \return std::vector containing the substrings
  */
 std::vector<std::string> Split(const std::string& str,
                                const std::string& delimiter);
 
+/** \brief Split a string into substrings allocated from a memory resource.
+ *
+ * Same result as Split(). The vector and the strings use resource, such as
+ * a jltx::memory::ArenaResource that is reset after every line, which takes
+ * the allocator off the hot path.
+ *
+ * \param str String
+ * \param delimiter Delimiter string
+ * \param resource Memory resource for the vector and the strings
+ * \return std::pmr::vector containing the substrings
+ */
+std::pmr::vector<std::pmr::string> Split(std::string_view str,
+                                         std::string_view delimiter,
+                                         std::pmr::memory_resource* resource);
+
+/** \brief Split a string into views of the substrings between delimiters.
+ *
+ * Same result as Split(), but no substring is copied. The views point into
+ * str and are only valid as long as the string they refer to.
+ *
+ * \param str String
+ * \param delimiter Delimiter string
+ * \return std::vector containing the views of the substrings
+ */
+std::vector<std::string_view> SplitView(std::string_view str,
+                                        std::string_view delimiter);
+
+/** \brief Call a function for every substring between delimiters.
+ *
+ * Visits the same substrings as Split(), in order, without allocating.
+ *
+ * \param str String
+ * \param delimiter Delimiter string
+ * \param callback Function called with a std::string_view of every substring
+ */
+template <typename Callback>
+void ForEachSplit(std::string_view str, std::string_view delimiter,
+                  Callback&& callback) {
+  if (str.empty() || delimiter.empty()) {
+    return;
+  }
+
+  std::size_t pos = 0;
+  while (true) {
+    const std::size_t found = Find(str, delimiter, pos);
+    if (found == std::string_view::npos) {
+      // The remaining substring is empty if the last characters are a delimiter
+      callback(str.substr(pos));
+      return;
+    }
+    callback(str.substr(pos, found - pos));
+    pos = found + delimiter.size();
+  }
+}
+
+/** \brief Write the views of the substrings between delimiters to an output
+ * iterator.
+ *
+ * \return Iterator past the last element written
+ */
+template <typename OutputIterator>
+OutputIterator SplitTo(std::string_view str, std::string_view delimiter,
+                       OutputIterator out) {
+  ForEachSplit(str, delimiter, [&](std::string_view token) { *out++ = token; });
+  return out;
+}
+
+/** \brief Lazy range over the substrings between delimiters.
+ *
+ * Every increment searches for the next delimiter, so nothing is allocated
+ * and iteration can stop early. It yields the same substrings as Split().
+ * <br>
+ * Example: for (std::string_view field : SplitRange(line, ",")) { ... }
+ */
+class SplitRange : public std::ranges::view_interface<SplitRange> {
+ public:
+  class Iterator {
+   public:
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    Iterator(std::string_view str, std::string_view delimiter)
+        : m_str(str), m_delimiter(delimiter), m_done(str.empty()) {
+      if (!m_done) {
+        FindEnd();
+      }
+    }
+
+    std::string_view operator*() const {
+      return m_str.substr(m_pos, m_end - m_pos);
+    }
+
+    Iterator& operator++() {
+      if (m_last) {
+        m_done = true;
+      } else {
+        m_pos = m_end + m_delimiter.size();
+        FindEnd();
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return (m_done == other.m_done) &&
+             (m_done || ((m_str.data() == other.m_str.data()) &&
+                         (m_pos == other.m_pos)));
+    }
+
+    bool operator==(std::default_sentinel_t) const { return m_done; }
+
+   private:
+    std::string_view m_str;
+    std::string_view m_delimiter;
+    std::size_t m_pos = 0;
+    std::size_t m_end = 0;
+    bool m_last = false;
+    bool m_done = true;
+
+    void FindEnd() {
+      const std::size_t found = TextUtils::Find(m_str, m_delimiter, m_pos);
+      m_last = (found == std::string_view::npos);
+      m_end = m_last ? m_str.size() : found;
+    }
+  };
+
+  SplitRange() = default;
+
+  SplitRange(std::string_view str, std::string_view delimiter)
+      : m_str(str), m_delimiter(delimiter) {}
+
+  [[nodiscard]] Iterator begin() const {
+    return m_delimiter.empty() ? Iterator() : Iterator(m_str, m_delimiter);
+  }
+
+  [[nodiscard]] std::default_sentinel_t end() const { return {}; }
+
+ private:
+  std::string_view m_str;
+  std::string_view m_delimiter;
+};
+
 /**
  * @brief Remove trailing whitespaces in place
+ *
+ * Whitespace is the "C" locale std::isspace() set: space, \\t, \\n, \\v,
+ * \\f and \\r. The remaining characters are moved at most once.
  */
 void Trim(std::string& str);
 
+/**
+ * @brief Return a view of str without leading and trailing whitespaces
+ *
+ * Nothing is copied or moved. Whitespace is classified 16 bytes at a time.
+ */
+[[nodiscard]] std::string_view TrimView(std::string_view str);
+
 /**
  * @brief Return a new string with all trailing whitespaces removed
  */
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _JLTX_INCLUDE_UTIL_THREAD_POOL_HPP_
+#define _JLTX_INCLUDE_UTIL_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jltx {
+
+/**
+ * @brief Fixed-size pool of worker threads for data-parallel loops
+ *
+ * The threads are created once and reused by every ParallelFor() call, so
+ * the pool can be used for many short parallel sections without paying for
+ * thread creation each time.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Create a pool
+   *
+   * @param num_threads Number of threads that run tasks, including the thread
+   * that calls ParallelFor(). A pool of size 1 runs everything on the caller.
+   */
+  explicit ThreadPool(std::size_t num_threads =
+                          std::max(1u, std::thread::hardware_concurrency()));
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /** Number of threads that run tasks, including the calling thread */
+  [[nodiscard]] std::size_t Size() const { return m_workers.size() + 1; }
+
+  /**
+   * @brief Run task(i) for every i in [0, count) and wait for all of them
+   *
+   * Indices are handed out dynamically, so tasks may run in any order and on
+   * any thread. The calling thread takes part in the work.
+   */
+  void ParallelFor(std::size_t count,
+                   const std::function<void(std::size_t)>& task);
+
+ private:
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_submit_mutex;
+  std::mutex m_mutex;
+  std::condition_variable m_start_cv;
+  std::condition_variable m_done_cv;
+
+  const std::function<void(std::size_t)>* m_task = nullptr;
+  std::size_t m_count = 0;
+  std::atomic<std::size_t> m_next{0};
+  std::size_t m_active = 0;
+  uint64_t m_generation = 0;
+  bool m_stop = false;
+
+  void WorkerLoop();
+  void RunTasks();
+};
+
+}  // namespace jltx
+
+#endif  // _JLTX_INCLUDE_UTIL_THREAD_POOL_HPP_
@@ -24,58 +24,648 @@
 
 #include "audio/AlsaAudioSink.hpp"
 
-#define PCM_DEVICE "default"
-#define CHANNELS 1
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "trace.hpp"
+#include "util/Clock.hpp"
 
 namespace jltx {
 namespace audio {
 
-AlsaAudioSink::AlsaAudioSink(uint32_t sample_rate) {
+static snd_pcm_format_t ToAlsaFormat(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::S16:
+      return SND_PCM_FORMAT_S16;
+    case SampleFormat::S24:
+      return SND_PCM_FORMAT_S24;
+    case SampleFormat::S32:
+      return SND_PCM_FORMAT_S32;
+    default:
+      return SND_PCM_FORMAT_FLOAT;
+  }
+}
+
+std::string AlsaStreamInfo::ToText() const {
+  char text[256];
+  snprintf(text, sizeof(text),
+           "sample_rate %u\nchannels %u\nformat %s\naccess %s\n"
+           "period_frames %u\nbuffer_frames %u\nstart_threshold %u\n",
+           sample_rate, channels, FormatName(format),
+           access == AccessMode::MMAP ? "MMAP" : "RW", period_frames,
+           buffer_frames, start_threshold);
+  return text;
+}
+
+AlsaAudioSink::AlsaAudioSink(uint32_t sample_rate, AccessMode access,
+                             const char* device)
+    : AlsaAudioSink(AlsaConfig{
+          .device = device, .sample_rate = sample_rate, .access = access}) {}
+
+AlsaAudioSink::AlsaAudioSink(const AlsaConfig& config)
+    : m_requested_start_threshold(config.start_threshold),
+      m_nonblocking(config.nonblocking),
+      m_frame_bytes(config.channels * BytesPerSample(config.format)),
+      m_frames_written(metrics::MetricsRegistry::Global().GetCounter(
+          "audio.alsa.frames_written")),
+      m_xruns(
+          metrics::MetricsRegistry::Global().GetCounter("audio.alsa.xruns")),
+      m_write_latency(metrics::MetricsRegistry::Global().GetHistogram(
+          "audio.alsa.write_latency_ns")),
+      m_wakeup_jitter(metrics::MetricsRegistry::Global().GetHistogram(
+          "audio.alsa.wakeup_jitter_ns")),
+      m_ring_underruns(metrics::MetricsRegistry::Global().GetCounter(
+          "audio.alsa.ring_underruns")),
+      m_ring_depth(metrics::MetricsRegistry::Global().GetGauge(
+          "audio.alsa.ring_depth")) {
+  // Report the request until the device has negotiated it
+  m_info.sample_rate = config.sample_rate;
+  m_info.channels = config.channels;
+  m_info.format = config.format;
+  m_info.access = config.access;
+
+  m_error = Configure(config);
+  if (m_error < 0) {
+    if (m_pcm_handle != nullptr) {
+      snd_pcm_close(m_pcm_handle);
+      m_pcm_handle = nullptr;
+    }
+    return;
+  }
+
+  m_planes.resize(m_info.channels);
+  m_period_buffer.assign(
+      std::size_t{m_info.period_frames} * m_info.channels, 0.0f);
+  if (m_info.access == AccessMode::RW) {
+    m_convert_buffer.resize(m_info.period_frames * m_frame_bytes);
+  }
+}
+
+int AlsaAudioSink::Configure(const AlsaConfig& config) {
+  int ret = snd_pcm_open(&m_pcm_handle, config.device,
+                         SND_PCM_STREAM_PLAYBACK,
+                         config.nonblocking ? SND_PCM_NONBLOCK : 0);
+  if (ret < 0) {
+    m_pcm_handle = nullptr;
+    return ret;
+  }
+
   snd_pcm_hw_params_t* hw_params;
+  if ((ret = snd_pcm_hw_params_malloc(&hw_params)) < 0) {
+    return ret;
+  }
+  const std::unique_ptr<snd_pcm_hw_params_t, void (*)(snd_pcm_hw_params_t*)>
+      hw_params_owner(hw_params, snd_pcm_hw_params_free);
 
-  snd_pcm_open(&m_pcm_handle, PCM_DEVICE, SND_PCM_STREAM_PLAYBACK, 0);
+  if ((ret = snd_pcm_hw_params_any(m_pcm_handle, hw_params)) < 0) {
+    return ret;
+  }
+  if ((ret = snd_pcm_hw_params_set_access(
+           m_pcm_handle, hw_params,
+           config.access == AccessMode::MMAP
+               ? SND_PCM_ACCESS_MMAP_INTERLEAVED
+               : SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+    return ret;
+  }
+  if ((ret = snd_pcm_hw_params_set_format(m_pcm_handle, hw_params,
+                                          ToAlsaFormat(config.format))) < 0) {
+    return ret;
+  }
+  if ((ret = snd_pcm_hw_params_set_channels(m_pcm_handle, hw_params,
+                                            config.channels)) < 0) {
+    return ret;
+  }
+  unsigned int rate = config.sample_rate;
+  if ((ret = snd_pcm_hw_params_set_rate_near(m_pcm_handle, hw_params, &rate,
+                                             nullptr)) < 0) {
+    return ret;
+  }
+  if (config.period_frames > 0) {
+    snd_pcm_uframes_t period_frames = config.period_frames;
+    if ((ret = snd_pcm_hw_params_set_period_size_near(
+             m_pcm_handle, hw_params, &period_frames, nullptr)) < 0) {
+      return ret;
+    }
+  }
+  if (config.periods > 0) {
+    unsigned int periods = config.periods;
+    if ((ret = snd_pcm_hw_params_set_periods_near(m_pcm_handle, hw_params,
+                                                  &periods, nullptr)) < 0) {
+      return ret;
+    }
+  }
+  if ((ret = snd_pcm_hw_params(m_pcm_handle, hw_params)) < 0) {
+    return ret;
+  }
 
-  snd_pcm_hw_params_malloc(&hw_params);
-  snd_pcm_hw_params_any(m_pcm_handle, hw_params);
+  unsigned int channels;
+  snd_pcm_uframes_t period_frames;
+  snd_pcm_uframes_t buffer_frames;
+  if ((ret = snd_pcm_hw_params_get_rate(hw_params, &rate, nullptr)) < 0 ||
+      (ret = snd_pcm_hw_params_get_channels(hw_params, &channels)) < 0 ||
+      (ret = snd_pcm_hw_params_get_period_size(hw_params, &period_frames,
+                                               nullptr)) < 0 ||
+      (ret = snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_frames)) <
+          0) {
+    return ret;
+  }
+  m_info.sample_rate = rate;
+  m_info.channels = channels;
+  m_info.period_frames = static_cast<uint32_t>(period_frames);
+  m_info.buffer_frames = static_cast<uint32_t>(buffer_frames);
 
-  snd_pcm_hw_params_set_access(m_pcm_handle, hw_params,
-                               SND_PCM_ACCESS_RW_INTERLEAVED);
-  snd_pcm_hw_params_set_format(m_pcm_handle, hw_params, SND_PCM_FORMAT_FLOAT);
-  snd_pcm_hw_params_set_channels(m_pcm_handle, hw_params, CHANNELS);
-  snd_pcm_hw_params_set_rate_near(m_pcm_handle, hw_params, &sample_rate, 0);
-  snd_pcm_hw_params(m_pcm_handle, hw_params);
+  if ((ret = ConfigureSoftware(config.start_threshold)) < 0) {
+    return ret;
+  }
+  return snd_pcm_prepare(m_pcm_handle);
+}
+
+int AlsaAudioSink::ConfigureSoftware(snd_pcm_uframes_t start_threshold) {
+  snd_pcm_sw_params_t* sw_params;
+  int ret = snd_pcm_sw_params_malloc(&sw_params);
+  if (ret < 0) {
+    return ret;
+  }
+  const std::unique_ptr<snd_pcm_sw_params_t, void (*)(snd_pcm_sw_params_t*)>
+      sw_params_owner(sw_params, snd_pcm_sw_params_free);
 
-  unsigned int reported_sample_rate;
-  snd_pcm_hw_params_get_rate(hw_params, &reported_sample_rate, 0);
-  m_sample_rate = reported_sample_rate;
+  if ((ret = snd_pcm_sw_params_current(m_pcm_handle, sw_params)) < 0) {
+    return ret;
+  }
+  if (start_threshold > 0 &&
+      (ret = snd_pcm_sw_params_set_start_threshold(m_pcm_handle, sw_params,
+                                                   start_threshold)) < 0) {
+    return ret;
+  }
+  // Wake up once per period
+  if ((ret = snd_pcm_sw_params_set_avail_min(m_pcm_handle, sw_params,
+                                             m_info.period_frames)) < 0) {
+    return ret;
+  }
+  if ((ret = snd_pcm_sw_params(m_pcm_handle, sw_params)) < 0) {
+    return ret;
+  }
 
-  snd_pcm_hw_params_free(hw_params);
-  snd_pcm_prepare(m_pcm_handle);
+  snd_pcm_uframes_t threshold;
+  if ((ret = snd_pcm_sw_params_get_start_threshold(sw_params, &threshold)) <
+      0) {
+    return ret;
+  }
+  m_info.start_threshold = static_cast<uint32_t>(threshold);
+  return 0;
 }
 
 AlsaAudioSink::~AlsaAudioSink() {
-  snd_pcm_drain(m_pcm_handle);
-  snd_pcm_close(m_pcm_handle);
+  StopPlayback();
+  if (IsOpen()) {
+    snd_pcm_drain(m_pcm_handle);
+    snd_pcm_close(m_pcm_handle);
+  }
+}
+
+template <typename Convert>
+uint32_t AlsaAudioSink::WriteConverted(uint32_t frames, Convert&& convert) {
+  uint32_t written = 0;
+  while (written < frames) {
+    uint32_t count;
+    if (m_info.access == AccessMode::MMAP) {
+      char* area = BeginArea(frames - written, count);
+      if (area == nullptr) {
+        break;
+      }
+      convert(area, written, count);
+      count = CommitWrite(count);
+    } else {
+      // The conversion buffer holds one period
+      count = std::min(frames - written, m_info.period_frames);
+      convert(m_convert_buffer.data(), written, count);
+      count = WriteDevice(m_convert_buffer.data(), count);
+    }
+    if (count == 0) {
+      break;
+    }
+    written += count;
+  }
+  return written;
+}
+
+template <typename Source>
+uint32_t AlsaAudioSink::WriteRendered(uint32_t frames, Source&& source) {
+  const std::size_t channels = m_info.channels;
+  uint32_t written = 0;
+
+  if (m_info.access == AccessMode::MMAP &&
+      m_info.format == SampleFormat::FLOAT) {
+    // Render straight into the device buffer, in two parts if it wraps
+    while (written < frames) {
+      const std::span<float> area =
+          BeginWrite(std::min(frames - written, m_info.period_frames));
+      if (area.empty()) {
+        break;
+      }
+      source(area);
+      const uint32_t count =
+          CommitWrite(static_cast<uint32_t>(area.size() / channels));
+      if (count == 0) {
+        break;
+      }
+      written += count;
+    }
+    return written;
+  }
+
+  while (written < frames) {
+    const uint32_t count = std::min(frames - written, m_info.period_frames);
+    const std::span<float> block =
+        std::span<float>(m_period_buffer).first(count * channels);
+    source(block);
+    uint32_t done;
+    if (m_info.access == AccessMode::RW &&
+        m_info.format == SampleFormat::FLOAT) {
+      done = WriteDevice(block.data(), count);
+    } else {
+      const auto convert = [&](char* out, uint32_t first, uint32_t n) {
+        ConvertFromFloat(block.subspan(first * channels, n * channels),
+                         m_info.format, out);
+      };
+      done = WriteConverted(count, convert);
+    }
+    written += done;
+    if (done < count) {
+      break;
+    }
+  }
+  return written;
+}
+
+uint32_t AlsaAudioSink::Send(const float* buffer, uint32_t size) {
+  JLTX_TRACE_FUNCTION();
+  if (!IsOpen() || size == 0) {  // Nothing to write
+    return 0;
+  }
+
+  if (m_playback_thread.joinable()) {
+    if (m_render) {  // The thread does not read the queue
+      return 0;
+    }
+    const auto wait = std::chrono::nanoseconds(
+        uint64_t{m_info.period_frames} * 1000000000 /
+        std::max(m_info.sample_rate, 1u) / 2);
+    const std::size_t channels = m_info.channels;
+    uint32_t sent = 0;
+    while (sent < size) {
+      sent += Enqueue(buffer + sent * channels, size - sent);
+      // Nothing drains the ring once the thread has stopped on an error
+      if (sent == size || m_playback_exited.load(std::memory_order_acquire)) {
+        break;
+      }
+      std::this_thread::sleep_for(wait);
+    }
+    return sent;
+  }
+
+  if (m_info.access == AccessMode::RW &&
+      m_info.format == SampleFormat::FLOAT) {
+    return WriteDevice(buffer, size);
+  }
+
+  const std::size_t channels = m_info.channels;
+  return WriteConverted(size, [&](char* out, uint32_t first, uint32_t count) {
+    ConvertFromFloat({buffer + first * channels, count * channels},
+                     m_info.format, out);
+  });
+}
+
+uint32_t AlsaAudioSink::SendPlanar(std::span<const float* const> planes,
+                                   uint32_t size) {
+  JLTX_TRACE_FUNCTION();
+  if (!IsOpen() || size == 0 || planes.size() != m_info.channels ||
+      m_playback_thread.joinable()) {
+    return 0;
+  }
+
+  return WriteConverted(size, [&](char* out, uint32_t first, uint32_t count) {
+    for (std::size_t c = 0; c < planes.size(); ++c) {
+      m_planes[c] = planes[c] + first;
+    }
+    InterleaveFromFloat(m_planes, count, m_info.format, out);
+  });
+}
+
+std::vector<pollfd> AlsaAudioSink::PollDescriptors() {
+  if (!IsOpen()) {
+    return {};
+  }
+  const int count = snd_pcm_poll_descriptors_count(m_pcm_handle);
+  if (count <= 0) {
+    return {};
+  }
+  std::vector<pollfd> fds(static_cast<std::size_t>(count));
+  const int filled = snd_pcm_poll_descriptors(
+      m_pcm_handle, fds.data(), static_cast<unsigned int>(count));
+  fds.resize(static_cast<std::size_t>(std::max(filled, 0)));
+  return fds;
 }
 
-uint32_t AlsaAudioSink::Send(float* buffer, uint32_t size) {
-  if (size == 0) {  // Nothing to write
+unsigned short AlsaAudioSink::PollRevents(std::span<pollfd> fds) {
+  unsigned short revents = 0;
+  if (!IsOpen() || snd_pcm_poll_descriptors_revents(
+                       m_pcm_handle, fds.data(),
+                       static_cast<unsigned int>(fds.size()), &revents) < 0) {
+    return POLLERR;
+  }
+  return revents;
+}
+
+uint32_t AlsaAudioSink::Pump(const RenderCallback& render,
+                             uint32_t max_frames) {
+  JLTX_TRACE_FUNCTION();
+  if (!IsOpen() || !render || m_playback_thread.joinable()) {
+    return 0;
+  }
+
+  const snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm_handle);
+  if (avail < 0) {
+    Recover(static_cast<int>(avail));
     return 0;
   }
+  const auto frames = static_cast<uint32_t>(
+      std::min(static_cast<snd_pcm_uframes_t>(avail),
+               static_cast<snd_pcm_uframes_t>(max_frames)));
+  const uint32_t written = WriteRendered(frames, render);
+
+  // A start threshold above the buffer size never triggers by itself
+  if (snd_pcm_state(m_pcm_handle) == SND_PCM_STATE_PREPARED &&
+      snd_pcm_avail_update(m_pcm_handle) == 0) {
+    snd_pcm_start(m_pcm_handle);
+  }
+  return written;
+}
+
+uint32_t AlsaAudioSink::WriteDevice(const void* data, uint32_t frames) {
+  const int64_t start = NowNs();
+  const snd_pcm_sframes_t ret = snd_pcm_writei(m_pcm_handle, data, frames);
+  m_write_latency.Record(static_cast<uint64_t>(NowNs() - start));
+  if (ret == -EAGAIN) {  // Non-blocking and the buffer is full
+    return 0;
+  }
+  if (ret < 0) {
+    JLTX_TRACE_ZONE("AlsaAudioSink::WriteDevice recover");
+    Recover(static_cast<int>(ret));
+    return 0;
+  }
+  m_frames_written.Add(static_cast<uint64_t>(ret));
+  return static_cast<uint32_t>(ret);
+}
+
+std::span<float> AlsaAudioSink::BeginWrite(uint32_t max_frames) {
+  if (m_info.format != SampleFormat::FLOAT) {
+    return {};
+  }
+  uint32_t frames;
+  char* area = BeginArea(max_frames, frames);
+  if (area == nullptr) {
+    return {};
+  }
+  return {reinterpret_cast<float*>(area), frames * m_info.channels};
+}
 
-  snd_pcm_sframes_t ret = snd_pcm_writei(m_pcm_handle, buffer, size);
-  if (ret > 0) {
-    return static_cast<uint32_t>(ret);
-  } else {
-    if (ret == -EPIPE) {
-      snd_pcm_prepare(m_pcm_handle);
+char* AlsaAudioSink::BeginArea(uint32_t max_frames, uint32_t& frames) {
+  JLTX_TRACE_FUNCTION();
+  if (!IsOpen() || m_info.access != AccessMode::MMAP || max_frames == 0) {
+    return nullptr;
+  }
+
+  snd_pcm_sframes_t avail;
+  for (;;) {
+    avail = snd_pcm_avail_update(m_pcm_handle);
+    if (avail < 0) {
+      if (!Recover(static_cast<int>(avail))) {
+        return nullptr;
+      }
+    } else if (avail > 0) {
+      break;
+    } else {
+      // The ring buffer is full: start playing it and wait for room, unless
+      // the device must not block
+      if (snd_pcm_state(m_pcm_handle) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(m_pcm_handle);
+      }
+      if (m_nonblocking) {
+        return nullptr;
+      }
+      const int ret = snd_pcm_wait(m_pcm_handle, 1000);
+      if (ret < 0 && !Recover(ret)) {
+        return nullptr;
+      }
     }
+  }
+
+  const snd_pcm_channel_area_t* areas;
+  snd_pcm_uframes_t offset;
+  snd_pcm_uframes_t count =
+      std::min(static_cast<snd_pcm_uframes_t>(max_frames),
+               static_cast<snd_pcm_uframes_t>(avail));
+  const int ret = snd_pcm_mmap_begin(m_pcm_handle, &areas, &offset, &count);
+  if (ret < 0) {
+    Recover(ret);
+    return nullptr;
+  }
+  m_mmap_offset = offset;
+  m_mmap_frames = count;
+  frames = static_cast<uint32_t>(count);
+
+  // Interleaved channels share the first area, one frame every step bits
+  char* base = static_cast<char*>(areas[0].addr);
+  return base + areas[0].first / 8 + offset * areas[0].step / 8;
+}
+
+uint32_t AlsaAudioSink::CommitWrite(uint32_t frames) {
+  if (!IsOpen() || m_info.access != AccessMode::MMAP) {
+    return 0;
+  }
+  const snd_pcm_uframes_t count =
+      std::min(static_cast<snd_pcm_uframes_t>(frames), m_mmap_frames);
+  const snd_pcm_sframes_t ret =
+      snd_pcm_mmap_commit(m_pcm_handle, m_mmap_offset, count);
+  m_mmap_frames = 0;
+  if (ret < 0 || static_cast<snd_pcm_uframes_t>(ret) != count) {
+    Recover(ret < 0 ? static_cast<int>(ret) : -EPIPE);
+    return 0;
+  }
+  m_frames_written.Add(count);
+  return static_cast<uint32_t>(count);
+}
+
+bool AlsaAudioSink::StartPlayback(PlaybackOptions options) {
+  if (!IsOpen() || m_playback_thread.joinable() ||
+      m_info.period_frames == 0) {
+    return false;
+  }
+
+  // Unless configured otherwise, start once the whole buffer is filled
+  if (ConfigureSoftware(m_requested_start_threshold > 0
+                            ? m_requested_start_threshold
+                            : m_info.buffer_frames) < 0) {
+    return false;
+  }
+
+  m_memory_locked =
+      options.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+  m_render = std::move(options.render);
+  m_ring = std::make_unique<SpscRing<float>>(
+      m_period_buffer.size() * std::max(options.ring_periods, 1u));
+  m_stop.store(false, std::memory_order_relaxed);
+  m_playback_exited.store(false, std::memory_order_relaxed);
+  m_playback_thread = std::thread(&AlsaAudioSink::PlaybackLoop, this,
+                                  options.realtime, options.priority);
+  return true;
+}
+
+void AlsaAudioSink::StopPlayback() {
+  if (!m_playback_thread.joinable()) {
+    return;
+  }
+  m_stop.store(true, std::memory_order_release);
+  m_playback_thread.join();
+  m_realtime.store(false, std::memory_order_relaxed);
+  m_render = nullptr;
+}
+
+uint32_t AlsaAudioSink::Enqueue(const float* buffer, uint32_t size) {
+  if (!m_ring) {
     return 0;
   }
+  // Whole frames only, so that the thread never reads part of one
+  const std::size_t channels = m_info.channels;
+  const std::size_t frames = std::min<std::size_t>(
+      size, (m_ring->Capacity() - m_ring->FillLevel()) / channels);
+  m_ring->Write(std::span<const float>(buffer, frames * channels));
+  return static_cast<uint32_t>(frames);
+}
+
+void AlsaAudioSink::PlaybackLoop(bool realtime, int priority) {
+  if (realtime) {
+    sched_param param{};
+    param.sched_priority = priority;
+    m_realtime.store(
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0,
+        std::memory_order_relaxed);
+  }
+
+  const auto period_ns = static_cast<int64_t>(
+      uint64_t{m_info.period_frames} * 1000000000 /
+      std::max(m_info.sample_rate, 1u));
+  int64_t last_wakeup = 0;
+
+  while (!m_stop.load(std::memory_order_acquire)) {
+    const snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm_handle);
+    if (avail < 0) {
+      last_wakeup = 0;
+      if (!RecoverOrWait(static_cast<int>(avail))) {
+        break;
+      }
+      continue;
+    }
+
+    if (static_cast<snd_pcm_uframes_t>(avail) < m_info.period_frames) {
+      if (snd_pcm_state(m_pcm_handle) == SND_PCM_STATE_PREPARED) {
+        snd_pcm_start(m_pcm_handle);  // The buffer is full
+      }
+      // Bounded wait, so that StopPlayback() is noticed
+      const int ret = snd_pcm_wait(m_pcm_handle, 100);
+      if (ret < 0) {
+        last_wakeup = 0;
+        if (!RecoverOrWait(ret)) {
+          break;
+        }
+        continue;
+      }
+
+      const int64_t now = NowNs();
+      if (last_wakeup != 0) {
+        const int64_t jitter = now - last_wakeup - period_ns;
+        m_wakeup_jitter.Record(
+            static_cast<uint64_t>(jitter < 0 ? -jitter : jitter));
+      }
+      last_wakeup =
+          snd_pcm_state(m_pcm_handle) == SND_PCM_STATE_RUNNING ? now : 0;
+      continue;
+    }
+
+    JLTX_TRACE_ZONE("AlsaAudioSink period");
+    if (!WritePeriod()) {
+      last_wakeup = 0;
+    }
+    if (m_ring) {
+      m_ring_depth.Set(
+          static_cast<int64_t>(m_ring->FillLevel() / m_info.channels));
+    }
+  }
+  m_playback_exited.store(true, std::memory_order_release);
+}
+
+bool AlsaAudioSink::WritePeriod() {
+  const auto render = [this](std::span<float> out) { RenderPeriod(out); };
+  return WriteRendered(m_info.period_frames, render) == m_info.period_frames;
+}
+
+void AlsaAudioSink::RenderPeriod(std::span<float> out) {
+  if (m_render) {
+    m_render(out);
+    return;
+  }
+  const std::size_t read = m_ring->Read(out);
+  if (read < out.size()) {
+    std::fill(out.begin() + static_cast<std::ptrdiff_t>(read), out.end(),
+              0.0f);
+    m_ring_underruns.Add();
+  }
+}
+
+bool AlsaAudioSink::Recover(int error) {
+  if (error == -EPIPE) {
+    m_xruns.Add();
+  }
+  if (!m_nonblocking) {
+    return snd_pcm_recover(m_pcm_handle, error, 1) == 0;
+  }
+
+  // snd_pcm_recover() sleeps until a suspended device has resumed
+  if (error == -EPIPE) {
+    return snd_pcm_prepare(m_pcm_handle) == 0;
+  }
+  if (error == -ESTRPIPE) {
+    const int ret = snd_pcm_resume(m_pcm_handle);
+    if (ret == -EAGAIN) {  // Still resuming, try again on the next call
+      return false;
+    }
+    return ret == 0 || snd_pcm_prepare(m_pcm_handle) == 0;
+  }
+  return false;
+}
+
+bool AlsaAudioSink::RecoverOrWait(int error) {
+  if (Recover(error)) {
+    return true;
+  }
+  if (snd_pcm_state(m_pcm_handle) != SND_PCM_STATE_SUSPENDED) {
+    return false;
+  }
+  // Still resuming: try again shortly, still noticing StopPlayback()
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return true;
 }
 
 [[nodiscard]] uint32_t AlsaAudioSink::SampleRate() const {
-  return m_sample_rate;
+  return m_info.sample_rate;
 }
 
 }  // namespace audio
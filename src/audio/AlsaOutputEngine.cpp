@@ -0,0 +1,280 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio/AlsaOutputEngine.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "trace.hpp"
+#include "util/Clock.hpp"
+
+namespace jltx {
+namespace audio {
+
+/** Events handled per epoll_wait() */
+static constexpr int MAX_EVENTS = 64;
+
+// The epoll data holds the device slot in the high half and the descriptor
+// index, or one of these, in the low half
+static constexpr uint32_t TIMER_INDEX = UINT32_MAX;
+static constexpr uint64_t WAKE_KEY = UINT64_MAX;
+
+static uint64_t Key(std::size_t slot, uint32_t index) {
+  return (static_cast<uint64_t>(slot) << 32) | index;
+}
+
+AlsaOutputEngine::AlsaOutputEngine()
+    : m_epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+      m_wake_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      m_service_time(metrics::MetricsRegistry::Global().GetHistogram(
+          "audio.engine.service_ns")) {
+  if (IsValid()) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_KEY;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &event);
+  }
+}
+
+AlsaOutputEngine::~AlsaOutputEngine() {
+  Stop();
+  for (const auto& device : m_devices) {
+    if (device) {
+      Unregister(*device);
+    }
+  }
+  if (m_wake_fd >= 0) {
+    close(m_wake_fd);
+  }
+  if (m_epoll_fd >= 0) {
+    close(m_epoll_fd);
+  }
+}
+
+bool AlsaOutputEngine::Add(AlsaAudioSink& sink, RenderCallback render) {
+  if (!IsValid() || m_thread.joinable() || !sink.IsOpen() ||
+      !sink.NonBlocking() || !render || sink.PeriodFrames() == 0) {
+    return false;
+  }
+
+  auto device = std::make_unique<Device>();
+  device->sink = &sink;
+  device->render = std::move(render);
+  device->fds = sink.PollDescriptors();
+  if (device->fds.empty()) {
+    return false;
+  }
+
+  const std::size_t slot = m_devices.size();
+  bool pollable = true;
+  for (std::size_t i = 0; i < device->fds.size(); ++i) {
+    epoll_event event{};
+    event.events = static_cast<uint32_t>(device->fds[i].events);
+    event.data.u64 = Key(slot, static_cast<uint32_t>(i));
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, device->fds[i].fd, &event) <
+        0) {
+      if (errno != EPERM) {
+        Unregister(*device);
+        return false;
+      }
+      pollable = false;
+    }
+  }
+
+  if (!pollable) {
+    // Not a pollable file, so stand in for the period interrupt
+    Unregister(*device);
+    device->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK |
+                                                           TFD_CLOEXEC);
+    if (device->timer_fd < 0) {
+      return false;
+    }
+    const uint64_t period_ns = uint64_t{sink.PeriodFrames()} * 1000000000 /
+                               std::max(sink.SampleRate(), 1u);
+    itimerspec spec{};
+    spec.it_interval.tv_sec = static_cast<time_t>(period_ns / 1000000000);
+    spec.it_interval.tv_nsec = static_cast<long>(period_ns % 1000000000);
+    spec.it_value.tv_nsec = 1;  // First tick right away
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = Key(slot, TIMER_INDEX);
+    if (timerfd_settime(device->timer_fd, 0, &spec, nullptr) < 0 ||
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, device->timer_fd, &event) < 0) {
+      Unregister(*device);
+      return false;
+    }
+  }
+
+  m_devices.push_back(std::move(device));
+  m_ready.reserve(m_devices.size());
+  return true;
+}
+
+bool AlsaOutputEngine::Remove(AlsaAudioSink& sink) {
+  if (m_thread.joinable()) {
+    return false;
+  }
+  for (auto& device : m_devices) {
+    if (device && device->sink == &sink) {
+      Unregister(*device);
+      device.reset();
+      return true;
+    }
+  }
+  return false;
+}
+
+void AlsaOutputEngine::Unregister(Device& device) {
+  // Errors are expected for descriptors that were never added
+  for (const pollfd& fd : device.fds) {
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd.fd, nullptr);
+  }
+  if (device.timer_fd >= 0) {
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, device.timer_fd, nullptr);
+    close(device.timer_fd);
+    device.timer_fd = -1;
+  }
+}
+
+std::size_t AlsaOutputEngine::Size() const {
+  return static_cast<std::size_t>(
+      std::count_if(m_devices.begin(), m_devices.end(),
+                    [](const auto& device) { return device != nullptr; }));
+}
+
+int AlsaOutputEngine::RunOnce(int timeout_ms) {
+  epoll_event events[MAX_EVENTS];
+  const int count = epoll_wait(m_epoll_fd, events, MAX_EVENTS, timeout_ms);
+  if (count < 0) {
+    return errno == EINTR ? 0 : -1;
+  }
+
+  JLTX_TRACE_ZONE("AlsaOutputEngine wakeup");
+  const int64_t start = NowNs();
+
+  // A device may own several descriptors: collect them all before asking
+  // ALSA what they mean
+  m_ready.clear();
+  for (int i = 0; i < count; ++i) {
+    const uint64_t key = events[i].data.u64;
+    uint64_t value;
+    if (key == WAKE_KEY) {
+      [[maybe_unused]] const ssize_t ret =
+          read(m_wake_fd, &value, sizeof(value));
+      continue;
+    }
+    Device* device = m_devices[key >> 32].get();
+    if (device == nullptr) {
+      continue;
+    }
+    const auto index = static_cast<uint32_t>(key);
+    if (index == TIMER_INDEX) {
+      if (read(device->timer_fd, &value, sizeof(value)) ==
+          static_cast<ssize_t>(sizeof(value))) {
+        device->timer_ticks += value;
+      }
+    } else {
+      device->fds[index].revents = static_cast<short>(events[i].events);
+    }
+    if (!device->ready) {
+      device->ready = true;
+      m_ready.push_back(device);
+    }
+  }
+
+  int serviced = 0;
+  for (Device* device : m_ready) {
+    device->ready = false;
+    uint32_t max_frames = UINT32_MAX;
+    if (device->timer_fd >= 0) {
+      // A late wakeup catches up on every period missed, within what the
+      // device has room for
+      max_frames = static_cast<uint32_t>(
+          std::min<uint64_t>(std::max<uint64_t>(device->timer_ticks, 1) *
+                                 device->sink->PeriodFrames(),
+                             UINT32_MAX));
+      device->timer_ticks = 0;
+    } else {
+      const unsigned short revents = device->sink->PollRevents(device->fds);
+      for (pollfd& fd : device->fds) {
+        fd.revents = 0;
+      }
+      // On POLLERR, Pump() finds the xrun and recovers
+      if ((revents & (POLLOUT | POLLERR)) == 0) {
+        continue;
+      }
+    }
+    device->sink->Pump(device->render, max_frames);
+    ++serviced;
+  }
+
+  if (serviced > 0) {
+    m_service_time.Record(static_cast<uint64_t>(NowNs() - start));
+  }
+  return serviced;
+}
+
+bool AlsaOutputEngine::Start(bool realtime, int priority) {
+  if (!IsValid() || m_thread.joinable()) {
+    return false;
+  }
+  m_stop.store(false, std::memory_order_relaxed);
+  m_thread = std::thread([this, realtime, priority] {
+    if (realtime) {
+      sched_param param{};
+      param.sched_priority = priority;
+      m_realtime.store(
+          pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0,
+          std::memory_order_relaxed);
+    }
+    while (!m_stop.load(std::memory_order_acquire)) {
+      if (RunOnce(-1) < 0) {
+        break;
+      }
+    }
+  });
+  return true;
+}
+
+void AlsaOutputEngine::Stop() {
+  if (!m_thread.joinable()) {
+    return;
+  }
+  m_stop.store(true, std::memory_order_release);
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t ret = write(m_wake_fd, &one, sizeof(one));
+  m_thread.join();
+  m_realtime.store(false, std::memory_order_relaxed);
+}
+
+}  // namespace audio
+}  // namespace jltx
@@ -0,0 +1,300 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio/FileAudioSink.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace jltx {
+namespace audio {
+
+static_assert(std::endian::native == std::endian::little,
+              "WAV samples are stored in native byte order");
+
+/** Size of a plain PCM or IEEE float header */
+static constexpr std::size_t WAV_HEADER_BYTES = 44;
+
+/** Size of a WAVE_FORMAT_EXTENSIBLE header */
+static constexpr std::size_t WAV_EXTENSIBLE_HEADER_BYTES = 68;
+
+static constexpr uint16_t WAVE_FORMAT_PCM = 1;
+static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+static constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+/** KSDATAFORMAT_SUBTYPE GUID without its leading format tag */
+static constexpr char SUBTYPE_GUID_TAIL[] =
+    "\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71";
+
+static char* Put(char* out, uint32_t value, std::size_t bytes) {
+  for (std::size_t i = 0; i < bytes; ++i) {
+    *out++ = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+  return out;
+}
+
+static char* Put(char* out, const char* tag) {
+  std::memcpy(out, tag, 4);
+  return out + 4;
+}
+
+/**
+ * More than two channels and samples with padding bits need
+ * WAVE_FORMAT_EXTENSIBLE
+ */
+static bool IsExtensible(const FileSinkConfig& config) {
+  return config.channels > 2 || config.format == SampleFormat::S24;
+}
+
+/** WAV keeps the valid bits of padded samples in the high bits */
+static void LeftJustifyS24(char* out, std::size_t count) {
+  auto* words = reinterpret_cast<uint32_t*>(out);
+  for (std::size_t i = 0; i < count; ++i) {
+    words[i] <<= 8;
+  }
+}
+
+static std::size_t HeaderBytes(const FileSinkConfig& config) {
+  if (config.container == FileContainer::RAW) {
+    return 0;
+  }
+  return IsExtensible(config) ? WAV_EXTENSIBLE_HEADER_BYTES
+                              : WAV_HEADER_BYTES;
+}
+
+FileAudioSink::FileAudioSink(const FileSinkConfig& config)
+    : m_config(config),
+      m_sample_bytes(BytesPerSample(config.format)),
+      m_header_bytes(HeaderBytes(config)),
+      m_window_size(std::max(
+          (config.buffer_size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE,
+          BLOCK_SIZE)) {
+  if (m_config.path == nullptr || m_config.channels == 0) {
+    m_error = EINVAL;
+    return;
+  }
+
+  int flags = O_CREAT | O_TRUNC | O_CLOEXEC;
+  flags |= (m_config.mode == FileWriteMode::MMAP) ? O_RDWR : O_WRONLY;
+  if (m_config.mode == FileWriteMode::DIRECT) {
+    flags |= O_DIRECT;
+  }
+  m_fd = open(m_config.path, flags, 0644);
+  if (m_fd < 0) {
+    m_error = errno;
+    return;
+  }
+
+  void* window = nullptr;
+  if (m_config.mode == FileWriteMode::MMAP) {
+    if (ftruncate(m_fd, static_cast<off_t>(m_window_size)) == 0) {
+      window = mmap(nullptr, m_window_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, m_fd, 0);
+    }
+    window = (window == MAP_FAILED) ? nullptr : window;
+  } else {
+    window = std::aligned_alloc(BLOCK_SIZE, m_window_size);
+  }
+  if (window == nullptr) {
+    m_error = errno;
+    close(m_fd);
+    m_fd = -1;
+    return;
+  }
+  m_window = static_cast<char*>(window);
+
+  // Placeholder until Close() knows the sizes. Sample boundaries stay
+  // aligned, as the header size is a multiple of 4.
+  m_fill = FormatHeader(m_window);
+}
+
+FileAudioSink::~FileAudioSink() {
+  Close();
+  if (m_config.mode != FileWriteMode::MMAP) {
+    std::free(m_window);
+  }
+}
+
+uint32_t FileAudioSink::Send(const float* buffer, uint32_t size) {
+  if (!IsOpen() || m_error != 0) {
+    return 0;
+  }
+
+  // Convert whole samples, which never straddle two windows
+  const std::size_t channels = m_config.channels;
+  const std::size_t samples = std::size_t{size} * channels;
+  std::size_t done = 0;
+  while (done < samples) {
+    if (m_fill == m_window_size && !Advance()) {
+      break;
+    }
+    const std::size_t count =
+        std::min(samples - done, (m_window_size - m_fill) / m_sample_bytes);
+    ConvertFromFloat({buffer + done, count}, m_config.format,
+                     m_window + m_fill);
+    if (m_config.format == SampleFormat::S24 && m_header_bytes > 0) {
+      LeftJustifyS24(m_window + m_fill, count);
+    }
+    m_fill += count * m_sample_bytes;
+    done += count;
+  }
+
+  const std::size_t frames = done / channels;
+  m_frames += frames;
+  return static_cast<uint32_t>(frames);
+}
+
+bool FileAudioSink::Advance() {
+  if (m_config.mode == FileWriteMode::MMAP) {
+    munmap(m_window, m_window_size);
+    m_window = nullptr;
+    m_window_offset += m_window_size;
+    if (ftruncate(m_fd, static_cast<off_t>(m_window_offset + m_window_size)) <
+        0) {
+      return Fail();
+    }
+    void* window = mmap(nullptr, m_window_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, m_fd, static_cast<off_t>(m_window_offset));
+    if (window == MAP_FAILED) {
+      return Fail();
+    }
+    m_window = static_cast<char*>(window);
+    m_fill = 0;
+    return true;
+  }
+
+  std::size_t written = 0;
+  while (written < m_fill) {
+    const ssize_t ret = write(m_fd, m_window + written, m_fill - written);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Fail();
+    }
+    written += static_cast<std::size_t>(ret);
+  }
+  m_window_offset += m_fill;
+  m_fill = 0;
+  return true;
+}
+
+bool FileAudioSink::Fail() {
+  if (m_error == 0) {
+    m_error = errno;
+  }
+  return false;
+}
+
+bool FileAudioSink::Close() {
+  if (!IsOpen()) {
+    return m_error == 0;
+  }
+
+  const uint64_t end = m_window_offset + m_fill;
+  if (m_config.mode == FileWriteMode::MMAP) {
+    if (m_window != nullptr) {
+      munmap(m_window, m_window_size);
+      m_window = nullptr;
+    }
+    if (ftruncate(m_fd, static_cast<off_t>(end)) < 0) {
+      Fail();
+    }
+  } else if (m_error == 0) {
+    // The last buffer is not a whole number of blocks
+    if (m_config.mode == FileWriteMode::DIRECT) {
+      fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+    }
+    Advance();
+  }
+
+  if (m_header_bytes > 0 && m_error == 0) {
+    char header[WAV_EXTENSIBLE_HEADER_BYTES];
+    const std::size_t length = FormatHeader(header);
+    if (pwrite(m_fd, header, length, 0) != static_cast<ssize_t>(length)) {
+      Fail();
+    }
+  }
+
+  if (close(m_fd) < 0) {
+    Fail();
+  }
+  m_fd = -1;
+  return m_error == 0;
+}
+
+std::size_t FileAudioSink::FormatHeader(char* out) const {
+  if (m_header_bytes == 0) {
+    return 0;
+  }
+
+  // RIFF sizes are 32 bits: saturate rather than wrap for huge files
+  const uint64_t data_bytes =
+      m_frames * m_config.channels * m_sample_bytes;
+  const uint32_t max = std::numeric_limits<uint32_t>::max();
+  const auto data_size =
+      static_cast<uint32_t>(std::min<uint64_t>(data_bytes, max - 64));
+  const auto bits = static_cast<uint32_t>(8 * m_sample_bytes);
+  const auto block_align =
+      static_cast<uint32_t>(m_config.channels * m_sample_bytes);
+  const uint16_t tag = m_config.format == SampleFormat::FLOAT
+                           ? WAVE_FORMAT_IEEE_FLOAT
+                           : WAVE_FORMAT_PCM;
+  const bool extensible = IsExtensible(m_config);
+
+  char* p = out;
+  p = Put(p, "RIFF");
+  p = Put(p, static_cast<uint32_t>(m_header_bytes - 8) + data_size, 4);
+  p = Put(p, "WAVE");
+  p = Put(p, "fmt ");
+  p = Put(p, extensible ? 40 : 16, 4);
+  p = Put(p, extensible ? WAVE_FORMAT_EXTENSIBLE : tag, 2);
+  p = Put(p, m_config.channels, 2);
+  p = Put(p, m_config.sample_rate, 4);
+  p = Put(p, m_config.sample_rate * block_align, 4);
+  p = Put(p, block_align, 2);
+  p = Put(p, bits, 2);
+  if (extensible) {
+    p = Put(p, 22, 2);  // Size of the extension
+    p = Put(p, m_config.format == SampleFormat::S24 ? 24 : bits, 2);
+    p = Put(p, 0, 4);  // No speaker positions
+    p = Put(p, tag, 2);
+    std::memcpy(p, SUBTYPE_GUID_TAIL, 14);
+    p += 14;
+  }
+  p = Put(p, "data");
+  p = Put(p, data_size, 4);
+  return static_cast<std::size_t>(p - out);
+}
+
+}  // namespace audio
+}  // namespace jltx
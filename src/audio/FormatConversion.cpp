@@ -0,0 +1,235 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio/FormatConversion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define JLTX_FORMAT_CONVERSION_AVX2 1
+#endif
+
+namespace jltx {
+namespace audio {
+
+/** \brief Scale factor and clipping range of an integer format */
+struct Limits {
+  float scale;
+  float lo;
+  float hi;
+};
+
+static constexpr Limits LimitsOf(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::S16:
+      return {32768.0f, -32768.0f, 32767.0f};
+    case SampleFormat::S24:
+      return {8388608.0f, -8388608.0f, 8388607.0f};
+    default:
+      // 2^31 - 1 is not a float: clip to the largest float below 2^31
+      return {2147483648.0f, -2147483648.0f, 2147483520.0f};
+  }
+}
+
+/** Samples interleaved at once by InterleaveFromFloat() */
+static constexpr std::size_t INTERLEAVE_BLOCK = 1024;
+
+/**
+ * \brief Scalar conversion of samples [i, n), used for the tails of the SIMD
+ * loops and on targets without SSE2
+ *
+ * The comparisons are written so that NaN is clipped to the low end, like
+ * MAXPS does.
+ */
+static void ConvertScalar(const float* in, std::size_t n, std::size_t i,
+                          const Limits& limits, SampleFormat format,
+                          void* out) {
+  for (; i < n; ++i) {
+    float v = in[i] * limits.scale;
+    v = v > limits.lo ? v : limits.lo;
+    v = v < limits.hi ? v : limits.hi;
+    const auto q = static_cast<int32_t>(std::lrint(v));
+    if (format == SampleFormat::S16) {
+      static_cast<int16_t*>(out)[i] = static_cast<int16_t>(q);
+    } else {
+      static_cast<int32_t*>(out)[i] = q;
+    }
+  }
+}
+
+#if defined(__SSE2__)
+static inline __m128i QuantizeSse2(const float* in, __m128 scale, __m128 lo,
+                                   __m128 hi) {
+  const __m128 v = _mm_mul_ps(_mm_loadu_ps(in), scale);
+  return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, lo), hi));
+}
+
+/** \brief Convert 4 or 8 samples per iteration, \return First sample left */
+static std::size_t ConvertSse2(const float* in, std::size_t n, std::size_t i,
+                               const Limits& limits, SampleFormat format,
+                               void* out) {
+  const __m128 scale = _mm_set1_ps(limits.scale);
+  const __m128 lo = _mm_set1_ps(limits.lo);
+  const __m128 hi = _mm_set1_ps(limits.hi);
+
+  if (format == SampleFormat::S16) {
+    auto* dst = static_cast<int16_t*>(out);
+    for (; i + 8 <= n; i += 8) {
+      const __m128i q0 = QuantizeSse2(in + i, scale, lo, hi);
+      const __m128i q1 = QuantizeSse2(in + i + 4, scale, lo, hi);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                       _mm_packs_epi32(q0, q1));
+    }
+  } else {
+    auto* dst = static_cast<int32_t*>(out);
+    for (; i + 4 <= n; i += 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                       QuantizeSse2(in + i, scale, lo, hi));
+    }
+  }
+  return i;
+}
+#endif
+
+#if defined(JLTX_FORMAT_CONVERSION_AVX2)
+__attribute__((target("avx2"))) static inline __m256i QuantizeAvx2(
+    const float* in, __m256 scale, __m256 lo, __m256 hi) {
+  const __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in), scale);
+  return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi));
+}
+
+/** \brief Same as ConvertSse2(), 8 or 16 samples per iteration */
+__attribute__((target("avx2"))) static std::size_t ConvertAvx2(
+    const float* in, std::size_t n, std::size_t i, const Limits& limits,
+    SampleFormat format, void* out) {
+  const __m256 scale = _mm256_set1_ps(limits.scale);
+  const __m256 lo = _mm256_set1_ps(limits.lo);
+  const __m256 hi = _mm256_set1_ps(limits.hi);
+
+  if (format == SampleFormat::S16) {
+    auto* dst = static_cast<int16_t*>(out);
+    for (; i + 16 <= n; i += 16) {
+      const __m256i q0 = QuantizeAvx2(in + i, scale, lo, hi);
+      const __m256i q1 = QuantizeAvx2(in + i + 8, scale, lo, hi);
+      // The pack works within 128-bit lanes, so put the lanes back in order
+      const __m256i packed = _mm256_permute4x64_epi64(
+          _mm256_packs_epi32(q0, q1), _MM_SHUFFLE(3, 1, 2, 0));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+    }
+  } else {
+    auto* dst = static_cast<int32_t*>(out);
+    for (; i + 8 <= n; i += 8) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                          QuantizeAvx2(in + i, scale, lo, hi));
+    }
+  }
+  return i;
+}
+#endif
+
+const char* FormatName(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::FLOAT:
+      return "FLOAT";
+    case SampleFormat::S16:
+      return "S16";
+    case SampleFormat::S24:
+      return "S24";
+    case SampleFormat::S32:
+      return "S32";
+  }
+  return "UNKNOWN";
+}
+
+void ConvertFromFloat(std::span<const float> in, SampleFormat format,
+                      void* out) {
+  if (format == SampleFormat::FLOAT) {
+    std::memcpy(out, in.data(), in.size_bytes());
+    return;
+  }
+
+  const Limits limits = LimitsOf(format);
+  const float* src = in.data();
+  const std::size_t n = in.size();
+  std::size_t i = 0;
+#if defined(JLTX_FORMAT_CONVERSION_AVX2)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_avx2) {
+    i = ConvertAvx2(src, n, i, limits, format, out);
+  }
+#endif
+#if defined(__SSE2__)
+  i = ConvertSse2(src, n, i, limits, format, out);
+#endif
+  ConvertScalar(src, n, i, limits, format, out);
+}
+
+void InterleaveFromFloat(std::span<const float* const> planes,
+                         std::size_t frames, SampleFormat format, void* out) {
+  const std::size_t channels = planes.size();
+  if (channels == 1) {
+    ConvertFromFloat({planes[0], frames}, format, out);
+    return;
+  }
+  if (channels == 0 || channels > INTERLEAVE_BLOCK) {
+    return;
+  }
+
+  // Interleave a block of floats on the stack, then convert it in one go
+  alignas(32) float block[INTERLEAVE_BLOCK];
+  const std::size_t block_frames = INTERLEAVE_BLOCK / channels;
+  auto* dst = static_cast<char*>(out);
+  for (std::size_t first = 0; first < frames; first += block_frames) {
+    const std::size_t count = std::min(block_frames, frames - first);
+    std::size_t f = 0;
+#if defined(__SSE2__)
+    if (channels == 2) {
+      const float* left = planes[0] + first;
+      const float* right = planes[1] + first;
+      for (; f + 4 <= count; f += 4) {
+        const __m128 l = _mm_loadu_ps(left + f);
+        const __m128 r = _mm_loadu_ps(right + f);
+        _mm_store_ps(block + 2 * f, _mm_unpacklo_ps(l, r));
+        _mm_store_ps(block + 2 * f + 4, _mm_unpackhi_ps(l, r));
+      }
+    }
+#endif
+    for (; f < count; ++f) {
+      for (std::size_t c = 0; c < channels; ++c) {
+        block[f * channels + c] = planes[c][first + f];
+      }
+    }
+    ConvertFromFloat({block, count * channels}, format, dst);
+    dst += count * channels * BytesPerSample(format);
+  }
+}
+
+}  // namespace audio
+}  // namespace jltx
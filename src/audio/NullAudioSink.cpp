@@ -0,0 +1,66 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio/NullAudioSink.hpp"
+
+#include "util/Clock.hpp"
+
+namespace jltx {
+namespace audio {
+
+uint32_t NullAudioSink::Send(const float* /*buffer*/, uint32_t size) {
+  const int64_t now = NowNs();
+  if (m_frames == 0) {
+    m_first_ns = now;
+    m_first_frames = size;
+  }
+  m_last_ns = now;
+  m_frames += size;
+  return size;
+}
+
+double NullAudioSink::FramesPerSecond() const {
+  // The frames of the first Send() were rendered before the clock started
+  if (m_last_ns <= m_first_ns) {
+    return 0.0;
+  }
+  return static_cast<double>(m_frames - m_first_frames) * 1e9 /
+         static_cast<double>(m_last_ns - m_first_ns);
+}
+
+double NullAudioSink::RealtimeFactor() const {
+  return m_sample_rate > 0
+             ? FramesPerSecond() / static_cast<double>(m_sample_rate)
+             : 0.0;
+}
+
+void NullAudioSink::Reset() {
+  m_frames = 0;
+  m_first_frames = 0;
+  m_first_ns = 0;
+  m_last_ns = 0;
+}
+
+}  // namespace audio
+}  // namespace jltx
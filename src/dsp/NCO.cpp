@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "dsp/NCO.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define JLTX_NCO_AVX2 1
+#endif
+
+namespace jltx {
+namespace dsp {
+
+#if defined(JLTX_NCO_AVX2)
+static constexpr std::size_t MIN_AVX2_RUN = 16;
+
+/** \brief 8 phases and one gather per iteration, the last one masked */
+__attribute__((target("avx2"))) static std::size_t RenderSineAvx2(
+    const float* table, uint32_t shift, uint32_t phase, uint32_t delta,
+    float amplitude, float* out, std::size_t n) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  // 32-bit products wrap like the scalar accumulator
+  __m256i phases = _mm256_add_epi32(
+      _mm256_set1_epi32(static_cast<int>(phase)),
+      _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int>(delta))));
+  const __m256i step = _mm256_set1_epi32(static_cast<int>(8 * delta));
+  const __m128i count = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m256 scale = _mm256_set1_ps(amplitude);
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i index = _mm256_srl_epi32(phases, count);
+    const __m256 value = _mm256_i32gather_ps(table, index, 4);
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(value, scale));
+    phases = _mm256_add_epi32(phases, step);
+  }
+  if (i < n) {
+    // Short runs between close events are common, so no scalar tail
+    const __m256i mask = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(static_cast<int>(n - i)), lanes);
+    const __m256i index = _mm256_srl_epi32(phases, count);
+    const __m256 value = _mm256_mask_i32gather_ps(
+        _mm256_setzero_ps(), table, index, _mm256_castsi256_ps(mask), 4);
+    _mm256_maskstore_ps(out + i, mask, _mm256_mul_ps(value, scale));
+    i = n;
+  }
+  return i;
+}
+#endif
+
+void RenderSine(const float* table, uint32_t shift, uint32_t phase,
+                uint32_t delta, float amplitude, float* out, std::size_t n) {
+  std::size_t i = 0;
+#if defined(JLTX_NCO_AVX2)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  // A gather has a long latency, so very short runs are faster one by one
+  if (has_avx2 && n >= MIN_AVX2_RUN) {
+    i = RenderSineAvx2(table, shift, phase, delta, amplitude, out, n);
+  }
+#endif
+  for (; i < n; ++i) {
+    const uint32_t index = (phase + static_cast<uint32_t>(i) * delta) >> shift;
+    out[i] = amplitude * table[index];
+  }
+}
+
+}  // namespace dsp
+}  // namespace jltx
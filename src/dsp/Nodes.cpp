@@ -0,0 +1,71 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "dsp/Nodes.hpp"
+
+#include <algorithm>
+
+namespace jltx {
+namespace dsp {
+
+/** Channel of input that feeds output channel c, nullptr if none */
+static const float* Source(const Block& input, uint32_t c) {
+  if (input.channels == 1) {
+    return input.Channel(0);
+  }
+  return (c < input.channels) ? input.Channel(c) : nullptr;
+}
+
+void GainNode::Process(std::span<const Block> inputs, const Block& output) {
+  for (uint32_t c = 0; c < output.channels; ++c) {
+    float* out = output.Channel(c);
+    const float* in = inputs.empty() ? nullptr : Source(inputs[0], c);
+    if (in == nullptr) {
+      std::fill_n(out, output.frames, 0.0f);
+      continue;
+    }
+    for (uint32_t i = 0; i < output.frames; ++i) {
+      out[i] = m_gain * in[i];
+    }
+  }
+}
+
+void MixerNode::Process(std::span<const Block> inputs, const Block& output) {
+  for (uint32_t c = 0; c < output.channels; ++c) {
+    float* out = output.Channel(c);
+    std::fill_n(out, output.frames, 0.0f);
+    for (const Block& input : inputs) {
+      const float* in = Source(input, c);
+      if (in == nullptr) {
+        continue;
+      }
+      for (uint32_t i = 0; i < output.frames; ++i) {
+        out[i] += in[i];
+      }
+    }
+  }
+}
+
+}  // namespace dsp
+}  // namespace jltx
@@ -0,0 +1,264 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "dsp/ProcessingGraph.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "audio/FormatConversion.hpp"
+#include "trace.hpp"
+#include "util/Clock.hpp"
+
+namespace jltx {
+namespace dsp {
+
+/** Buffers start on cache line boundaries, so no two nodes share a line */
+static constexpr std::size_t ALIGN_FLOATS = 64 / sizeof(float);
+
+static std::size_t AlignUp(std::size_t value) {
+  return (value + ALIGN_FLOATS - 1) & ~(ALIGN_FLOATS - 1);
+}
+
+ProcessingGraph::ProcessingGraph(uint32_t block_frames)
+    : m_block_frames(std::max(block_frames, 1u)),
+      m_block_time(metrics::MetricsRegistry::Global().GetHistogram(
+          "dsp.graph.block_ns")) {}
+
+ProcessingGraph::NodeId ProcessingGraph::Add(std::unique_ptr<Node> node,
+                                             std::vector<NodeId> inputs) {
+  if (!node) {
+    return INVALID_NODE;
+  }
+  const auto id = static_cast<NodeId>(m_nodes.size());
+  for (const NodeId input : inputs) {
+    if (input >= id) {
+      return INVALID_NODE;
+    }
+  }
+  for (const NodeId input : inputs) {
+    m_nodes[input].consumers.push_back(id);
+  }
+  Entry entry;
+  entry.node = std::move(node);
+  entry.inputs = std::move(inputs);
+  m_nodes.push_back(std::move(entry));
+  m_compiled = false;
+  return id;
+}
+
+bool ProcessingGraph::Compile(NodeId output) {
+  m_compiled = false;
+  if (output >= m_nodes.size()) {
+    return false;
+  }
+  m_output = output;
+  const std::size_t count = m_nodes.size();
+
+  // Ancestor sets. Inputs always come first, so one pass in order suffices.
+  const std::size_t words = (count + 63) / 64;
+  std::vector<uint64_t> ancestors(count * words, 0);
+  const auto is_ancestor = [&](NodeId node, NodeId of) {
+    return (ancestors[of * words + node / 64] >> (node % 64)) & 1;
+  };
+  for (NodeId id = 0; id < count; ++id) {
+    uint64_t* const own = &ancestors[id * words];
+    for (const NodeId input : m_nodes[id].inputs) {
+      const uint64_t* const theirs = &ancestors[input * words];
+      for (std::size_t w = 0; w < words; ++w) {
+        own[w] |= theirs[w];
+      }
+      own[input / 64] |= uint64_t{1} << (input % 64);
+    }
+  }
+
+  // A node takes over a buffer when the current holder and every reader of
+  // it finish before the node can start, whatever the schedule
+  struct Buffer {
+    NodeId holder;
+    std::size_t size;
+    std::size_t offset = 0;
+  };
+  std::vector<Buffer> buffers;
+  std::vector<std::size_t> assignment(count);
+  for (NodeId id = 0; id < count; ++id) {
+    const std::size_t size =
+        std::size_t{m_nodes[id].node->Channels()} * m_block_frames;
+    std::size_t chosen = buffers.size();
+    for (std::size_t b = 0; b < buffers.size(); ++b) {
+      const NodeId holder = buffers[b].holder;
+      if (holder == m_output || !is_ancestor(holder, id)) {
+        continue;
+      }
+      const auto& readers = m_nodes[holder].consumers;
+      if (std::all_of(readers.begin(), readers.end(),
+                      [&](NodeId r) { return is_ancestor(r, id); })) {
+        chosen = b;
+        break;
+      }
+    }
+    if (chosen == buffers.size()) {
+      buffers.push_back({id, size});
+    }
+    buffers[chosen].holder = id;
+    buffers[chosen].size = std::max(buffers[chosen].size, size);
+    assignment[id] = chosen;
+  }
+
+  std::size_t total = 0;
+  for (auto& buffer : buffers) {
+    buffer.offset = total;
+    total += AlignUp(buffer.size);
+  }
+  m_storage.assign(total + ALIGN_FLOATS, 0.0f);
+  float* base = m_storage.data();
+  base += (ALIGN_FLOATS - reinterpret_cast<uintptr_t>(base) / sizeof(float) %
+                              ALIGN_FLOATS) %
+          ALIGN_FLOATS;
+  m_buffer_count = buffers.size();
+
+  m_input_blocks.clear();
+  m_sources.clear();
+  for (NodeId id = 0; id < count; ++id) {
+    Entry& entry = m_nodes[id];
+    entry.output = {base + buffers[assignment[id]].offset,
+                    entry.node->Channels(), m_block_frames};
+    entry.first_input = m_input_blocks.size();
+    for (const NodeId input : entry.inputs) {
+      m_input_blocks.push_back(m_nodes[input].output);
+    }
+    if (entry.inputs.empty()) {
+      m_sources.push_back(id);
+    }
+  }
+
+  m_pending = std::make_unique<std::atomic<uint32_t>[]>(count);
+  m_deques.clear();
+  m_compiled = true;
+  return true;
+}
+
+void ProcessingGraph::Run(NodeId id) {
+  Entry& entry = m_nodes[id];
+  entry.node->Process(
+      {m_input_blocks.data() + entry.first_input, entry.inputs.size()},
+      entry.output);
+}
+
+void ProcessingGraph::Process(ThreadPool* pool) {
+  if (!m_compiled) {
+    return;
+  }
+  JLTX_TRACE_FUNCTION();
+  const int64_t start = NowNs();
+
+  if (pool == nullptr || pool->Size() < 2 || m_nodes.size() < 2) {
+    for (NodeId id = 0; id < m_nodes.size(); ++id) {
+      Run(id);
+    }
+  } else {
+    const std::size_t workers = pool->Size();
+    if (m_deques.size() != workers) {
+      m_deques.clear();
+      for (std::size_t w = 0; w < workers; ++w) {
+        m_deques.push_back(
+            std::make_unique<WorkStealingDeque<NodeId>>(m_nodes.size()));
+      }
+    }
+    for (NodeId id = 0; id < m_nodes.size(); ++id) {
+      m_pending[id].store(static_cast<uint32_t>(m_nodes[id].inputs.size()),
+                          std::memory_order_relaxed);
+    }
+    m_remaining.store(m_nodes.size(), std::memory_order_relaxed);
+    // Safe from here: ParallelFor() publishes these before any worker runs
+    for (std::size_t i = 0; i < m_sources.size(); ++i) {
+      m_deques[i % workers]->Push(m_sources[i]);
+    }
+    pool->ParallelFor(workers, [this](std::size_t w) { WorkerLoop(w); });
+  }
+
+  m_block_time.Record(static_cast<uint64_t>(NowNs() - start));
+}
+
+void ProcessingGraph::WorkerLoop(std::size_t worker) {
+  WorkStealingDeque<NodeId>& own = *m_deques[worker];
+  const std::size_t workers = m_deques.size();
+  while (m_remaining.load(std::memory_order_acquire) > 0) {
+    NodeId id = INVALID_NODE;
+    bool found = own.Pop(id);
+    for (std::size_t i = 1; !found && i < workers; ++i) {
+      found = m_deques[(worker + i) % workers]->Steal(id);
+    }
+    if (!found) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    Run(id);
+    for (const NodeId consumer : m_nodes[id].consumers) {
+      // acq_rel: the last input to finish hands all the inputs' writes over
+      if (m_pending[consumer].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        own.Push(consumer);
+      }
+    }
+    m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+const Block& ProcessingGraph::Output() const {
+  static const Block EMPTY;
+  return m_compiled ? m_nodes[m_output].output : EMPTY;
+}
+
+uint64_t ProcessingGraph::Render(audio::AudioSink& sink, uint64_t frames,
+                                 ThreadPool* pool) {
+  if (!m_compiled || sink.Channels() != Output().channels) {
+    return 0;
+  }
+  const Block& output = Output();
+  m_interleaved.resize(std::size_t{output.channels} * m_block_frames);
+  m_planes.resize(output.channels);
+  for (uint32_t c = 0; c < output.channels; ++c) {
+    m_planes[c] = output.Channel(c);
+  }
+
+  uint64_t sent = 0;
+  while (sent < frames) {
+    Process(pool);
+    const auto size = static_cast<uint32_t>(
+        std::min<uint64_t>(m_block_frames, frames - sent));
+    audio::InterleaveFromFloat(m_planes, size, audio::SampleFormat::FLOAT,
+                               m_interleaved.data());
+    const uint32_t written = sink.Send(m_interleaved.data(), size);
+    sent += written;
+    if (written < size) {
+      break;
+    }
+  }
+  return sent;
+}
+
+}  // namespace dsp
+}  // namespace jltx
@@ -0,0 +1,87 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "memory/Arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace jltx {
+namespace memory {
+
+MonotonicArena::MonotonicArena(std::size_t chunk_size)
+    : m_chunk_size(std::max<std::size_t>(chunk_size, CACHE_LINE_SIZE)) {}
+
+MonotonicArena::~MonotonicArena() {
+  for (const Chunk& chunk : m_chunks) {
+    ::operator delete(chunk.data, std::align_val_t{CACHE_LINE_SIZE});
+  }
+}
+
+void* MonotonicArena::AllocateSlow(std::size_t size, std::size_t alignment) {
+  // Enough for the request wherever the padding falls
+  const std::size_t needed = size + alignment;
+  if (m_chunk != nullptr) {
+    m_used_before += m_offset;
+    ++m_current;
+  }
+  // Skip kept chunks that are too small, which only happens after a request
+  // larger than a chunk
+  while (m_current < m_chunks.size() && m_chunks[m_current].size < needed) {
+    ++m_current;
+  }
+  if (m_current == m_chunks.size()) {
+    const std::size_t chunk_size = std::max(m_chunk_size, needed);
+    m_chunks.push_back({static_cast<std::byte*>(::operator new(
+                            chunk_size, std::align_val_t{CACHE_LINE_SIZE})),
+                        chunk_size});
+  }
+  m_chunk = m_chunks[m_current].data;
+  m_capacity = m_chunks[m_current].size;
+  m_offset = 0;
+  return Allocate(size, alignment);
+}
+
+void MonotonicArena::Reset() {
+  m_current = 0;
+  m_chunk = m_chunks.empty() ? nullptr : m_chunks.front().data;
+  m_capacity = m_chunks.empty() ? 0 : m_chunks.front().size;
+  m_offset = 0;
+  m_used_before = 0;
+}
+
+std::size_t MonotonicArena::BytesUsed() const {
+  return m_used_before + m_offset;
+}
+
+std::size_t MonotonicArena::BytesReserved() const {
+  std::size_t total = 0;
+  for (const Chunk& chunk : m_chunks) {
+    total += chunk.size;
+  }
+  return total;
+}
+
+}  // namespace memory
+}  // namespace jltx
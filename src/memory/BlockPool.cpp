@@ -0,0 +1,222 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "memory/BlockPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+
+namespace jltx {
+namespace memory {
+
+static uint64_t NextId() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Ids of the pools alive. Thread caches only give blocks back to a pool that
+// is still in here, with the mutex held, so a pool destroyed in the meantime
+// is never touched. Never destroyed, as threads may exit after static
+// destructors have run.
+struct Registry {
+  std::mutex mutex;
+  std::unordered_set<uint64_t> live;
+};
+
+static Registry& GetRegistry() {
+  static Registry* const registry = new Registry();
+  return *registry;
+}
+
+static constexpr uint64_t Pack(uint64_t tag, uint32_t index) {
+  return (tag << 32) | index;
+}
+
+// Per-thread caches of the last SLOTS pools used. A pool only evicts
+// another one when all the slots hold blocks, so threads switching between a
+// few pools never take the registry mutex.
+struct BlockPool::ThreadCache {
+  struct Slot {
+    uint64_t pool_id = 0;
+    BlockPool* pool = nullptr;
+    uint32_t count = 0;
+    uint32_t blocks[CACHE_BLOCKS];
+  };
+  static constexpr std::size_t SLOTS = 8;
+  Slot slots[SLOTS];
+  std::size_t next_victim = 0;
+
+  ~ThreadCache() {
+    for (Slot& slot : slots) {
+      Flush(slot);
+    }
+  }
+
+  static ThreadCache& Get() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  Slot& For(BlockPool& pool) {
+    Slot* empty = nullptr;
+    for (Slot& slot : slots) {
+      if (slot.pool_id == pool.m_id) {
+        return slot;
+      }
+      if (empty == nullptr && slot.count == 0) {
+        empty = &slot;
+      }
+    }
+
+    Slot* slot = empty;
+    if (slot == nullptr) {
+      slot = &slots[next_victim];
+      next_victim = (next_victim + 1) % SLOTS;
+      Flush(*slot);
+    }
+    *slot = Slot{};
+    slot->pool_id = pool.m_id;
+    slot->pool = &pool;
+    return *slot;
+  }
+
+  static void Flush(Slot& slot) {
+    if (slot.count > 0) {
+      Registry& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      if (registry.live.count(slot.pool_id) > 0) {
+        slot.pool->Give(slot.blocks, slot.count);
+      }
+    }
+    slot = Slot{};
+  }
+};
+
+BlockPool::BlockPool(std::size_t block_size, std::size_t block_count,
+                     std::size_t alignment)
+    : m_block_size(block_size),
+      m_alignment(std::max(alignment, alignof(std::max_align_t))),
+      m_stride(AlignUp(std::max<std::size_t>(block_size, 1), m_alignment)),
+      m_count(static_cast<uint32_t>(
+          std::min<std::size_t>(block_count, NIL - 1))),
+      m_id(NextId()),
+      m_storage(static_cast<std::byte*>(::operator new(
+          m_stride * std::max<uint32_t>(m_count, 1),
+          std::align_val_t{m_alignment}))),
+      m_head(Pack(0, m_count > 0 ? 0 : NIL)),
+      m_next(std::make_unique<std::atomic<uint32_t>[]>(m_count)) {
+  assert((alignment & (alignment - 1)) == 0);
+  for (uint32_t i = 0; i < m_count; ++i) {
+    m_next[i].store(i + 1 < m_count ? i + 1 : NIL, std::memory_order_relaxed);
+  }
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.live.insert(m_id);
+}
+
+BlockPool::~BlockPool() {
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.live.erase(m_id);
+  }
+  ::operator delete(m_storage, std::align_val_t{m_alignment});
+}
+
+void* BlockPool::Allocate() {
+  ThreadCache::Slot& slot = ThreadCache::Get().For(*this);
+  if (slot.count == 0) {
+    slot.count = Take(slot.blocks, CACHE_BLOCKS / 2);
+    if (slot.count == 0) {
+      return nullptr;
+    }
+  }
+  return Block(slot.blocks[--slot.count]);
+}
+
+void BlockPool::Free(void* block) {
+  if (block == nullptr) {
+    return;
+  }
+  assert(Owns(block));
+  ThreadCache::Slot& slot = ThreadCache::Get().For(*this);
+  if (slot.count == CACHE_BLOCKS) {
+    // Keep the most recently used half, likely still in cache
+    Give(slot.blocks, CACHE_BLOCKS / 2);
+    std::copy(slot.blocks + CACHE_BLOCKS / 2, slot.blocks + CACHE_BLOCKS,
+              slot.blocks);
+    slot.count = CACHE_BLOCKS / 2;
+  }
+  slot.blocks[slot.count++] = Index(block);
+}
+
+bool BlockPool::Owns(const void* block) const {
+  const auto* byte = static_cast<const std::byte*>(block);
+  return byte >= m_storage && byte < m_storage + m_stride * m_count &&
+         (byte - m_storage) % m_stride == 0;
+}
+
+void BlockPool::Give(const uint32_t* blocks, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  // Link the blocks privately, then publish them with a single exchange
+  for (uint32_t i = 0; i + 1 < count; ++i) {
+    m_next[blocks[i]].store(blocks[i + 1], std::memory_order_relaxed);
+  }
+  const uint32_t last = blocks[count - 1];
+  uint64_t head = m_head.load(std::memory_order_relaxed);
+  do {
+    m_next[last].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+  } while (!m_head.compare_exchange_weak(
+      head, Pack((head >> 32) + 1, blocks[0]), std::memory_order_release,
+      std::memory_order_relaxed));
+}
+
+uint32_t BlockPool::Take(uint32_t* out, uint32_t max) {
+  uint32_t taken = 0;
+  uint64_t head = m_head.load(std::memory_order_acquire);
+  while (taken < max) {
+    const auto top = static_cast<uint32_t>(head);
+    if (top == NIL) {
+      break;
+    }
+    // May read a link that is being rewritten, in which case the counter has
+    // moved on and the exchange fails
+    const uint32_t next = m_next[top].load(std::memory_order_relaxed);
+    if (m_head.compare_exchange_weak(head, Pack((head >> 32) + 1, next),
+                                     std::memory_order_acquire,
+                                     std::memory_order_acquire)) {
+      out[taken++] = top;
+      head = Pack((head >> 32) + 1, next);
+    }
+  }
+  return taken;
+}
+
+}  // namespace memory
+}  // namespace jltx
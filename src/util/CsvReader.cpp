@@ -0,0 +1,330 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "util/CsvReader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace jltx {
+namespace TextUtils {
+
+MappedFile::MappedFile(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0) {
+    const std::size_t size = static_cast<std::size_t>(file_stat.st_size);
+    if (size == 0) {  // mmap does not accept empty mappings
+      m_open = true;
+    } else {
+      void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(addr);
+        m_size = size;
+        m_open = true;
+      }
+    }
+  }
+
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+}
+
+/** \brief Index of the first byte equal to a or b in [pos, n), or n */
+static std::size_t FindAny(const char* s, std::size_t pos, std::size_t n,
+                           char a, char b) {
+#if defined(__SSE2__)
+  const __m128i va = _mm_set1_epi8(a);
+  const __m128i vb = _mm_set1_epi8(b);
+  for (; pos + 16 <= n; pos += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb))));
+    if (mask != 0) {
+      return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+    }
+  }
+#endif
+  for (; pos < n; ++pos) {
+    if ((s[pos] == a) || (s[pos] == b)) {
+      return pos;
+    }
+  }
+  return n;
+}
+
+/**
+ * \brief Follow the quoted fields up to end, with the rules of ParseRows()
+ *
+ * \param pos First byte not looked at yet, moved up to end
+ * \param inside Whether pos is inside a quoted field, updated
+ * \return false on a quote outside quoted fields that does not start a
+ * field. ParseRows() keeps it as a plain character, so from there on the
+ * quotes no longer tell where the quoted fields are without parsing.
+ */
+static bool FollowQuotes(const char* s, std::size_t end, char delimiter,
+                         char quote, std::size_t& pos, bool& inside) {
+  while (pos < end) {
+    const void* found = std::memchr(s + pos, quote, end - pos);
+    if (found == nullptr) {
+      break;
+    }
+    const auto at =
+        static_cast<std::size_t>(static_cast<const char*>(found) - s);
+    if (inside) {
+      if ((at + 1 < end) && (s[at + 1] == quote)) {  // Doubled quote
+        pos = at + 2;
+        continue;
+      }
+      inside = false;
+    } else {
+      if ((at > 0) && (s[at - 1] != delimiter) && (s[at - 1] != '\n')) {
+        return false;
+      }
+      inside = true;
+    }
+    pos = at + 1;
+  }
+  pos = end;
+  return true;
+}
+
+/**
+ * \brief Split data into chunks of about chunk_size bytes that end on row
+ * boundaries
+ *
+ * \return false if the boundaries cannot be found without parsing
+ */
+static bool FindChunks(std::string_view data, const CsvOptions& options,
+                       std::vector<std::size_t>& boundaries) {
+  const char* s = data.data();
+  const std::size_t n = data.size();
+  const std::size_t chunk_size = std::max<std::size_t>(1, options.chunk_size);
+  std::size_t scanned = 0;
+  bool inside = false;
+  boundaries = {0};
+  while (n - boundaries.back() > chunk_size) {
+    std::size_t cursor = boundaries.back() + chunk_size;
+    std::size_t boundary = n;
+    while (cursor < n) {
+      const void* found = std::memchr(s + cursor, '\n', n - cursor);
+      if (found == nullptr) {
+        break;
+      }
+      const std::size_t line_end =
+          static_cast<std::size_t>(static_cast<const char*>(found) - s);
+      if ((options.quote != '\0') &&
+          !FollowQuotes(s, line_end, options.delimiter, options.quote,
+                        scanned, inside)) {
+        return false;
+      }
+      if (!inside) {
+        boundary = line_end + 1;
+        break;
+      }
+      cursor = line_end + 1;
+    }
+    if (boundary >= n) {
+      break;
+    }
+    boundaries.push_back(boundary);
+  }
+  boundaries.push_back(n);
+  return true;
+}
+
+/**
+ * \brief Tokenize data and call on_row with the fields of every row
+ *
+ * \param fields Scratch vector, reused between rows
+ */
+template <typename OnRow>
+static void ParseRows(std::string_view data, const CsvOptions& options,
+                      std::vector<std::string_view>& fields, OnRow&& on_row) {
+  const char* s = data.data();
+  const std::size_t n = data.size();
+  const char delimiter = options.delimiter;
+  const char quote = options.quote;
+
+  std::size_t pos = 0;
+  while (pos < n) {
+    if (options.skip_empty_lines) {
+      if (s[pos] == '\n') {
+        pos += 1;
+        continue;
+      }
+      if ((s[pos] == '\r') && (pos + 1 < n) && (s[pos + 1] == '\n')) {
+        pos += 2;
+        continue;
+      }
+    }
+
+    fields.clear();
+    while (true) {
+      std::size_t end;
+      if ((quote != '\0') && (pos < n) && (s[pos] == quote)) {
+        // Quoted field: the closing quote is the first one not doubled
+        std::size_t closing = pos + 1;
+        while (true) {
+          const void* found = std::memchr(s + closing, quote, n - closing);
+          if (found == nullptr) {  // Unterminated, take the rest of the data
+            closing = n;
+            break;
+          }
+          closing =
+              static_cast<std::size_t>(static_cast<const char*>(found) - s);
+          if ((closing + 1 < n) && (s[closing + 1] == quote)) {
+            closing += 2;
+            continue;
+          }
+          break;
+        }
+        end = FindAny(s, std::min(closing + 1, n), n, delimiter, '\n');
+        std::size_t field_end = end;
+        if ((field_end > closing + 1) && ((end == n) || (s[end] == '\n')) &&
+            (s[field_end - 1] == '\r')) {
+          --field_end;
+        }
+        if (field_end > closing + 1) {  // Text after the closing quote
+          fields.push_back(data.substr(pos, field_end - pos));
+        } else {
+          fields.push_back(data.substr(pos + 1, closing - pos - 1));
+        }
+      } else {
+        end = FindAny(s, pos, n, delimiter, '\n');
+        std::size_t field_end = end;
+        if ((field_end > pos) && ((end == n) || (s[end] == '\n')) &&
+            (s[field_end - 1] == '\r')) {
+          --field_end;
+        }
+        fields.push_back(data.substr(pos, field_end - pos));
+      }
+
+      if ((end >= n) || (s[end] == '\n')) {
+        pos = end + 1;
+        break;
+      }
+      pos = end + 1;  // Skip the delimiter
+    }
+
+    on_row(std::span<const std::string_view>(fields));
+  }
+}
+
+CsvReader::CsvReader(std::string_view data, CsvOptions options)
+    : m_data(data), m_options(options) {}
+
+void CsvReader::ForEachRow(const Callback& callback, ThreadPool* pool) const {
+  std::size_t index = 0;
+  std::vector<std::string_view> fields;
+
+  std::vector<std::size_t> boundaries;
+  if ((pool == nullptr) || (pool->Size() == 1) ||
+      (m_data.size() <= m_options.chunk_size) ||
+      !FindChunks(m_data, m_options, boundaries)) {
+    ParseRows(m_data, m_options, fields,
+              [&](std::span<const std::string_view> row) {
+                callback(CsvRow{index++, row});
+              });
+    return;
+  }
+
+  // Parse a wave of chunks in parallel, then report their rows in order
+  struct ChunkRows {
+    std::vector<std::string_view> fields;
+    std::vector<std::size_t> row_ends;
+  };
+  const std::size_t num_chunks = boundaries.size() - 1;
+  const std::size_t wave_size = 2 * pool->Size();
+  std::vector<ChunkRows> chunks(std::min(wave_size, num_chunks));
+
+  for (std::size_t first = 0; first < num_chunks; first += wave_size) {
+    const std::size_t count = std::min(wave_size, num_chunks - first);
+    pool->ParallelFor(count, [&](std::size_t i) {
+      ChunkRows& chunk = chunks[i];
+      chunk.fields.clear();
+      chunk.row_ends.clear();
+      std::vector<std::string_view> row_fields;
+      const std::size_t begin = boundaries[first + i];
+      ParseRows(m_data.substr(begin, boundaries[first + i + 1] - begin),
+                m_options, row_fields,
+                [&](std::span<const std::string_view> row) {
+                  chunk.fields.insert(chunk.fields.end(), row.begin(),
+                                      row.end());
+                  chunk.row_ends.push_back(chunk.fields.size());
+                });
+    });
+
+    for (std::size_t i = 0; i < count; ++i) {
+      const ChunkRows& chunk = chunks[i];
+      std::size_t row_begin = 0;
+      for (std::size_t row_end : chunk.row_ends) {
+        callback(CsvRow{index++, std::span<const std::string_view>(
+                                     chunk.fields.data() + row_begin,
+                                     row_end - row_begin)});
+        row_begin = row_end;
+      }
+    }
+  }
+}
+
+std::string CsvReader::Unquote(std::string_view field, char quote) {
+  std::string str;
+  str.reserve(field.size());
+  for (std::size_t i = 0; i < field.size(); ++i) {
+    str.push_back(field[i]);
+    if ((field[i] == quote) && (i + 1 < field.size()) &&
+        (field[i + 1] == quote)) {
+      ++i;
+    }
+  }
+  return str;
+}
+
+}  // namespace TextUtils
+}  // namespace jltx
@@ -0,0 +1,278 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "util/Metrics.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+namespace jltx {
+namespace metrics {
+
+std::size_t ThreadShard() {
+  static std::atomic<std::size_t> next_shard{0};
+  static thread_local const std::size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+  return shard;
+}
+
+uint64_t Counter::Value() const {
+  uint64_t value = 0;
+  for (const Shard& shard : m_shards) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+uint64_t HistogramSnapshot::LowestOf(std::size_t bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  const std::size_t shift = (bucket >> SUB_BUCKET_BITS) - 1;
+  return (SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot& other) {
+  count += other.count;
+  sum += other.sum;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+  for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
+double HistogramSnapshot::Mean() const {
+  return count > 0 ? static_cast<double>(sum) / static_cast<double>(count)
+                   : 0.0;
+}
+
+uint64_t HistogramSnapshot::Percentile(double percentile) const {
+  if (count == 0) {
+    return 0;
+  }
+  const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+  const auto rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(
+             std::ceil(fraction * static_cast<double>(count))));
+
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      const uint64_t highest =
+          i + 1 < NUM_BUCKETS ? LowestOf(i + 1) - 1 : UINT64_MAX;
+      return std::clamp(highest, min, max);
+    }
+  }
+  return max;
+}
+
+Histogram::Histogram() {
+  for (auto& shard : m_shards) {
+    shard = std::make_unique<Shard>();
+  }
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (const auto& shard : m_shards) {
+    snapshot.count += shard->count.load(std::memory_order_relaxed);
+    snapshot.sum += shard->sum.load(std::memory_order_relaxed);
+    snapshot.min =
+        std::min(snapshot.min, shard->min.load(std::memory_order_relaxed));
+    snapshot.max =
+        std::max(snapshot.max, shard->max.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; ++i) {
+      snapshot.buckets[i] += shard->buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+void MetricsSnapshot::Merge(const MetricsSnapshot& other) {
+  for (const auto& [name, value] : other.counters) {
+    counters[name] += value;
+  }
+  for (const auto& [name, value] : other.gauges) {
+    gauges[name] = value;
+  }
+  for (const auto& [name, histogram] : other.histograms) {
+    histograms[name].Merge(histogram);
+  }
+}
+
+static constexpr double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+static constexpr const char* PERCENTILE_NAMES[] = {"p50", "p90", "p99",
+                                                   "p999"};
+
+// snprintf into a std::string
+template <typename... Args>
+static void Append(std::string& out, const char* fmt, Args... args) {
+  char buffer[256];
+  const int size = std::snprintf(buffer, sizeof(buffer), fmt, args...);
+  if (size > 0) {
+    out.append(buffer, std::min(static_cast<std::size_t>(size),
+                                sizeof(buffer) - 1));
+  }
+}
+
+std::string MetricsSnapshot::ToText() const {
+  std::string out;
+  for (const auto& [name, value] : counters) {
+    Append(out, "%s %" PRIu64 "\n", name.c_str(), value);
+  }
+  for (const auto& [name, value] : gauges) {
+    Append(out, "%s %" PRId64 "\n", name.c_str(), value);
+  }
+  for (const auto& [name, histogram] : histograms) {
+    Append(out, "%s count=%" PRIu64 " mean=%.1f", name.c_str(),
+           histogram.count, histogram.Mean());
+    if (histogram.count > 0) {
+      Append(out, " min=%" PRIu64, histogram.min);
+      for (std::size_t i = 0; i < std::size(PERCENTILES); ++i) {
+        Append(out, " %s=%" PRIu64, PERCENTILE_NAMES[i],
+               histogram.Percentile(PERCENTILES[i]));
+      }
+      Append(out, " max=%" PRIu64, histogram.max);
+    }
+    out += '\n';
+  }
+  return out;
+}
+
+std::string MetricsSnapshot::ToJson() const {
+  // Metric names are identifiers chosen by the code, so they are not escaped
+  std::string out = "{\"counters\":{";
+  const char* separator = "";
+  for (const auto& [name, value] : counters) {
+    Append(out, "%s\"%s\":%" PRIu64, separator, name.c_str(), value);
+    separator = ",";
+  }
+
+  out += "},\"gauges\":{";
+  separator = "";
+  for (const auto& [name, value] : gauges) {
+    Append(out, "%s\"%s\":%" PRId64, separator, name.c_str(), value);
+    separator = ",";
+  }
+
+  out += "},\"histograms\":{";
+  separator = "";
+  for (const auto& [name, histogram] : histograms) {
+    Append(out, "%s\"%s\":{\"count\":%" PRIu64 ",\"sum\":%" PRIu64, separator,
+           name.c_str(), histogram.count, histogram.sum);
+    separator = ",";
+    if (histogram.count > 0) {
+      Append(out, ",\"min\":%" PRIu64 ",\"max\":%" PRIu64, histogram.min,
+             histogram.max);
+      for (std::size_t i = 0; i < std::size(PERCENTILES); ++i) {
+        Append(out, ",\"%s\":%" PRIu64, PERCENTILE_NAMES[i],
+               histogram.Percentile(PERCENTILES[i]));
+      }
+    }
+    out += '}';
+  }
+  out += "}}";
+  return out;
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+// Find or create the metric called name
+template <typename T>
+static T& GetOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics,
+                      const std::string& name) {
+  std::unique_ptr<T>& metric = metrics[name];
+  if (!metric) {
+    metric = std::make_unique<T>();
+  }
+  return *metric;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return GetOrCreate(m_counters, name);
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return GetOrCreate(m_gauges, name);
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return GetOrCreate(m_histograms, name);
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  MetricsSnapshot snapshot;
+  for (const auto& [name, counter] : m_counters) {
+    snapshot.counters[name] = counter->Value();
+  }
+  for (const auto& [name, gauge] : m_gauges) {
+    snapshot.gauges[name] = gauge->Value();
+  }
+  for (const auto& [name, histogram] : m_histograms) {
+    snapshot.histograms[name] = histogram->Snapshot();
+  }
+  return snapshot;
+}
+
+PeriodicSnapshot::PeriodicSnapshot(const MetricsRegistry& registry,
+                                   std::chrono::milliseconds period,
+                                   Callback callback)
+    : m_registry(registry),
+      m_period(period),
+      m_callback(std::move(callback)),
+      m_thread(&PeriodicSnapshot::Run, this) {}
+
+PeriodicSnapshot::~PeriodicSnapshot() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_one();
+  m_thread.join();
+}
+
+void PeriodicSnapshot::Run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    m_cv.wait_for(lock, m_period, [this] { return m_stop; });
+    lock.unlock();
+    m_callback(m_registry.Snapshot());
+    lock.lock();
+  }
+}
+
+}  // namespace metrics
+}  // namespace jltx
@@ -24,14 +24,140 @@
 
 #include "util/TextUtils.hpp"
 
-#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define JLTX_TEXT_UTILS_AVX2 1
+#endif
+
 namespace jltx {
 
 namespace TextUtils {
 
+/** Longest delimiter searched with the SIMD first/last character filter */
+static constexpr std::size_t SIMD_DELIMITER_MAX = 16;
+
+/**
+ * \brief Scalar delimiter search, used for the tails of the SIMD loops and
+ * on targets without SSE2.
+ */
+static std::size_t FindScalar(std::string_view str, std::string_view delimiter,
+                              std::size_t pos) {
+  return str.find(delimiter, pos);
+}
+
+#if defined(__SSE2__)
+/**
+ * \brief Candidate filter for short delimiters: compare the first and last
+ * delimiter characters at 16 positions at once and verify the middle of every
+ * candidate with memcmp.
+ */
+static std::size_t FindSse2(std::string_view str, std::string_view delimiter,
+                            std::size_t pos) {
+  const char* s = str.data();
+  const std::size_t n = str.size();
+  const std::size_t k = delimiter.size();
+  const __m128i first = _mm_set1_epi8(delimiter.front());
+  const __m128i last = _mm_set1_epi8(delimiter.back());
+
+  std::size_t i = pos;
+  for (; i + k - 1 + 16 <= n; i += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k - 1));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                                        _mm_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      const std::size_t candidate = i + static_cast<std::size_t>(
+                                            __builtin_ctz(mask));
+      if ((k <= 2) ||
+          (std::memcmp(s + candidate + 1, delimiter.data() + 1, k - 2) == 0)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return FindScalar(str, delimiter, i);
+}
+#endif
+
+#if defined(JLTX_TEXT_UTILS_AVX2)
+/** \brief Same as FindSse2(), 32 positions at a time */
+__attribute__((target("avx2"))) static std::size_t FindAvx2(
+    std::string_view str, std::string_view delimiter, std::size_t pos) {
+  const char* s = str.data();
+  const std::size_t n = str.size();
+  const std::size_t k = delimiter.size();
+  const __m256i first = _mm256_set1_epi8(delimiter.front());
+  const __m256i last = _mm256_set1_epi8(delimiter.back());
+
+  std::size_t i = pos;
+  for (; i + k - 1 + 32 <= n; i += 32) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+    const __m256i block_last =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + k - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                         _mm256_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      const std::size_t candidate = i + static_cast<std::size_t>(
+                                            __builtin_ctz(mask));
+      if ((k <= 2) ||
+          (std::memcmp(s + candidate + 1, delimiter.data() + 1, k - 2) == 0)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return FindSse2(str, delimiter, i);
+}
+#endif
+
+std::size_t Find(std::string_view str, std::string_view delimiter,
+                 std::size_t pos) {
+  const std::size_t n = str.size();
+  const std::size_t k = delimiter.size();
+  if ((k == 0) || (pos > n) || (n - pos < k)) {
+    return FindScalar(str, delimiter, pos);
+  }
+
+  if (k == 1) {
+    // memchr is already vectorized by the C library
+    const void* found =
+        std::memchr(str.data() + pos, delimiter.front(), n - pos);
+    return (found != nullptr)
+               ? static_cast<std::size_t>(static_cast<const char*>(found) -
+                                          str.data())
+               : std::string_view::npos;
+  }
+
+  if (k <= SIMD_DELIMITER_MAX) {
+#if defined(JLTX_TEXT_UTILS_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+      return FindAvx2(str, delimiter, pos);
+    }
+#endif
+#if defined(__SSE2__)
+    return FindSse2(str, delimiter, pos);
+#endif
+  }
+
+  return FindScalar(str, delimiter, pos);
+}
+
 /**
  * \brief Checks if two std::strings are equal in value.
  * \param str1 First string.
@@ -51,50 +177,113 @@ bool Equals(const std::string& str1, const std::string& str2) {
 std::vector<std::string> Split(const std::string& str,
                                const std::string& delimiter) {
   std::vector<std::string> str_vec;
-  const std::size_t str_size = str.size();
-  const std::size_t sep_size = delimiter.size();
-
-  if (str_size > 0 && sep_size > 0) {
-    std::size_t pos = 0;
-    std::size_t found;
-    while (pos < str_size) {
-      found = str.find(delimiter, pos);
-      if (found == std::string::npos) {
-        // Not found -> add remaining substring
-        str_vec.push_back(str.substr(pos));
-        break;
-      } else {
-        // Found -> add substring
-        str_vec.push_back(str.substr(pos, found - pos));
-        pos = found + sep_size;
-      }
-    }
+  ForEachSplit(str, delimiter,
+               [&](std::string_view token) { str_vec.emplace_back(token); });
+  return str_vec;
+}
 
-    // Add an empty string if the last character is a separator
-    if (Equals(str.substr(str_size - sep_size), delimiter)) {
-      str_vec.push_back("");
-    }
-  }
+/**
+ * \brief Split a string by a delimiter substring into a memory resource
+ * \param str String
+ * \param delimiter Delimiter
+ * \param resource Memory resource for the vector and the strings
+ * \return A vector with the split substrings.
+ */
+std::pmr::vector<std::pmr::string> Split(std::string_view str,
+                                         std::string_view delimiter,
+                                         std::pmr::memory_resource* resource) {
+  std::pmr::vector<std::pmr::string> str_vec(resource);
+  ForEachSplit(str, delimiter,
+               [&](std::string_view token) { str_vec.emplace_back(token); });
+  return str_vec;
+}
 
+/**
+ * \brief Split a string by a delimiter substring without copying
+ * \param str String
+ * \param delimiter Delimiter
+ * \return A vector with views of the split substrings.
+ */
+std::vector<std::string_view> SplitView(std::string_view str,
+                                        std::string_view delimiter) {
+  std::vector<std::string_view> str_vec;
+  SplitTo(str, delimiter, std::back_inserter(str_vec));
   return str_vec;
 }
 
-static void ltrim(std::string& str) {
-  str.erase(str.begin(),
-            std::find_if(str.begin(), str.end(),
-                         [](unsigned char ch) { return !std::isspace(ch); }));
+/** \brief "C" locale std::isspace(): ' ' or '\t' to '\r' */
+static inline bool IsSpace(unsigned char ch) {
+  return (ch == ' ') || (static_cast<unsigned char>(ch - '\t') <= '\r' - '\t');
+}
+
+#if defined(__SSE2__)
+/** \brief Bit mask of the non-whitespace bytes in a 16 byte block */
+static inline uint32_t NonSpaceMask(const char* block) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+  const __m128i is_blank = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  // Unsigned range check '\t' <= v <= '\r' via saturating min/max
+  const __m128i clamped = _mm_min_epu8(
+      _mm_max_epu8(v, _mm_set1_epi8('\t')), _mm_set1_epi8('\r'));
+  const __m128i is_control = _mm_cmpeq_epi8(clamped, v);
+  const uint32_t space = static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_or_si128(is_blank, is_control)));
+  return ~space & 0xFFFF;
 }
+#endif
 
-static void rtrim(std::string& str) {
-  str.erase(std::find_if(str.rbegin(), str.rend(),
-                         [](unsigned char ch) { return !std::isspace(ch); })
-                .base(),
-            str.end());
+/** \brief Index of the first non-whitespace character, or size */
+static std::size_t FirstNonSpace(std::string_view str) {
+  const char* s = str.data();
+  const std::size_t n = str.size();
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    const uint32_t mask = NonSpaceMask(s + i);
+    if (mask != 0) {
+      return i + static_cast<std::size_t>(__builtin_ctz(mask));
+    }
+  }
+#endif
+  while ((i < n) && IsSpace(static_cast<unsigned char>(s[i]))) {
+    ++i;
+  }
+  return i;
+}
+
+/** \brief One past the last non-whitespace character, or 0 */
+static std::size_t LastNonSpaceEnd(std::string_view str) {
+  const char* s = str.data();
+  std::size_t end = str.size();
+#if defined(__SSE2__)
+  for (; end >= 16; end -= 16) {
+    const uint32_t mask = NonSpaceMask(s + end - 16);
+    if (mask != 0) {
+      return end - 16 + static_cast<std::size_t>(31 - __builtin_clz(mask)) + 1;
+    }
+  }
+#endif
+  while ((end > 0) && IsSpace(static_cast<unsigned char>(s[end - 1]))) {
+    --end;
+  }
+  return end;
+}
+
+[[nodiscard]] std::string_view TrimView(std::string_view str) {
+  const std::size_t begin = FirstNonSpace(str);
+  if (begin == str.size()) {
+    return str.substr(str.size());
+  }
+  return str.substr(begin, LastNonSpaceEnd(str) - begin);
 }
 
 void Trim(std::string& str) {
-  ltrim(str);
-  rtrim(str);
+  const std::string_view trimmed = TrimView(str);
+  const std::size_t begin =
+      static_cast<std::size_t>(trimmed.data() - str.data());
+
+  // Cut the end first so that only the kept characters are moved
+  str.erase(begin + trimmed.size());
+  str.erase(0, begin);
 }
 
 [[nodiscard]] std::string TrimCopy(std::string str) {
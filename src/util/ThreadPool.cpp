@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "util/ThreadPool.hpp"
+
+#include <mutex>
+
+namespace jltx {
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+  const std::size_t num_workers = (num_threads > 1) ? (num_threads - 1) : 0;
+  m_workers.reserve(num_workers);
+  for (std::size_t i = 0; i < num_workers; ++i) {
+    m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start_cv.notify_all();
+
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(std::size_t count,
+                             const std::function<void(std::size_t)>& task) {
+  if (count == 0) {  // Nothing to run
+    return;
+  }
+
+  if (m_workers.empty() || count == 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_count = count;
+    m_next.store(0, std::memory_order_relaxed);
+    m_active = m_workers.size();
+    ++m_generation;
+  }
+  m_start_cv.notify_all();
+
+  RunTasks();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done_cv.wait(lock, [this] { return m_active == 0; });
+  m_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+  uint64_t generation = 0;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start_cv.wait(
+          lock, [&] { return m_stop || (m_generation != generation); });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+    }
+
+    RunTasks();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_active == 0) {
+      m_done_cv.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks() {
+  while (true) {
+    const std::size_t i = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (i >= m_count) {
+      break;
+    }
+    (*m_task)(i);
+  }
+}
+
+}  // namespace jltx
@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/AlsaAudioSink.hpp"
+#include "util/Metrics.hpp"
+
+// These tests use ALSA's "null" PCM, which accepts and discards samples, so
+// they run without sound hardware. Build and run them with
+// "make audio_tests".
+
+static constexpr uint32_t SAMPLE_RATE = 48000;
+
+static uint64_t FramesWritten() {
+  return jltx::metrics::MetricsRegistry::Global()
+      .GetCounter("audio.alsa.frames_written")
+      .Value();
+}
+
+TEST(AlsaAudioSinkTest, SendReadWrite) {
+  jltx::audio::AlsaAudioSink sink(SAMPLE_RATE, jltx::audio::AccessMode::RW,
+                                  "null");
+  EXPECT_EQ(sink.Access(), jltx::audio::AccessMode::RW);
+  EXPECT_EQ(sink.SampleRate(), SAMPLE_RATE);
+
+  std::vector<float> buffer(256, 0.25f);
+  const uint64_t before = FramesWritten();
+  EXPECT_EQ(sink.Send(buffer.data(), 256), 256);
+  EXPECT_EQ(FramesWritten() - before, 256);
+
+  // BeginWrite() is only available in mmap mode
+  EXPECT_TRUE(sink.BeginWrite(64).empty());
+  EXPECT_EQ(sink.CommitWrite(64), 0);
+}
+
+TEST(AlsaAudioSinkTest, MmapWrite) {
+  jltx::audio::AlsaAudioSink sink(SAMPLE_RATE, jltx::audio::AccessMode::MMAP,
+                                  "null");
+  const uint64_t before = FramesWritten();
+
+  // Write several times the ring buffer size, so it wraps around and the
+  // stream has to start
+  uint32_t written = 0;
+  while (written < SAMPLE_RATE) {
+    const std::span<float> area = sink.BeginWrite(512);
+    ASSERT_FALSE(area.empty());
+    ASSERT_LE(area.size(), 512);
+    for (float& sample : area) {
+      sample = 0.5f;
+    }
+    ASSERT_EQ(sink.CommitWrite(static_cast<uint32_t>(area.size())),
+              area.size());
+    written += static_cast<uint32_t>(area.size());
+  }
+  EXPECT_EQ(FramesWritten() - before, written);
+
+  // A partial commit only hands over the frames written
+  const std::span<float> area = sink.BeginWrite(128);
+  ASSERT_FALSE(area.empty());
+  EXPECT_EQ(sink.CommitWrite(1), 1);
+
+  // Send() goes through the same path
+  std::vector<float> buffer(1000, 0.0f);
+  EXPECT_EQ(sink.Send(buffer.data(), 1000), 1000);
+}
+
+TEST(AlsaAudioSinkTest, PlaybackThreadRender) {
+  for (const auto access :
+       {jltx::audio::AccessMode::RW, jltx::audio::AccessMode::MMAP}) {
+    jltx::audio::AlsaAudioSink sink(SAMPLE_RATE, access, "null");
+    ASSERT_GT(sink.PeriodFrames(), 0);
+    const uint64_t before = FramesWritten();
+
+    std::atomic<uint64_t> rendered{0};
+    jltx::audio::PlaybackOptions options;
+    options.render = [&](std::span<float> out) {
+      EXPECT_LE(out.size(), sink.PeriodFrames());
+      std::fill(out.begin(), out.end(), 0.1f);
+      rendered += out.size();
+    };
+    ASSERT_TRUE(sink.StartPlayback(options));
+    EXPECT_FALSE(sink.StartPlayback());
+    EXPECT_EQ(sink.Pump(options.render), 0);
+
+    while (rendered.load() < 4 * sink.BufferFrames()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sink.StopPlayback();
+    EXPECT_EQ(FramesWritten() - before, rendered.load());
+  }
+}
+
+TEST(AlsaAudioSinkTest, PlaybackThreadQueue) {
+  jltx::audio::AlsaAudioSink sink(SAMPLE_RATE, jltx::audio::AccessMode::RW,
+                                  "null");
+  ASSERT_TRUE(sink.StartPlayback());
+  EXPECT_FALSE(sink.IsMemoryLocked());
+
+  // Send() blocks until the thread has taken everything but the last ring
+  std::vector<float> buffer(SAMPLE_RATE / 10, 0.2f);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(sink.Send(buffer.data(), static_cast<uint32_t>(buffer.size())),
+              buffer.size());
+  }
+  sink.StopPlayback();
+
+  // Without the thread, samples go to the device again
+  EXPECT_EQ(sink.Send(buffer.data(), 256), 256);
+}
+
+TEST(AlsaAudioSinkTest, ConfigNegotiation) {
+  jltx::audio::AlsaConfig config;
+  config.device = "null";
+  config.channels = 2;
+  config.format = jltx::audio::SampleFormat::S16;
+  config.period_frames = 256;
+  config.periods = 4;
+  config.start_threshold = 512;
+  jltx::audio::AlsaAudioSink sink(config);
+  ASSERT_TRUE(sink.IsOpen());
+  EXPECT_EQ(sink.Error(), 0);
+
+  const jltx::audio::AlsaStreamInfo& info = sink.Negotiated();
+  EXPECT_EQ(info.sample_rate, SAMPLE_RATE);
+  EXPECT_EQ(info.channels, 2);
+  EXPECT_EQ(info.format, jltx::audio::SampleFormat::S16);
+  EXPECT_GT(info.period_frames, 0);
+  EXPECT_GE(info.buffer_frames, info.period_frames);
+  EXPECT_EQ(info.start_threshold, 512);
+  EXPECT_NE(info.ToText().find("channels 2\nformat S16\n"), std::string::npos);
+
+  // Sizes are in frames of two samples
+  std::vector<float> interleaved(2 * 1000, 0.25f);
+  const uint64_t before = FramesWritten();
+  EXPECT_EQ(sink.Send(interleaved.data(), 1000), 1000);
+  EXPECT_EQ(FramesWritten() - before, 1000);
+
+  std::vector<float> left(700, 0.5f);
+  std::vector<float> right(700, -0.5f);
+  const float* planes[] = {left.data(), right.data()};
+  EXPECT_EQ(sink.SendPlanar(planes, 700), 700);
+  EXPECT_EQ(sink.SendPlanar(std::span(planes).first(1), 700), 0);
+}
+
+TEST(AlsaAudioSinkTest, MmapConvertedFormat) {
+  jltx::audio::AlsaConfig config;
+  config.device = "null";
+  config.channels = 8;
+  config.format = jltx::audio::SampleFormat::S24;
+  config.access = jltx::audio::AccessMode::MMAP;
+  jltx::audio::AlsaAudioSink sink(config);
+  ASSERT_TRUE(sink.IsOpen());
+
+  // Device memory is not float, so it cannot be handed out
+  EXPECT_TRUE(sink.BeginWrite(64).empty());
+
+  std::vector<float> interleaved(8 * SAMPLE_RATE / 10, 0.1f);
+  EXPECT_EQ(sink.Send(interleaved.data(), SAMPLE_RATE / 10),
+            SAMPLE_RATE / 10);
+}
+
+TEST(AlsaAudioSinkTest, PlaybackThreadConvertedFormat) {
+  for (const auto access :
+       {jltx::audio::AccessMode::RW, jltx::audio::AccessMode::MMAP}) {
+    jltx::audio::AlsaConfig config;
+    config.device = "null";
+    config.channels = 2;
+    config.format = jltx::audio::SampleFormat::S32;
+    config.access = access;
+    jltx::audio::AlsaAudioSink sink(config);
+    ASSERT_TRUE(sink.IsOpen());
+    const uint64_t before = FramesWritten();
+
+    std::atomic<uint64_t> rendered{0};
+    jltx::audio::PlaybackOptions options;
+    options.render = [&](std::span<float> out) {
+      EXPECT_EQ(out.size(), 2 * sink.PeriodFrames());
+      std::fill(out.begin(), out.end(), 0.1f);
+      rendered += out.size() / 2;
+    };
+    ASSERT_TRUE(sink.StartPlayback(options));
+    while (rendered.load() < 4 * sink.BufferFrames()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sink.StopPlayback();
+    EXPECT_EQ(FramesWritten() - before, rendered.load());
+  }
+}
+
+TEST(AlsaAudioSinkTest, OpenFailure) {
+  jltx::audio::AlsaConfig config;
+  config.device = "missing";  // No such PCM
+  jltx::audio::AlsaAudioSink sink(config);
+  EXPECT_FALSE(sink.IsOpen());
+  EXPECT_LT(sink.Error(), 0);
+
+  std::vector<float> buffer(256, 0.0f);
+  EXPECT_EQ(sink.Send(buffer.data(), 256), 0);
+  EXPECT_FALSE(sink.StartPlayback());
+}
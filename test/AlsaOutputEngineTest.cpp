@@ -0,0 +1,174 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "audio/AlsaAudioSink.hpp"
+#include "audio/AlsaOutputEngine.hpp"
+#include "util/Metrics.hpp"
+
+// Like AlsaAudioSinkTest, these run on ALSA's "null" PCM with
+// "make audio_tests"
+
+static uint64_t FramesWritten() {
+  return jltx::metrics::MetricsRegistry::Global()
+      .GetCounter("audio.alsa.frames_written")
+      .Value();
+}
+
+static jltx::audio::AlsaConfig NullConfig() {
+  jltx::audio::AlsaConfig config;
+  config.device = "null";
+  config.nonblocking = true;
+  return config;
+}
+
+TEST(AlsaOutputEngineTest, PumpFillsAvailableRoom) {
+  jltx::audio::AlsaAudioSink sink(NullConfig());
+  ASSERT_TRUE(sink.IsOpen());
+  EXPECT_TRUE(sink.NonBlocking());
+  EXPECT_FALSE(sink.PollDescriptors().empty());
+
+  uint64_t rendered = 0;
+  const jltx::audio::RenderCallback render = [&](std::span<float> out) {
+    EXPECT_LE(out.size(), sink.PeriodFrames());
+    std::fill(out.begin(), out.end(), 0.0f);
+    rendered += out.size();
+  };
+  const uint64_t before = FramesWritten();
+  const uint32_t written = sink.Pump(render);
+  EXPECT_GT(written, 0);
+  EXPECT_LE(written, sink.BufferFrames());
+  EXPECT_EQ(written, rendered);
+  EXPECT_EQ(FramesWritten() - before, written);
+
+  EXPECT_LE(sink.Pump(render, 10), 10);
+  EXPECT_EQ(sink.Pump(nullptr), 0);
+}
+
+TEST(AlsaOutputEngineTest, NonBlockingBeginWrite) {
+  jltx::audio::AlsaConfig config = NullConfig();
+  config.access = jltx::audio::AccessMode::MMAP;
+  jltx::audio::AlsaAudioSink sink(config);
+  ASSERT_TRUE(sink.IsOpen());
+
+  // Once the device buffer is full, BeginWrite() returns instead of waiting
+  bool full = false;
+  for (int i = 0; i < 100; ++i) {
+    const std::span<float> area = sink.BeginWrite(sink.BufferFrames());
+    if (area.empty()) {
+      full = true;
+      break;
+    }
+    std::fill(area.begin(), area.end(), 0.0f);
+    sink.CommitWrite(static_cast<uint32_t>(area.size() / sink.Channels()));
+  }
+  EXPECT_TRUE(full);
+}
+
+TEST(AlsaOutputEngineTest, RejectsBlockingSinks) {
+  jltx::audio::AlsaOutputEngine engine;
+  ASSERT_TRUE(engine.IsValid());
+  jltx::audio::AlsaConfig config = NullConfig();
+  config.nonblocking = false;
+  jltx::audio::AlsaAudioSink sink(config);
+  EXPECT_FALSE(engine.Add(sink, [](std::span<float>) {}));
+
+  jltx::audio::AlsaAudioSink nonblocking(NullConfig());
+  EXPECT_FALSE(engine.Add(nonblocking, nullptr));
+  EXPECT_TRUE(engine.Add(nonblocking, [](std::span<float>) {}));
+  EXPECT_EQ(engine.Size(), 1);
+  EXPECT_TRUE(engine.Remove(nonblocking));
+  EXPECT_FALSE(engine.Remove(nonblocking));
+  EXPECT_EQ(engine.Size(), 0);
+}
+
+TEST(AlsaOutputEngineTest, RunOnce) {
+  jltx::audio::AlsaAudioSink sink(NullConfig());
+  jltx::audio::AlsaOutputEngine engine;
+  uint64_t rendered = 0;
+  ASSERT_TRUE(engine.Add(sink, [&](std::span<float> out) {
+    std::fill(out.begin(), out.end(), 0.0f);
+    rendered += out.size();
+  }));
+
+  // The device has room right away
+  EXPECT_EQ(engine.RunOnce(1000), 1);
+  EXPECT_GT(rendered, 0);
+}
+
+TEST(AlsaOutputEngineTest, ManyDevicesOneThread) {
+  // Different layouts and access modes on the same engine thread
+  std::array<jltx::audio::AlsaConfig, 3> configs = {NullConfig(), NullConfig(),
+                                                    NullConfig()};
+  configs[1].channels = 2;
+  configs[1].format = jltx::audio::SampleFormat::S16;
+  configs[2].channels = 8;
+  configs[2].format = jltx::audio::SampleFormat::S32;
+  configs[2].access = jltx::audio::AccessMode::MMAP;
+
+  std::vector<std::unique_ptr<jltx::audio::AlsaAudioSink>> sinks;
+  std::array<std::atomic<uint64_t>, 3> rendered{};
+  std::thread::id render_thread;
+  std::atomic<bool> same_thread{true};
+  jltx::audio::AlsaOutputEngine engine;
+  const uint64_t before = FramesWritten();
+  for (std::size_t i = 0; i < configs.size(); ++i) {
+    sinks.push_back(std::make_unique<jltx::audio::AlsaAudioSink>(configs[i]));
+    ASSERT_TRUE(sinks.back()->IsOpen());
+    const uint32_t channels = sinks.back()->Channels();
+    const auto render = [&, i, channels](std::span<float> out) {
+      if (render_thread == std::thread::id()) {
+        render_thread = std::this_thread::get_id();
+      }
+      same_thread = same_thread && render_thread == std::this_thread::get_id();
+      EXPECT_EQ(out.size() % channels, 0);
+      std::fill(out.begin(), out.end(), 0.1f);
+      rendered[i] += out.size() / channels;
+    };
+    ASSERT_TRUE(engine.Add(*sinks.back(), render));
+  }
+
+  ASSERT_TRUE(engine.Start(false));
+  EXPECT_FALSE(engine.Start());
+  EXPECT_FALSE(engine.Add(*sinks[0], [](std::span<float>) {}));
+  for (std::size_t i = 0; i < sinks.size(); ++i) {
+    while (rendered[i].load() < 4 * sinks[i]->PeriodFrames()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  engine.Stop();
+
+  EXPECT_TRUE(same_thread.load());
+  EXPECT_EQ(FramesWritten() - before,
+            rendered[0].load() + rendered[1].load() + rendered[2].load());
+}
@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "memory/Arena.hpp"
+#include "util/TextUtils.hpp"
+
+using jltx::memory::MonotonicArena;
+
+TEST(ArenaTest, Alignment) {
+  MonotonicArena arena(1024);
+  for (const std::size_t alignment : {1, 2, 8, 16, 64, 256}) {
+    (void)arena.Allocate(1, 1);
+    const auto address =
+        reinterpret_cast<uintptr_t>(arena.Allocate(10, alignment));
+    EXPECT_EQ(address % alignment, 0u) << alignment;
+  }
+}
+
+TEST(ArenaTest, ResetKeepsMemory) {
+  MonotonicArena arena(1024);
+  std::vector<void*> first;
+  for (int i = 0; i < 100; ++i) {
+    first.push_back(arena.Allocate(100, 8));
+  }
+  EXPECT_GE(arena.BytesUsed(), 10000u);
+  const std::size_t reserved = arena.BytesReserved();
+
+  arena.Reset();
+  EXPECT_EQ(arena.BytesUsed(), 0u);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(arena.Allocate(100, 8), first[i]);
+  }
+  EXPECT_EQ(arena.BytesReserved(), reserved);
+}
+
+TEST(ArenaTest, LargerThanChunk) {
+  MonotonicArena arena(256);
+  auto* small = static_cast<char*>(arena.Allocate(100));
+  auto* large = static_cast<char*>(arena.Allocate(10000, 64));
+  std::fill_n(large, 10000, 'x');
+  std::fill_n(small, 100, 'y');
+  EXPECT_EQ(large[9999], 'x');
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 64, 0u);
+
+  // The large chunk is skipped by small requests until it is needed again
+  arena.Reset();
+  EXPECT_EQ(arena.Allocate(100), small);
+  EXPECT_NE(arena.Allocate(10000, 64), nullptr);
+}
+
+TEST(ArenaTest, PmrContainers) {
+  MonotonicArena arena;
+  jltx::memory::ArenaResource resource(arena);
+  std::pmr::vector<std::pmr::string> strings(&resource);
+  for (int i = 0; i < 100; ++i) {
+    strings.emplace_back(std::string(50, static_cast<char>('a' + i % 26)));
+  }
+  EXPECT_EQ(std::string_view(strings[99]), std::string(50, 'v'));
+  EXPECT_GT(arena.BytesUsed(), 100u * 50u);
+
+  jltx::memory::ArenaResource same(arena);
+  EXPECT_TRUE(resource.is_equal(same));
+  EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST(ArenaTest, SplitIntoArena) {
+  MonotonicArena arena;
+  jltx::memory::ArenaResource resource(arena);
+  const std::string line =
+      "a fairly long first token;second token that is not short;;last";
+  const auto tokens = jltx::TextUtils::Split(line, ";", &resource);
+  ASSERT_EQ(tokens.size(), 4u);
+  EXPECT_EQ(tokens[0], "a fairly long first token");
+  EXPECT_EQ(tokens[2], "");
+  EXPECT_EQ(tokens[3], "last");
+  EXPECT_EQ(tokens.get_allocator().resource(), &resource);
+  EXPECT_GT(arena.BytesUsed(), 0u);
+}
@@ -0,0 +1,200 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "audio/FileAudioSink.hpp"
+#include "audio/NullAudioSink.hpp"
+
+using jltx::audio::FileContainer;
+using jltx::audio::FileWriteMode;
+using jltx::audio::SampleFormat;
+
+static std::vector<char> ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+static uint32_t Get(const std::vector<char>& data, std::size_t offset,
+                    std::size_t bytes) {
+  uint32_t value = 0;
+  for (std::size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data[offset + i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+static std::vector<float> Ramp(std::size_t size) {
+  std::vector<float> samples(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    samples[i] = static_cast<float>(i % 2000) / 1000.0f - 1.0f;
+  }
+  return samples;
+}
+
+TEST(AudioSinkTest, WavWriteModes) {
+  const std::string path = testing::TempDir() + "jltx_audio_sink_test.wav";
+  constexpr uint32_t FRAMES = 10000;
+  const std::vector<float> samples = Ramp(2 * FRAMES);
+  std::vector<int16_t> expected(samples.size());
+  jltx::audio::ConvertFromFloat(samples, SampleFormat::S16, expected.data());
+
+  for (const auto mode : {FileWriteMode::BUFFERED, FileWriteMode::DIRECT,
+                          FileWriteMode::MMAP}) {
+    jltx::audio::FileSinkConfig config;
+    config.path = path.c_str();
+    config.sample_rate = 44100;
+    config.channels = 2;
+    config.format = SampleFormat::S16;
+    config.mode = mode;
+    config.buffer_size = 4096;  // Several buffers per file
+    jltx::audio::FileAudioSink sink(config);
+    if (mode == FileWriteMode::DIRECT && sink.Error() == EINVAL) {
+      continue;  // The file system does not support O_DIRECT
+    }
+    ASSERT_TRUE(sink.IsOpen()) << "mode " << static_cast<int>(mode);
+
+    // Uneven pieces
+    uint32_t sent = 0;
+    for (uint32_t size = 1; sent < FRAMES; size = size * 3 + 1) {
+      const uint32_t count = std::min(size, FRAMES - sent);
+      ASSERT_EQ(sink.Send(samples.data() + 2 * sent, count), count);
+      sent += count;
+    }
+    EXPECT_EQ(sink.FramesWritten(), FRAMES);
+    EXPECT_TRUE(sink.Close());
+    EXPECT_FALSE(sink.IsOpen());
+
+    const std::vector<char> data = ReadFile(path);
+    ASSERT_EQ(data.size(), 44 + 4 * FRAMES);
+    EXPECT_EQ(std::memcmp(data.data(), "RIFF", 4), 0);
+    EXPECT_EQ(Get(data, 4, 4), data.size() - 8);
+    EXPECT_EQ(std::memcmp(data.data() + 8, "WAVEfmt ", 8), 0);
+    EXPECT_EQ(Get(data, 20, 2), 1);  // PCM
+    EXPECT_EQ(Get(data, 22, 2), 2);
+    EXPECT_EQ(Get(data, 24, 4), 44100);
+    EXPECT_EQ(Get(data, 28, 4), 44100 * 4);
+    EXPECT_EQ(Get(data, 32, 2), 4);
+    EXPECT_EQ(Get(data, 34, 2), 16);
+    EXPECT_EQ(std::memcmp(data.data() + 36, "data", 4), 0);
+    EXPECT_EQ(Get(data, 40, 4), 4 * FRAMES);
+    EXPECT_EQ(std::memcmp(data.data() + 44, expected.data(), 4 * FRAMES), 0);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(AudioSinkTest, WavExtensible) {
+  const std::string path = testing::TempDir() + "jltx_audio_sink_test.wav";
+  jltx::audio::FileSinkConfig config;
+  config.path = path.c_str();
+  config.channels = 3;
+  config.format = SampleFormat::S24;
+  const std::vector<float> samples = Ramp(3 * 100);
+  {
+    jltx::audio::FileAudioSink sink(config);
+    EXPECT_EQ(sink.Send(samples.data(), 100), 100);
+  }
+
+  const std::vector<char> data = ReadFile(path);
+  ASSERT_EQ(data.size(), 68 + 3 * 4 * 100);
+  EXPECT_EQ(Get(data, 16, 4), 40);
+  EXPECT_EQ(Get(data, 20, 2), 0xFFFE);
+  EXPECT_EQ(Get(data, 34, 2), 32);  // Container
+  EXPECT_EQ(Get(data, 38, 2), 24);  // Valid bits
+  EXPECT_EQ(Get(data, 44, 2), 1);   // PCM subformat
+  EXPECT_EQ(std::memcmp(data.data() + 60, "data", 4), 0);
+  EXPECT_EQ(Get(data, 64, 4), 3 * 4 * 100);
+
+  // Valid bits are the high 24 of every word
+  EXPECT_EQ(Get(data, 68, 4), 0x80000000);          // -1.0
+  EXPECT_EQ(Get(data, 68 + 4 * 3, 4), 0x80624E00);  // -0.997
+  std::vector<int32_t> expected(samples.size());
+  jltx::audio::ConvertFromFloat(samples, SampleFormat::S24, expected.data());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(Get(data, 68 + 4 * i, 4),
+              static_cast<uint32_t>(expected[i]) << 8)
+        << "sample " << i;
+  }
+  std::remove(path.c_str());
+}
+
+TEST(AudioSinkTest, RawFloat) {
+  const std::string path = testing::TempDir() + "jltx_audio_sink_test.raw";
+  const std::vector<float> samples = Ramp(5000);
+  jltx::audio::FileSinkConfig config;
+  config.path = path.c_str();
+  config.container = FileContainer::RAW;
+  config.mode = FileWriteMode::MMAP;
+  config.buffer_size = 1;  // Rounded up to one block
+  {
+    jltx::audio::FileAudioSink sink(config);
+    jltx::audio::AudioSink& base = sink;
+    EXPECT_EQ(base.Send(samples.data(), 5000), 5000);
+  }
+
+  const std::vector<char> data = ReadFile(path);
+  ASSERT_EQ(data.size(), 5000 * sizeof(float));
+  EXPECT_EQ(std::memcmp(data.data(), samples.data(), data.size()), 0);
+  std::remove(path.c_str());
+}
+
+TEST(AudioSinkTest, OpenFailure) {
+  jltx::audio::FileSinkConfig config;
+  config.path = "/nonexistent/jltx_audio_sink_test.wav";
+  jltx::audio::FileAudioSink sink(config);
+  EXPECT_FALSE(sink.IsOpen());
+  EXPECT_EQ(sink.Error(), ENOENT);
+  const float sample = 0.0f;
+  EXPECT_EQ(sink.Send(&sample, 1), 0);
+  EXPECT_FALSE(sink.Close());
+}
+
+TEST(AudioSinkTest, NullSink) {
+  jltx::audio::NullAudioSink sink(48000, 2);
+  EXPECT_TRUE(sink.IsOpen());
+  EXPECT_EQ(sink.Channels(), 2);
+  EXPECT_EQ(sink.FramesPerSecond(), 0.0);
+
+  const std::vector<float> samples(2 * 512, 0.0f);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(sink.Send(samples.data(), 512), 512);
+  }
+  EXPECT_EQ(sink.FramesWritten(), 100 * 512);
+  EXPECT_GT(sink.FramesPerSecond(), 0.0);
+  EXPECT_GT(sink.RealtimeFactor(), 1.0);
+
+  sink.Reset();
+  EXPECT_EQ(sink.FramesWritten(), 0);
+}
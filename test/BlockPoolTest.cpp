@@ -0,0 +1,212 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "memory/AlignedBlock.hpp"
+#include "memory/BlockPool.hpp"
+
+using jltx::memory::BlockPool;
+
+TEST(BlockPoolTest, AllocatesEveryBlockOnce) {
+  BlockPool pool(100, 64);
+  EXPECT_EQ(pool.BlockSize(), 100u);
+  EXPECT_EQ(pool.Capacity(), 64u);
+
+  std::set<void*> blocks;
+  for (int i = 0; i < 64; ++i) {
+    void* block = pool.Allocate();
+    ASSERT_NE(block, nullptr);
+    EXPECT_TRUE(pool.Owns(block));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) %
+                  jltx::memory::CACHE_LINE_SIZE,
+              0u);
+    std::memset(block, i, 100);
+    blocks.insert(block);
+  }
+  EXPECT_EQ(blocks.size(), 64u);
+  EXPECT_EQ(pool.Allocate(), nullptr);
+
+  for (void* block : blocks) {
+    pool.Free(block);
+  }
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(blocks.count(pool.Allocate()), 1u);
+  }
+}
+
+TEST(BlockPoolTest, Owns) {
+  BlockPool pool(64, 4);
+  int local = 0;
+  EXPECT_FALSE(pool.Owns(&local));
+  auto* block = static_cast<char*>(pool.Allocate());
+  EXPECT_FALSE(pool.Owns(block + 1));
+  pool.Free(block);
+  pool.Free(nullptr);
+}
+
+TEST(BlockPoolTest, Handle) {
+  BlockPool pool(256 * sizeof(float), 1);
+  {
+    auto block = pool.Acquire<float>();
+    ASSERT_TRUE(block);
+    EXPECT_EQ(block.size(), 256u);
+    block[255] = 1.0f;
+    EXPECT_FALSE(pool.Acquire<float>());
+
+    auto moved = std::move(block);
+    EXPECT_FALSE(block);
+    EXPECT_EQ(moved[255], 1.0f);
+  }
+  EXPECT_TRUE(pool.Acquire<float>());
+}
+
+// Blocks cached by a thread come back to the pool when the thread exits
+TEST(BlockPoolTest, CachesReturnOnThreadExit) {
+  BlockPool pool(64, 16);
+  std::thread([&] {
+    for (int i = 0; i < 16; ++i) {
+      pool.Free(pool.Allocate());
+    }
+  }).join();
+
+  std::vector<void*> blocks;
+  while (void* block = pool.Allocate()) {
+    blocks.push_back(block);
+  }
+  EXPECT_EQ(blocks.size(), 16u);
+}
+
+// Cached blocks of a destroyed pool are dropped, not handed to a new one
+TEST(BlockPoolTest, ManyPools) {
+  for (int round = 0; round < 100; ++round) {
+    BlockPool pool(32, 8);
+    void* block = pool.Allocate();
+    ASSERT_NE(block, nullptr);
+    pool.Free(block);
+  }
+}
+
+// More pools in use than cache slots, taken in turn
+TEST(BlockPoolTest, AlternatingPools) {
+  std::vector<std::unique_ptr<BlockPool>> pools;
+  for (int i = 0; i < 12; ++i) {
+    pools.push_back(std::make_unique<BlockPool>(32, 16));
+  }
+  for (int round = 0; round < 100; ++round) {
+    for (auto& pool : pools) {
+      void* block = pool->Allocate();
+      ASSERT_NE(block, nullptr);
+      pool->Free(block);
+    }
+  }
+  for (auto& pool : pools) {
+    std::vector<void*> blocks;
+    while (void* block = pool->Allocate()) {
+      blocks.push_back(block);
+    }
+    EXPECT_EQ(blocks.size(), 16u);
+    for (void* block : blocks) {
+      pool->Free(block);
+    }
+  }
+}
+
+TEST(BlockPoolTest, Threads) {
+  constexpr int THREADS = 4;
+  constexpr int ROUNDS = 20000;
+  // Enough for every thread's 40 blocks and a full cache each
+  BlockPool pool(sizeof(uint64_t), THREADS * (40 + BlockPool::CACHE_BLOCKS));
+  std::atomic<bool> corrupted{false};
+  std::atomic<int> failed{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<uint64_t*> held;
+      for (int i = 0; i < ROUNDS; ++i) {
+        if (held.size() < 40 && (i % 3) != 2) {
+          auto* block = static_cast<uint64_t*>(pool.Allocate());
+          if (block == nullptr) {
+            ++failed;
+            continue;
+          }
+          *block = (uint64_t(t) << 32) | uint64_t(i);
+          held.push_back(block);
+        } else if (!held.empty()) {
+          // Free the oldest, and check no one else wrote to it
+          uint64_t* block = held.front();
+          held.erase(held.begin());
+          if ((*block >> 32) != uint64_t(t)) {
+            corrupted = true;
+          }
+          pool.Free(block);
+        }
+      }
+      for (uint64_t* block : held) {
+        pool.Free(block);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(corrupted);
+  EXPECT_EQ(failed, 0);
+}
+
+TEST(BlockPoolTest, PoolResource) {
+  BlockPool pool(256, 4);
+  jltx::memory::PoolResource resource(pool);
+  std::pmr::vector<float> small(32, 1.0f, &resource);
+  EXPECT_TRUE(pool.Owns(small.data()));
+  // Larger than a block
+  std::pmr::vector<float> large(1000, 1.0f, &resource);
+  EXPECT_FALSE(pool.Owns(large.data()));
+}
+
+TEST(AlignedBlockTest, Alignment) {
+  jltx::memory::AlignedBlock<float> block(1000);
+  EXPECT_EQ(block.size(), 1000u);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(block.data()) % 64, 0u);
+  EXPECT_TRUE(std::all_of(block.begin(), block.end(),
+                          [](float x) { return x == 0.0f; }));
+
+  jltx::memory::AlignedBlock<double, 128> wide(3);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(wide.data()) % 128, 0u);
+  auto moved = std::move(wide);
+  EXPECT_TRUE(wide.empty());
+  EXPECT_EQ(moved.Span().size(), 3u);
+  EXPECT_TRUE(jltx::memory::AlignedBlock<int>().empty());
+}
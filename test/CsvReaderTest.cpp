@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/CsvReader.hpp"
+#include "util/ThreadPool.hpp"
+
+using Rows = std::vector<std::vector<std::string>>;
+
+static Rows Parse(std::string_view data,
+                  jltx::TextUtils::CsvOptions options = {},
+                  jltx::ThreadPool* pool = nullptr) {
+  Rows rows;
+  jltx::TextUtils::CsvReader(data, options)
+      .ForEachRow(
+          [&](const jltx::TextUtils::CsvRow& row) {
+            EXPECT_EQ(row.index, rows.size());
+            rows.emplace_back(row.fields.begin(), row.fields.end());
+          },
+          pool);
+  return rows;
+}
+
+TEST(CsvReaderTest, Fields) {
+  EXPECT_EQ(Parse(""), Rows{});
+  EXPECT_EQ(Parse("a,b,c"), (Rows{{"a", "b", "c"}}));
+  EXPECT_EQ(Parse("a,b\nc,d\n"), (Rows{{"a", "b"}, {"c", "d"}}));
+  EXPECT_EQ(Parse("a,,\n,b"), (Rows{{"a", "", ""}, {"", "b"}}));
+  EXPECT_EQ(Parse("a,b\r\nc,d\r\n"), (Rows{{"a", "b"}, {"c", "d"}}));
+  EXPECT_EQ(Parse("a\n\n\r\nb\n"), (Rows{{"a"}, {"b"}}));
+
+  jltx::TextUtils::CsvOptions options;
+  options.delimiter = ';';
+  options.skip_empty_lines = false;
+  EXPECT_EQ(Parse("a;b\n\nc,d", options), (Rows{{"a", "b"}, {""}, {"c,d"}}));
+}
+
+TEST(CsvReaderTest, QuotedFields) {
+  EXPECT_EQ(Parse("\"a,b\",c\n"), (Rows{{"a,b", "c"}}));
+  EXPECT_EQ(Parse("\"multi\nline\",x\r\ny"),
+            (Rows{{"multi\nline", "x"}, {"y"}}));
+  EXPECT_EQ(Parse("\"\",\"\"\"\""), (Rows{{"", "\"\""}}));
+  EXPECT_EQ(jltx::TextUtils::CsvReader::Unquote("say \"\"hi\"\""),
+            "say \"hi\"");
+
+  jltx::TextUtils::CsvOptions options;
+  options.quote = '\0';
+  EXPECT_EQ(Parse("\"a,b\"", options), (Rows{{"\"a", "b\""}}));
+}
+
+TEST(CsvReaderTest, TextAfterClosingQuote) {
+  EXPECT_EQ(Parse("\"ab\"c,d"), (Rows{{"\"ab\"c", "d"}}));
+  EXPECT_EQ(Parse("x,\"ab\" \r\ny"), (Rows{{"x", "\"ab\" "}, {"y"}}));
+  EXPECT_EQ(Parse("\"ab\"\r\n\"cd\""), (Rows{{"ab"}, {"cd"}}));
+}
+
+TEST(CsvReaderTest, ParallelMatchesSerial) {
+  std::string data;
+  for (int i = 0; i < 2000; ++i) {
+    data += std::to_string(i) + ",\"quoted, with\nline break " +
+            std::to_string(i) + "\",\"\"\"\",last\n";
+  }
+
+  jltx::TextUtils::CsvOptions options;
+  options.chunk_size = 1000;  // Many chunks, most starting inside a row
+  jltx::ThreadPool pool(4);
+
+  const Rows serial = Parse(data, options);
+  ASSERT_EQ(serial.size(), 2000);
+  EXPECT_EQ(Parse(data, options, &pool), serial);
+}
+
+// A quote inside an unquoted field is a plain character, and the quotes
+// after it no longer pair up
+TEST(CsvReaderTest, ParallelQuoteInsideUnquotedField) {
+  std::string data = "ab\"c,d\n";
+  for (int i = 0; i < 2000; ++i) {
+    data += std::to_string(i) + ",\"quoted\nline break\",x\"y\n";
+  }
+
+  jltx::TextUtils::CsvOptions options;
+  options.chunk_size = 1000;
+  jltx::ThreadPool pool(4);
+
+  const Rows serial = Parse(data, options);
+  ASSERT_EQ(serial.size(), 2001);
+  EXPECT_EQ(serial[0], (std::vector<std::string>{"ab\"c", "d"}));
+  EXPECT_EQ(serial[1],
+            (std::vector<std::string>{"0", "quoted\nline break", "x\"y"}));
+  EXPECT_EQ(Parse(data, options, &pool), serial);
+}
+
+TEST(CsvReaderTest, MappedFile) {
+  const std::string path = testing::TempDir() + "jltx_csv_reader_test.csv";
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  fputs("x,y\n1,2\n", file);
+  fclose(file);
+
+  {
+    jltx::TextUtils::MappedFile mapped(path);
+    ASSERT_TRUE(mapped.IsOpen());
+    EXPECT_EQ(Parse(mapped.Data()), (Rows{{"x", "y"}, {"1", "2"}}));
+  }
+  std::remove(path.c_str());
+
+  jltx::TextUtils::MappedFile missing(path);
+  EXPECT_FALSE(missing.IsOpen());
+}
@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "audio/FormatConversion.hpp"
+
+using jltx::audio::SampleFormat;
+
+// Reference conversion: scale by 2^(bits - 1), round and clip
+static int64_t Reference(float x, int bits) {
+  const double max = std::ldexp(1.0, bits - 1);
+  if (std::isnan(x)) {
+    return static_cast<int64_t>(-max);
+  }
+  const double v = std::nearbyint(static_cast<double>(x) * max);
+  return static_cast<int64_t>(std::clamp(v, -max, max - 1.0));
+}
+
+// Odd length, so that every SIMD loop leaves a scalar tail
+static std::vector<float> TestSignal() {
+  std::vector<float> in;
+  for (int i = 0; i < 1001; ++i) {
+    in.push_back(std::sin(static_cast<float>(i) * 0.01f) * 1.2f);
+  }
+  in[10] = 1.0f;
+  in[11] = -1.0f;
+  in[12] = 0.0f;
+  in[13] = 100.0f;
+  in[14] = -100.0f;
+  in[15] = std::numeric_limits<float>::quiet_NaN();
+  in[16] = 0.5f / 32768.0f;  // Rounds to even
+  return in;
+}
+
+TEST(FormatConversionTest, S16) {
+  const std::vector<float> in = TestSignal();
+  std::vector<int16_t> out(in.size());
+  jltx::audio::ConvertFromFloat(in, SampleFormat::S16, out.data());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    ASSERT_EQ(out[i], Reference(in[i], 16)) << "sample " << i;
+  }
+  EXPECT_EQ(out[10], 32767);
+  EXPECT_EQ(out[11], -32768);
+  EXPECT_EQ(out[16], 0);
+}
+
+TEST(FormatConversionTest, S24) {
+  const std::vector<float> in = TestSignal();
+  std::vector<int32_t> out(in.size());
+  jltx::audio::ConvertFromFloat(in, SampleFormat::S24, out.data());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    ASSERT_EQ(out[i], Reference(in[i], 24)) << "sample " << i;
+  }
+  EXPECT_EQ(out[10], 8388607);
+  EXPECT_EQ(out[11], -8388608);
+}
+
+TEST(FormatConversionTest, S32) {
+  const std::vector<float> in = TestSignal();
+  std::vector<int32_t> out(in.size());
+  jltx::audio::ConvertFromFloat(in, SampleFormat::S32, out.data());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    // Above 2^24 a float cannot hold every integer, so allow the clipping
+    // point to be the largest float below 2^31
+    ASSERT_NEAR(static_cast<double>(out[i]),
+                static_cast<double>(Reference(in[i], 32)), 128.0)
+        << "sample " << i;
+  }
+  EXPECT_GT(out[10], 2147483000);
+  EXPECT_EQ(out[11], std::numeric_limits<int32_t>::min());
+  EXPECT_EQ(out[13], out[10]);
+}
+
+TEST(FormatConversionTest, Float) {
+  const std::vector<float> in = TestSignal();
+  std::vector<float> out(in.size());
+  jltx::audio::ConvertFromFloat(in, SampleFormat::FLOAT, out.data());
+  EXPECT_EQ(std::memcmp(in.data(), out.data(), in.size() * sizeof(float)), 0);
+}
+
+TEST(FormatConversionTest, Interleave) {
+  // Enough frames to cross several interleaving blocks
+  constexpr std::size_t FRAMES = 1500;
+  for (std::size_t channels : {1, 2, 3, 8}) {
+    std::vector<std::vector<float>> planes(channels);
+    std::vector<const float*> pointers;
+    for (std::size_t c = 0; c < channels; ++c) {
+      for (std::size_t f = 0; f < FRAMES; ++f) {
+        planes[c].push_back(static_cast<float>(c) * 0.1f -
+                            static_cast<float>(f) / FRAMES);
+      }
+      pointers.push_back(planes[c].data());
+    }
+
+    std::vector<int16_t> out(FRAMES * channels);
+    jltx::audio::InterleaveFromFloat(pointers, FRAMES, SampleFormat::S16,
+                                     out.data());
+    std::vector<float> out_float(FRAMES * channels);
+    jltx::audio::InterleaveFromFloat(pointers, FRAMES, SampleFormat::FLOAT,
+                                     out_float.data());
+    for (std::size_t f = 0; f < FRAMES; ++f) {
+      for (std::size_t c = 0; c < channels; ++c) {
+        ASSERT_EQ(out[f * channels + c], Reference(planes[c][f], 16))
+            << "channels " << channels << " frame " << f;
+        ASSERT_EQ(out_float[f * channels + c], planes[c][f]);
+      }
+    }
+  }
+}
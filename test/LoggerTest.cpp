@@ -0,0 +1,306 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug.hpp"
+#include "util/AsyncLog.hpp"
+#include "util/BinaryLog.hpp"
+
+class AsyncLoggerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    m_path = testing::TempDir() + "jltx_async_logger_test.log";
+    m_fd = open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(m_fd, 0);
+  }
+
+  void TearDown() override {
+    close(m_fd);
+    std::remove(m_path.c_str());
+  }
+
+  std::vector<std::string> ReadLines() const {
+    std::ifstream file(m_path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  std::string m_path;
+  int m_fd = -1;
+};
+
+TEST_F(AsyncLoggerTest, LinesFromAllThreads) {
+  constexpr int THREADS = 4;
+  constexpr int LINES = 2000;
+  {
+    jltx::debug::AsyncLogOptions options;
+    options.policy = jltx::debug::OverflowPolicy::BLOCK;
+    options.block_timeout = std::chrono::seconds(10);
+    jltx::debug::AsyncLogBackend backend(m_fd, options);
+    const jltx::debug::BasicLogger log(backend);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < LINES; ++i) {
+          log.i("TEST", "thread %d line %d", t, i);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    backend.Flush();
+    EXPECT_EQ(ReadLines().size(), THREADS * LINES);
+    EXPECT_EQ(backend.Dropped(), 0);
+  }
+
+  // Lines are complete and in order within every thread
+  std::vector<int> next(THREADS, 0);
+  for (const std::string& line : ReadLines()) {
+    int t;
+    int i;
+    ASSERT_EQ(std::sscanf(line.c_str(), "[INFO] TEST: thread %d line %d", &t,
+                          &i),
+              2)
+        << line;
+    ASSERT_EQ(i, next[t]++);
+  }
+}
+
+TEST_F(AsyncLoggerTest, DestructorFlushes) {
+  {
+    jltx::debug::AsyncLogOptions options;
+    options.flush_interval = std::chrono::hours(1);
+    jltx::debug::AsyncLogBackend backend(m_fd, options);
+    jltx::debug::BasicLogger(backend).e("TAG", "no arguments");
+    jltx::debug::BasicLogger(backend).w("TAG", "%s=%.1f", "x", 0.5);
+  }
+  EXPECT_EQ(ReadLines(), (std::vector<std::string>{"[ERROR] TAG: no arguments",
+                                                   "[WARNING] TAG: x=0.5"}));
+}
+
+TEST_F(AsyncLoggerTest, AlternatingBackends) {
+  constexpr int LINES = 100;
+  const std::string other_path = m_path + ".other";
+  const int other_fd =
+      open(other_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(other_fd, 0);
+  {
+    jltx::debug::AsyncLogBackend backend(m_fd);
+    jltx::debug::AsyncLogBackend other(other_fd);
+    for (int i = 0; i < LINES; ++i) {
+      jltx::debug::BasicLogger(backend).i("ONE", "%d", i);
+      jltx::debug::BasicLogger(other).i("TWO", "%d", i);
+    }
+  }
+  close(other_fd);
+
+  std::ifstream other_file(other_path);
+  std::vector<std::string> other_lines;
+  for (std::string line; std::getline(other_file, line);) {
+    other_lines.push_back(line);
+  }
+  std::remove(other_path.c_str());
+
+  const std::vector<std::string> lines = ReadLines();
+  ASSERT_EQ(lines.size(), LINES);
+  ASSERT_EQ(other_lines.size(), LINES);
+  for (int i = 0; i < LINES; ++i) {
+    EXPECT_EQ(lines[i], "[INFO] ONE: " + std::to_string(i));
+    EXPECT_EQ(other_lines[i], "[INFO] TWO: " + std::to_string(i));
+  }
+}
+
+TEST_F(AsyncLoggerTest, DropWhenFull) {
+  constexpr int LINES = 1000;
+  jltx::debug::AsyncLogOptions options;
+  options.ring_size = 1024;
+  jltx::debug::AsyncLogBackend backend(m_fd, options);
+  const std::string long_line(600, 'x');
+
+  EXPECT_FALSE(backend.Write(std::string(2048, 'x').c_str(), 2048));
+  int accepted = 0;
+  for (int i = 0; i < LINES; ++i) {
+    accepted += backend.Log("TAG", "INFO", long_line.c_str()) ? 1 : 0;
+  }
+  backend.Flush();
+  EXPECT_EQ(static_cast<int>(ReadLines().size()), accepted);
+  EXPECT_EQ(backend.Dropped(), LINES - accepted + 1);
+}
+
+TEST_F(AsyncLoggerTest, FreesRingsOfExitedThreads) {
+  constexpr int THREADS = 4;
+  constexpr int LINES = 100;
+  jltx::debug::AsyncLogOptions options;
+  options.ring_size = 1024;
+  options.flush_interval = std::chrono::hours(1);
+  jltx::debug::AsyncLogBackend backend(m_fd, options);
+  const jltx::debug::BasicLogger log(backend);
+  const std::string long_line(600, 'x');
+
+  log.i("MAIN", "still running");
+  for (int t = 0; t < THREADS; ++t) {
+    // Every thread overflows its ring, so some lines are dropped
+    std::thread([&] {
+      for (int i = 0; i < LINES; ++i) {
+        log.i("TAG", long_line.c_str());
+      }
+    }).join();
+  }
+
+  backend.Flush();
+  EXPECT_EQ(backend.RingCount(), 1);
+  const auto lines = static_cast<uint64_t>(ReadLines().size());
+  EXPECT_EQ(lines + backend.Dropped(), THREADS * LINES + 1);
+  EXPECT_GT(backend.Dropped(), 0);
+
+  log.i("MAIN", "ring kept");
+  backend.Flush();
+  EXPECT_EQ(backend.RingCount(), 1);
+  EXPECT_EQ(ReadLines().back(), "[INFO] MAIN: ring kept");
+}
+
+TEST(BinaryLoggerTest, DecodesToLoggerText) {
+  const std::string path = testing::TempDir() + "jltx_binary_logger_test.blog";
+  {
+    jltx::debug::BinaryLogWriter writer(path);
+    ASSERT_TRUE(writer.IsOpen());
+    const jltx::debug::BasicLogger log(writer);
+    std::string dynamic = "dynamic string";
+
+    for (int i = 0; i < 3; ++i) {
+      log.i("LOOP", "i=%d of %u", i, 3u);
+    }
+    log.e("TAG", dynamic.c_str());
+    dynamic = "changed";
+    log.e("TAG", dynamic.c_str());
+    log.w("TAG", "%5.2f|%-4s|%lld|%zu|%x|%c|%%|%*d", 3.14159, "ab",
+          static_cast<long long>(-1) << 40, std::size_t{7}, 255u, 'z', 3, 1);
+    log.i("HEX", "%x|%u|%llx", -1, -2, -1ll);
+    EXPECT_EQ(writer.Dropped(), 0);
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  const std::string data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+
+  char* text = nullptr;
+  std::size_t size = 0;
+  FILE* out = open_memstream(&text, &size);
+  EXPECT_TRUE(jltx::debug::DecodeBinaryLog(data, out, false));
+  fclose(out);
+  const std::string decoded(text, size);
+  free(text);
+
+  EXPECT_EQ(decoded,
+            "[INFO] LOOP: i=0 of 3\n"
+            "[INFO] LOOP: i=1 of 3\n"
+            "[INFO] LOOP: i=2 of 3\n"
+            "[ERROR] TAG: dynamic string\n"
+            "[ERROR] TAG: changed\n"
+            "[WARNING] TAG:  3.14|ab  |-1099511627776|7|ff|z|%|  1\n"
+            "[INFO] HEX: ffffffff|4294967294|ffffffffffffffff\n");
+  EXPECT_FALSE(jltx::debug::DecodeBinaryLog("not a log", stdout, false));
+}
+
+TEST(BinaryLoggerTest, DropsWhenFull) {
+  const std::string path = testing::TempDir() + "jltx_binary_logger_full.blog";
+  {
+    jltx::debug::BinaryLogWriter writer(path, 4096);
+    const jltx::debug::BasicLogger log(writer);
+    for (int i = 0; i < 1000; ++i) {
+      log.i("TAG", "%d", i);
+    }
+    EXPECT_GT(writer.Dropped(), 0);
+  }
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  EXPECT_LE(file.tellg(), 4096);
+  std::remove(path.c_str());
+}
+
+// Records whose contents claim more bytes than the record holds
+TEST(BinaryLoggerTest, RejectsCorruptRecords) {
+  namespace binlog = jltx::debug::binlog;
+  using namespace std::string_literals;
+
+  auto record = [](uint32_t id, const std::string& body) {
+    const binlog::RecordHeader header{
+        static_cast<uint32_t>(sizeof(binlog::RecordHeader) + body.size()),
+        id + 1};
+    return std::string(reinterpret_cast<const char*>(&header),
+                       sizeof(header)) +
+           body;
+  };
+  auto decode = [](const std::string& records) {
+    binlog::FileHeader header{};
+    std::memcpy(header.magic, binlog::MAGIC, sizeof(header.magic));
+    header.version = binlog::VERSION;
+    const std::string data =
+        std::string(reinterpret_cast<const char*>(&header), sizeof(header)) +
+        records;
+    FILE* out = std::fopen("/dev/null", "w");
+    const bool decoded = jltx::debug::DecodeBinaryLog(data, out, false);
+    std::fclose(out);
+    return decoded;
+  };
+
+  constexpr uint32_t FORMAT = binlog::FORMAT_FLAG;
+  const std::string int_format = record(FORMAT, "\x01\x00INFO\0TAG\0%d\0"s);
+  const std::string string_format =
+      record(FORMAT, "\x01\x05INFO\0TAG\0%s\0"s);
+  const std::string timestamp(sizeof(int64_t), '\0');
+
+  EXPECT_TRUE(decode(int_format + record(0, timestamp + "\x01\0\0\0"s)));
+  EXPECT_TRUE(decode(string_format + record(0, timestamp + "\x02\0ab"s)));
+
+  // Format records
+  EXPECT_FALSE(decode(record(FORMAT, "")));
+  EXPECT_FALSE(decode(record(FORMAT, "\x05\x00"s)));
+  EXPECT_FALSE(decode(record(FORMAT, "\x01\x2aINFO\0TAG\0%d\0"s)));
+  EXPECT_FALSE(decode(record(FORMAT, "\x01\x00INFO\0TAG\0%d"s)));
+
+  // Messages
+  EXPECT_FALSE(decode(int_format + record(0, "\0\0\0"s)));
+  EXPECT_FALSE(decode(int_format + record(0, timestamp + "\x01\0"s)));
+  EXPECT_FALSE(decode(string_format + record(0, timestamp + "\x01"s)));
+  EXPECT_FALSE(decode(string_format + record(0, timestamp + "\xff\xff" "ab"s)));
+}
@@ -25,7 +25,9 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <math/cholesky.hpp>
 #include <math/math.hpp>
 #include <numeric>
 #include <vector>
@@ -71,3 +73,25 @@ TEST(MathTest, cos11) {
   ASSERT_LE(max, 5e-4);   // Max error is bound to 5e-4
   ASSERT_LE(mean, 5e-5);  // Mean error is bound to 5e-5
 }
+
+TEST(MathTest, Cholesky) {
+  // A = L * L^T with L = {{2, 0, 0}, {1, 3, 0}, {-1, 2, 1}}
+  std::array<double, 9> a = {4, 2, -2, 2, 10, 5, -2, 5, 6};
+  ASSERT_TRUE((jltx::math::CholeskyDecompose<double, 3>(a)));
+  EXPECT_DOUBLE_EQ(a[0], 2);
+  EXPECT_DOUBLE_EQ(a[3], 1);
+  EXPECT_DOUBLE_EQ(a[4], 3);
+  EXPECT_DOUBLE_EQ(a[6], -1);
+  EXPECT_DOUBLE_EQ(a[7], 2);
+  EXPECT_DOUBLE_EQ(a[8], 1);
+
+  // A * {1, -2, 3} = {-6, -3, 6}
+  std::array<double, 3> b = {-6, -3, 6};
+  jltx::math::CholeskySolve<double, 3>(a, b);
+  EXPECT_NEAR(b[0], 1, 1e-12);
+  EXPECT_NEAR(b[1], -2, 1e-12);
+  EXPECT_NEAR(b[2], 3, 1e-12);
+
+  std::array<double, 4> not_positive = {1, 2, 2, 1};
+  EXPECT_FALSE((jltx::math::CholeskyDecompose<double, 2>(not_positive)));
+}
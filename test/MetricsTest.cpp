@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/Metrics.hpp"
+
+using jltx::metrics::HistogramSnapshot;
+
+TEST(MetricsTest, CounterFromManyThreads) {
+  jltx::metrics::MetricsRegistry registry;
+  jltx::metrics::Counter& counter = registry.GetCounter("events");
+  EXPECT_EQ(&counter, &registry.GetCounter("events"));
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 10000; ++i) {
+        counter.Add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  counter.Add(5);
+  EXPECT_EQ(counter.Value(), 40005);
+  EXPECT_EQ(registry.Snapshot().counters.at("events"), 40005);
+}
+
+TEST(MetricsTest, HistogramBuckets) {
+  // Buckets are contiguous and every value lies in its bucket
+  for (std::size_t bucket = 1; bucket < HistogramSnapshot::NUM_BUCKETS;
+       ++bucket) {
+    const uint64_t lowest = HistogramSnapshot::LowestOf(bucket);
+    ASSERT_EQ(HistogramSnapshot::BucketOf(lowest), bucket);
+    ASSERT_EQ(HistogramSnapshot::BucketOf(lowest - 1), bucket - 1);
+  }
+  EXPECT_EQ(HistogramSnapshot::BucketOf(UINT64_MAX),
+            HistogramSnapshot::NUM_BUCKETS - 1);
+
+  // Relative bucket width is at most 1/16
+  for (uint64_t value = 1; value < (uint64_t{1} << 40); value = value * 3 + 1) {
+    const std::size_t bucket = HistogramSnapshot::BucketOf(value);
+    const uint64_t width = HistogramSnapshot::LowestOf(bucket + 1) -
+                           HistogramSnapshot::LowestOf(bucket);
+    EXPECT_LE(width * 16, std::max<uint64_t>(value, 16));
+  }
+}
+
+TEST(MetricsTest, HistogramPercentiles) {
+  jltx::metrics::Histogram histogram;
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.Record(value);
+  }
+  const HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_EQ(snapshot.count, 1000);
+  EXPECT_EQ(snapshot.min, 1);
+  EXPECT_EQ(snapshot.max, 1000);
+  EXPECT_DOUBLE_EQ(snapshot.Mean(), 500.5);
+  EXPECT_NEAR(static_cast<double>(snapshot.Percentile(50)), 500, 500 / 16);
+  EXPECT_NEAR(static_cast<double>(snapshot.Percentile(99)), 990, 990 / 16);
+  EXPECT_EQ(snapshot.Percentile(100), 1000);
+  EXPECT_EQ(snapshot.Percentile(0), 1);
+  EXPECT_EQ(HistogramSnapshot().Percentile(50), 0);
+
+  HistogramSnapshot merged = snapshot;
+  merged.Merge(snapshot);
+  EXPECT_EQ(merged.count, 2000);
+  EXPECT_EQ(merged.Percentile(50), snapshot.Percentile(50));
+}
+
+TEST(MetricsTest, Dump) {
+  jltx::metrics::MetricsRegistry registry;
+  registry.GetCounter("frames").Add(3);
+  registry.GetGauge("depth").Set(-2);
+  registry.GetHistogram("latency").Record(7);
+  registry.GetHistogram("empty");
+
+  const jltx::metrics::MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_EQ(snapshot.ToText(),
+            "frames 3\n"
+            "depth -2\n"
+            "empty count=0 mean=0.0\n"
+            "latency count=1 mean=7.0 min=7 p50=7 p90=7 p99=7 p999=7 max=7\n");
+  EXPECT_EQ(snapshot.ToJson(),
+            "{\"counters\":{\"frames\":3},\"gauges\":{\"depth\":-2},"
+            "\"histograms\":{\"empty\":{\"count\":0,\"sum\":0},"
+            "\"latency\":{\"count\":1,\"sum\":7,\"min\":7,\"max\":7,"
+            "\"p50\":7,\"p90\":7,\"p99\":7,\"p999\":7}}}");
+
+  jltx::metrics::MetricsSnapshot total = snapshot;
+  total.Merge(snapshot);
+  EXPECT_EQ(total.counters.at("frames"), 6);
+  EXPECT_EQ(total.gauges.at("depth"), -2);
+  EXPECT_EQ(total.histograms.at("latency").count, 2);
+}
+
+TEST(MetricsTest, PeriodicSnapshot) {
+  jltx::metrics::MetricsRegistry registry;
+  registry.GetCounter("ticks").Add(1);
+  std::atomic<int> snapshots{0};
+  {
+    jltx::metrics::PeriodicSnapshot periodic(
+        registry, std::chrono::milliseconds(1),
+        [&](const jltx::metrics::MetricsSnapshot& snapshot) {
+          EXPECT_EQ(snapshot.counters.at("ticks"), 1);
+          ++snapshots;
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_GE(snapshots.load(), 2);
+}
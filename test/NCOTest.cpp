@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+
+using jltx::dsp::NCO;
+using jltx::dsp::SineLUT;
+
+TEST(NCOTest, SeekMatchesRunningPhase) {
+  const SineLUT<10> table;
+  NCO<10> running(997.0f, 48000.0f, table);
+  std::vector<float> expected(200000);
+  for (auto& sample : expected) {
+    sample = running();
+  }
+
+  NCO<10> seeking(997.0f, 48000.0f, table);
+  for (const uint64_t start : {0, 1, 4096, 65537, 199999}) {
+    seeking.Seek(start);
+    for (uint64_t n = start; n < std::min<uint64_t>(start + 100, 200000);
+         ++n) {
+      ASSERT_EQ(seeking(), expected[n]) << "sample " << n;
+    }
+  }
+}
+
+TEST(NCOTest, SeekWrapsLikeTheAccumulator) {
+  // Far enough for the phase to wrap many times
+  const SineLUT<10> table;
+  NCO<10> running(18000.0f, 44100.0f, table);
+  NCO<10> seeking(18000.0f, 44100.0f, table);
+  constexpr uint64_t START = 3'000'000;
+  for (uint64_t n = 0; n < START; ++n) {
+    (void)running();
+  }
+  seeking.Seek(START);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(seeking(), running());
+  }
+}
+
+TEST(NCOTest, SetFrequencyChangesTheStep) {
+  const SineLUT<10> table;
+  NCO<10> changed(1000.0f, 48000.0f, table);
+  changed.SetFrequency(3000.0f);
+  EXPECT_EQ(changed.Frequency(), 3000.0f);
+  NCO<10> direct(3000.0f, 48000.0f, table);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(changed(), direct());
+  }
+
+  NCO<10> resampled(3000.0f, 48000.0f, table);
+  resampled.SetSampleRate(96000.0f);
+  EXPECT_EQ(resampled.SampleRate(), 96000.0f);
+  NCO<10> direct_96k(3000.0f, 96000.0f, table);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(resampled(), direct_96k());
+  }
+}
+
+TEST(NCOTest, PhaseDeltaWrapsOutOfRangeFrequencies) {
+  constexpr float RATE = 48000.0f;
+  EXPECT_EQ(NCO<10>::PhaseDelta(12000.0f, RATE), 1u << 30);
+  EXPECT_EQ(NCO<10>::PhaseDelta(-12000.0f, RATE), 3u << 30);
+  EXPECT_EQ(NCO<10>::PhaseDelta(60000.0f, RATE), 1u << 30);
+  EXPECT_EQ(NCO<10>::PhaseDelta(RATE, RATE), 0u);
+  EXPECT_EQ(NCO<10>::PhaseDelta(1e30f, RATE), NCO<10>::PhaseDelta(0.0f, RATE));
+  EXPECT_EQ(NCO<10>::PhaseDelta(1000.0f, 0.0f), 0u);
+  EXPECT_EQ(NCO<10>::PhaseDelta(std::nanf(""), RATE), 0u);
+}
+
+TEST(NCOTest, RenderMatchesOperator) {
+  const SineLUT<12> table;
+  NCO<12> sample_by_sample(1234.5f, 44100.0f, table);
+  NCO<12> block(1234.5f, 44100.0f, table);
+  // Odd sizes exercise the scalar tail after the 8-wide loop
+  for (const std::size_t size : {1, 7, 8, 64, 1001}) {
+    std::vector<float> out(size);
+    block.Render(out, 0.5f);
+    for (std::size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(out[i], 0.5f * sample_by_sample()) << size << " " << i;
+    }
+  }
+}
@@ -0,0 +1,349 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "optimization/autodiff.hpp"
+#include "optimization/gradient.hpp"
+#include "optimization/lbfgs.hpp"
+#include "optimization/levenberg_marquardt.hpp"
+#include "optimization/sgd.hpp"
+
+namespace {
+
+// y = 1 - 2x + 0.5x^2 - 0.25x^3
+constexpr uint32_t NPARAMS = 4;
+constexpr std::array<double, NPARAMS> COEFFS = {1.0, -2.0, 0.5, -0.25};
+
+double Polynomial(double x) {
+  return COEFFS[0] + COEFFS[1] * x + COEFFS[2] * x * x +
+         COEFFS[3] * x * x * x;
+}
+
+void MakeSamples(std::size_t count, std::vector<double>& x,
+                 std::vector<double>& y) {
+  x.resize(count);
+  y.resize(count);
+  for (std::size_t n = 0; n < count; ++n) {
+    x[n] = -1.0 + 2.0 * static_cast<double>(n) / static_cast<double>(count);
+    y[n] = Polynomial(x[n]);
+  }
+}
+
+// Same cubic as PolynomicFitProblem, with gradients from automatic
+// differentiation
+struct AutoDiffPolynomial
+    : public jltx::opt::AutoDiffProblem<double, NPARAMS, AutoDiffPolynomial> {
+  template <typename S>
+  S Evaluate(double x, const std::array<S, NPARAMS>& w) const {
+    return w[0] + x * (w[1] + x * (w[2] + x * w[3]));
+  }
+};
+
+}  // namespace
+
+TEST(OptimizationTest, PolynomicFitEstimate) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(101, x, y);
+
+  const std::vector<double> estimates = problem.Estimate(x, COEFFS);
+  ASSERT_EQ(estimates.size(), x.size());
+  for (std::size_t n = 0; n < x.size(); ++n) {
+    EXPECT_NEAR(estimates[n], y[n], 1e-12);
+  }
+}
+
+TEST(OptimizationTest, PolynomicFitError) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(101, x, y);
+
+  EXPECT_NEAR(problem.Error(x, COEFFS, y), 0.0, 1e-20);
+
+  // Shifting the constant term by d gives a mean squared error of d^2
+  std::array<double, NPARAMS> w = COEFFS;
+  w[0] += 0.5;
+  EXPECT_NEAR(problem.Error(x, w, y), 0.25, 1e-12);
+}
+
+TEST(OptimizationTest, PolynomicFitGradient) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  // Not a multiple of the number of lanes to cover the remainder loop
+  MakeSamples(1003, x, y);
+
+  const std::array<double, NPARAMS> zero = problem.Gradient(x, COEFFS, y);
+  for (double g : zero) {
+    EXPECT_NEAR(g, 0.0, 1e-12);
+  }
+
+  // Compare against central finite differences of the error
+  const std::array<double, NPARAMS> w = {0.3, 1.2, -0.7, 2.0};
+  const std::array<double, NPARAMS> gradient = problem.Gradient(x, w, y);
+  static constexpr double h = 1e-6;
+  for (uint32_t i = 0; i < NPARAMS; ++i) {
+    std::array<double, NPARAMS> w_plus = w;
+    std::array<double, NPARAMS> w_minus = w;
+    w_plus[i] += h;
+    w_minus[i] -= h;
+    const double numeric =
+        (problem.Error(x, w_plus, y) - problem.Error(x, w_minus, y)) / (2 * h);
+    EXPECT_NEAR(gradient[i], numeric, 1e-6);
+  }
+}
+
+// The single pass gives what the separate Error() and Gradient() passes give
+TEST(OptimizationTest, ErrorAndGradient) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> polynomial;
+  AutoDiffPolynomial autodiff;
+  std::vector<double> x, y;
+  MakeSamples(1003, x, y);
+  const std::array<double, NPARAMS> w = {0.3, 1.2, -0.7, 2.0};
+
+  using Problem = jltx::opt::OptimizationProblem<double, NPARAMS>;
+  for (Problem* problem : {static_cast<Problem*>(&polynomial),
+                           static_cast<Problem*>(&autodiff)}) {
+    std::array<double, NPARAMS> gradient;
+    const double error = problem->ErrorAndGradient(x, w, y, gradient);
+    EXPECT_NEAR(error, problem->Error(x, w, y), 1e-12);
+    const std::array<double, NPARAMS> expected = problem->Gradient(x, w, y);
+    for (uint32_t i = 0; i < NPARAMS; ++i) {
+      EXPECT_NEAR(gradient[i], expected[i], 1e-12);
+    }
+  }
+}
+
+TEST(OptimizationTest, GradientSolverThreadPool) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(10007, x, y);
+
+  const std::array<double, NPARAMS> init = {0.0, 0.0, 0.0, 0.0};
+  static constexpr uint32_t iterations = 50;
+  static constexpr std::size_t shard_size = 1000;
+
+  jltx::opt::GradientSolver<double, NPARAMS> serial_solver(&problem, 0.1);
+  const auto serial = serial_solver.Solve(iterations, x, y, init);
+
+  jltx::ThreadPool single_pool(1);
+  jltx::opt::GradientSolver<double, NPARAMS> single_solver(
+      &problem, 0.1, &single_pool, shard_size);
+  const auto single = single_solver.Solve(iterations, x, y, init);
+
+  jltx::ThreadPool multi_pool(4);
+  jltx::opt::GradientSolver<double, NPARAMS> multi_solver(
+      &problem, 0.1, &multi_pool, shard_size);
+  const auto multi = multi_solver.Solve(iterations, x, y, init);
+
+  for (uint32_t i = 0; i < NPARAMS; ++i) {
+    // The reduction tree is fixed, so the thread count cannot change the bits
+    EXPECT_EQ(single[i], multi[i]);
+    EXPECT_NEAR(single[i], serial[i], 1e-9);
+  }
+}
+
+TEST(OptimizationTest, RandomInitParams) {
+  const auto a = jltx::opt::RandomInitParams<double, NPARAMS>(42, 0.5);
+  const auto b = jltx::opt::RandomInitParams<double, NPARAMS>(42, 0.5);
+  const auto c = jltx::opt::RandomInitParams<double, NPARAMS>(43, 0.5);
+
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  for (double w : a) {
+    EXPECT_LE(std::abs(w), 0.5);
+  }
+}
+
+TEST(OptimizationTest, StochasticGradientSolver) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(4096, x, y);
+
+  // Mini-batches of consecutive samples should not sweep x in order
+  std::vector<std::size_t> order(x.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937(7));
+  std::vector<double> x_shuffled, y_shuffled;
+  for (std::size_t n : order) {
+    x_shuffled.push_back(x[n]);
+    y_shuffled.push_back(y[n]);
+  }
+
+  struct Case {
+    jltx::opt::SgdMethod method;
+    double rate;
+  };
+  const Case cases[] = {{jltx::opt::SgdMethod::SGD, 0.5},
+                        {jltx::opt::SgdMethod::MOMENTUM, 0.05},
+                        {jltx::opt::SgdMethod::NESTEROV, 0.05},
+                        {jltx::opt::SgdMethod::ADAM, 0.02}};
+
+  for (const Case& c : cases) {
+    jltx::opt::SgdOptions<double> options;
+    options.method = c.method;
+    options.batch_size = 64;
+    options.learning_rate = jltx::opt::ConstantRate(c.rate);
+
+    jltx::opt::StochasticGradientSolver<double, NPARAMS> solver(&problem,
+                                                                options);
+    auto source = jltx::opt::IteratorBatchSource<double>(
+        x_shuffled.begin(), x_shuffled.end(), y_shuffled.begin());
+    const auto init = jltx::opt::RandomInitParams<double, NPARAMS>(1);
+    const auto w = solver.Solve(source, 30, init);
+
+    EXPECT_EQ(solver.Steps(), 30 * 4096 / 64);
+    EXPECT_LT(problem.Error(x, w, y), 1e-3)
+        << "method " << static_cast<int>(c.method);
+  }
+}
+
+TEST(OptimizationTest, StepDecay) {
+  const auto decay = jltx::opt::StepDecay(1.0, 0.5, 10);
+  EXPECT_DOUBLE_EQ(decay(9), 1.0);
+  EXPECT_DOUBLE_EQ(decay(10), 0.5);
+  EXPECT_DOUBLE_EQ(decay(25), 0.25);
+
+  // A zero period decays every step instead of dividing by zero
+  const auto every_step = jltx::opt::StepDecay(1.0, 0.5, 0);
+  EXPECT_DOUBLE_EQ(every_step(0), 1.0);
+  EXPECT_DOUBLE_EQ(every_step(2), 0.25);
+}
+
+TEST(OptimizationTest, DualArithmetic) {
+  using D = jltx::opt::Dual<double, 2>;
+  const D a = D::Variable(3.0, 0);
+  const D b = D::Variable(2.0, 1);
+
+  // f(a, b) = a * b / (a - b) + 2a
+  const D f = a * b / (a - b) + 2.0 * a;
+  EXPECT_DOUBLE_EQ(f.value, 12.0);
+  // df/da = (b(a - b) - ab) / (a - b)^2 + 2 = -b^2 / (a - b)^2 + 2
+  EXPECT_DOUBLE_EQ(f.grad[0], -2.0);
+  // df/db = (a(a - b) + ab) / (a - b)^2 = a^2 / (a - b)^2
+  EXPECT_DOUBLE_EQ(f.grad[1], 9.0);
+
+  // g(a, b) = sin(a) * exp(b)
+  const D g = sin(a) * exp(b);
+  EXPECT_DOUBLE_EQ(g.value, std::sin(3.0) * std::exp(2.0));
+  EXPECT_DOUBLE_EQ(g.grad[0], std::cos(3.0) * std::exp(2.0));
+  EXPECT_DOUBLE_EQ(g.grad[1], std::sin(3.0) * std::exp(2.0));
+}
+
+TEST(OptimizationTest, AutoDiffGradient) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> hand_coded;
+  AutoDiffPolynomial auto_diff;
+  std::vector<double> x, y;
+  MakeSamples(1003, x, y);
+
+  const std::array<double, NPARAMS> w = {0.3, 1.2, -0.7, 2.0};
+  EXPECT_NEAR(auto_diff.Error(x, w, y), hand_coded.Error(x, w, y), 1e-12);
+
+  const auto expected = hand_coded.Gradient(x, w, y);
+  const auto gradient = auto_diff.Gradient(x, w, y);
+  for (uint32_t i = 0; i < NPARAMS; ++i) {
+    EXPECT_NEAR(gradient[i], expected[i], 1e-12);
+  }
+}
+
+TEST(OptimizationTest, LbfgsSolver) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(1003, x, y);
+  const auto init = jltx::opt::RandomInitParams<double, NPARAMS>(1);
+
+  for (auto method : {jltx::opt::LineSearchMethod::WOLFE,
+                      jltx::opt::LineSearchMethod::ARMIJO}) {
+    jltx::opt::ConvergenceCriteria<double> criteria;
+    criteria.gradient_tolerance = 1e-10;
+    jltx::opt::LineSearchOptions<double> line_search;
+    line_search.method = method;
+
+    jltx::opt::LbfgsSolver<double, NPARAMS> solver(&problem, criteria,
+                                                   line_search);
+    uint32_t reports = 0;
+    solver.SetCallback([&](const jltx::opt::IterationReport<double>& report) {
+      EXPECT_EQ(report.iteration, ++reports);
+      EXPECT_GE(report.loss, 0.0);
+      return true;
+    });
+
+    const auto result = solver.Solve(x, y, init);
+    EXPECT_EQ(result.status, jltx::opt::SolveStatus::GRADIENT_TOLERANCE);
+    EXPECT_EQ(result.iterations, reports);
+    // Fixed-step gradient descent needs thousands of passes for this fit
+    EXPECT_LT(result.evaluations, 100);
+    for (uint32_t i = 0; i < NPARAMS; ++i) {
+      EXPECT_NEAR(result.w[i], COEFFS[i], 1e-6);
+    }
+  }
+}
+
+TEST(OptimizationTest, LbfgsSolverCallbackStop) {
+  jltx::opt::PolynomicFitProblem<double, NPARAMS> problem;
+  std::vector<double> x, y;
+  MakeSamples(101, x, y);
+
+  jltx::opt::LbfgsSolver<double, NPARAMS> solver(&problem);
+  solver.SetCallback([](const jltx::opt::IterationReport<double>& report) {
+    return report.iteration < 2;
+  });
+
+  const auto result =
+      solver.Solve(x, y, jltx::opt::RandomInitParams<double, NPARAMS>(1));
+  EXPECT_EQ(result.status, jltx::opt::SolveStatus::STOPPED_BY_CALLBACK);
+  EXPECT_EQ(result.iterations, 2);
+}
+
+TEST(OptimizationTest, LevenbergMarquardtSinusoid) {
+  static constexpr double sample_rate = 8000;
+  static constexpr std::array<double, 3> expected = {0.8, 440.0, 0.3};
+
+  jltx::opt::SinusoidFitProblem<double> problem;
+  std::mt19937 generator(3);
+  std::normal_distribution<double> noise(0.0, 0.05);
+  std::vector<double> x, y;
+  for (std::size_t n = 0; n < 4000; ++n) {
+    x.push_back(static_cast<double>(n) / sample_rate);
+    y.push_back(problem.Evaluate(x.back(), expected) + noise(generator));
+  }
+
+  jltx::opt::LevenbergMarquardtSolver<double, 3> solver(&problem);
+  const auto result = solver.Solve(x, y, {1.0, 439.5, 0.0});
+
+  EXPECT_NE(result.status, jltx::opt::SolveStatus::MAX_ITERATIONS);
+  EXPECT_LT(result.iterations, 30);
+  EXPECT_NEAR(result.w[0], expected[0], 5e-3);
+  EXPECT_NEAR(result.w[1], expected[1], 5e-2);
+  EXPECT_NEAR(result.w[2], expected[2], 1e-2);
+  // The residual is the noise
+  EXPECT_NEAR(result.loss, 0.05 * 0.05, 5e-4);
+}
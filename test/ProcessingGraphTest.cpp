@@ -0,0 +1,163 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "audio/NullAudioSink.hpp"
+#include "dsp/Nodes.hpp"
+#include "dsp/ProcessingGraph.hpp"
+#include "util/ThreadPool.hpp"
+
+using jltx::dsp::Block;
+using jltx::dsp::GainNode;
+using jltx::dsp::MixerNode;
+using jltx::dsp::ProcessingGraph;
+
+/** Source whose sample i of block b is value + b * frames + i */
+class RampNode : public jltx::dsp::Node {
+ public:
+  explicit RampNode(float value) : m_next(value) {}
+
+  void Process(std::span<const Block> /*inputs*/,
+               const Block& output) override {
+    for (uint32_t i = 0; i < output.frames; ++i) {
+      output.Channel(0)[i] = m_next++;
+    }
+  }
+
+ private:
+  float m_next;
+};
+
+static constexpr uint32_t FRAMES = 64;
+
+TEST(ProcessingGraphTest, Chain) {
+  ProcessingGraph graph(FRAMES);
+  auto node = graph.Add(std::make_unique<RampNode>(0.0f));
+  for (int i = 0; i < 5; ++i) {
+    node = graph.Add(std::make_unique<GainNode>(2.0f), {node});
+  }
+  ASSERT_TRUE(graph.Compile(node));
+  // Every node only needs its input, so two buffers alternate
+  EXPECT_EQ(graph.BufferCount(), 2u);
+
+  graph.Process();
+  graph.Process();
+  const Block& out = graph.Output();
+  ASSERT_EQ(out.frames, FRAMES);
+  for (uint32_t i = 0; i < FRAMES; ++i) {
+    EXPECT_FLOAT_EQ(out.Channel(0)[i], 32.0f * static_cast<float>(FRAMES + i));
+  }
+}
+
+TEST(ProcessingGraphTest, InvalidNodes) {
+  ProcessingGraph graph(FRAMES);
+  EXPECT_EQ(graph.Add(std::make_unique<GainNode>(1.0f), {0}),
+            ProcessingGraph::INVALID_NODE);
+  EXPECT_EQ(graph.Add(nullptr), ProcessingGraph::INVALID_NODE);
+  EXPECT_FALSE(graph.Compile(0));
+  const auto source = graph.Add(std::make_unique<RampNode>(0.0f));
+  EXPECT_EQ(graph.Add(std::make_unique<GainNode>(1.0f), {source, 7}),
+            ProcessingGraph::INVALID_NODE);
+  EXPECT_EQ(graph.Size(), 1u);
+  EXPECT_TRUE(graph.Compile(source));
+}
+
+TEST(ProcessingGraphTest, SharedInputKeepsBuffer) {
+  // source feeds both branches, so the first branch must not overwrite it
+  ProcessingGraph graph(FRAMES);
+  const auto source = graph.Add(std::make_unique<RampNode>(1.0f));
+  const auto a = graph.Add(std::make_unique<GainNode>(2.0f), {source});
+  const auto a2 = graph.Add(std::make_unique<GainNode>(3.0f), {a});
+  const auto b = graph.Add(std::make_unique<GainNode>(5.0f), {source});
+  const auto mix = graph.Add(std::make_unique<MixerNode>(2), {a2, b});
+  ASSERT_TRUE(graph.Compile(mix));
+
+  graph.Process();
+  const Block& out = graph.Output();
+  ASSERT_EQ(out.channels, 2u);
+  for (uint32_t c = 0; c < 2; ++c) {
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+      EXPECT_FLOAT_EQ(out.Channel(c)[i], 11.0f * static_cast<float>(1 + i));
+    }
+  }
+}
+
+/** Many branches of gain chains mixed together */
+static ProcessingGraph::NodeId BuildWide(ProcessingGraph& graph,
+                                         int branches, int depth) {
+  std::vector<ProcessingGraph::NodeId> tails;
+  for (int b = 0; b < branches; ++b) {
+    auto node = graph.Add(std::make_unique<RampNode>(static_cast<float>(b)));
+    const auto shared = node;
+    for (int d = 0; d < depth; ++d) {
+      const float gain = 0.5f + 0.1f * static_cast<float>(d % 3);
+      node = graph.Add(std::make_unique<GainNode>(gain), {node});
+    }
+    // Reads the branch source again, long after its first reader
+    node = graph.Add(std::make_unique<MixerNode>(), {node, shared});
+    tails.push_back(node);
+  }
+  return graph.Add(std::make_unique<MixerNode>(2), tails);
+}
+
+TEST(ProcessingGraphTest, ParallelMatchesSequential) {
+  ProcessingGraph sequential(FRAMES);
+  ProcessingGraph parallel(FRAMES);
+  ASSERT_TRUE(sequential.Compile(BuildWide(sequential, 16, 6)));
+  ASSERT_TRUE(parallel.Compile(BuildWide(parallel, 16, 6)));
+  EXPECT_LT(parallel.BufferCount(), parallel.Size());
+
+  jltx::ThreadPool pool(4);
+  for (int block = 0; block < 50; ++block) {
+    sequential.Process();
+    parallel.Process(&pool);
+    const Block& expected = sequential.Output();
+    const Block& actual = parallel.Output();
+    for (uint32_t c = 0; c < 2; ++c) {
+      for (uint32_t i = 0; i < FRAMES; ++i) {
+        ASSERT_EQ(actual.Channel(c)[i], expected.Channel(c)[i]);
+      }
+    }
+  }
+}
+
+TEST(ProcessingGraphTest, RenderToSink) {
+  ProcessingGraph graph(FRAMES);
+  const auto source = graph.Add(std::make_unique<RampNode>(0.0f));
+  const auto stereo = graph.Add(std::make_unique<GainNode>(1.0f, 2), {source});
+  ASSERT_TRUE(graph.Compile(stereo));
+
+  jltx::audio::NullAudioSink mono(48000, 1);
+  EXPECT_EQ(graph.Render(mono, 100), 0u);
+
+  jltx::audio::NullAudioSink sink(48000, 2);
+  EXPECT_EQ(graph.Render(sink, 1000), 1000u);
+  EXPECT_EQ(sink.FramesWritten(), 1000u);
+}
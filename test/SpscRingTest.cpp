@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "containers/SpscRing.hpp"
+
+TEST(SpscRingTest, WriteAndRead) {
+  jltx::SpscRing<int> ring(5);
+  ASSERT_EQ(ring.Capacity(), 8);
+  EXPECT_EQ(ring.FillLevel(), 0);
+
+  std::array<int, 6> in = {1, 2, 3, 4, 5, 6};
+  std::array<int, 8> out{};
+  EXPECT_EQ(ring.Write(in), 6);
+  EXPECT_EQ(ring.Write(in), 2);  // Only 2 free
+  EXPECT_EQ(ring.FillLevel(), 8);
+
+  EXPECT_EQ(ring.Read(std::span(out).first(5)), 5);
+  EXPECT_EQ(out[0], 1);
+  EXPECT_EQ(out[4], 5);
+
+  // Wraps around the end of the storage
+  EXPECT_EQ(ring.Write(in), 5);
+  EXPECT_EQ(ring.Read(out), 8);
+  EXPECT_EQ(out, (std::array<int, 8>{6, 1, 2, 1, 2, 3, 4, 5}));
+  EXPECT_EQ(ring.Read(out), 0);
+}
+
+TEST(SpscRingTest, ProducerConsumer) {
+  constexpr int COUNT = 1 << 20;
+  jltx::SpscRing<int> ring(1000);
+
+  std::thread producer([&] {
+    std::array<int, 37> chunk;
+    int next = 0;
+    while (next < COUNT) {
+      const int size = std::min<int>(chunk.size(), COUNT - next);
+      for (int i = 0; i < size; ++i) {
+        chunk[i] = next + i;
+      }
+      std::size_t written = 0;
+      while (written < static_cast<std::size_t>(size)) {
+        written += ring.Write(std::span<const int>(chunk).subspan(
+            written, static_cast<std::size_t>(size) - written));
+      }
+      next += size;
+    }
+  });
+
+  std::array<int, 64> chunk;
+  int expected = 0;
+  while (expected < COUNT) {
+    const std::size_t read = ring.Read(chunk);
+    for (std::size_t i = 0; i < read; ++i) {
+      ASSERT_EQ(chunk[i], expected++);
+    }
+  }
+  producer.join();
+  EXPECT_EQ(ring.FillLevel(), 0);
+}
@@ -24,6 +24,14 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/ColumnParser.hpp"
 #include "util/TextUtils.hpp"
 
 TEST(TextUtilsTest, Equals) {
@@ -47,6 +55,61 @@ TEST(TextUtilsTest, Split) {
   EXPECT_EQ(substrings[2], "third");
 }
 
+TEST(TextUtilsTest, SplitEdgeCases) {
+  using Tokens = std::vector<std::string>;
+  EXPECT_EQ(jltx::TextUtils::Split("", ";"), Tokens{});
+  EXPECT_EQ(jltx::TextUtils::Split("a;b", ""), Tokens{});
+  EXPECT_EQ(jltx::TextUtils::Split("a", ";"), Tokens{"a"});
+  EXPECT_EQ(jltx::TextUtils::Split("a;", ";"), (Tokens{"a", ""}));
+  EXPECT_EQ(jltx::TextUtils::Split(";a", ";"), (Tokens{"", "a"}));
+  EXPECT_EQ(jltx::TextUtils::Split(";", ";"), (Tokens{"", ""}));
+  EXPECT_EQ(jltx::TextUtils::Split("a;;b", ";"), (Tokens{"a", "", "b"}));
+  EXPECT_EQ(jltx::TextUtils::Split("a::b::", "::"), (Tokens{"a", "b", ""}));
+}
+
+TEST(TextUtilsTest, SplitVariants) {
+  const std::vector<std::string> inputs = {
+      "", "a", "a;", ";a", ";", "a;;b", "first;second;third", ";;x;y;;"};
+
+  for (const std::string& str : inputs) {
+    const std::vector<std::string> expected = jltx::TextUtils::Split(str, ";");
+
+    const std::vector<std::string_view> views =
+        jltx::TextUtils::SplitView(str, ";");
+    EXPECT_EQ(std::vector<std::string>(views.begin(), views.end()), expected)
+        << str;
+
+    std::vector<std::string> lazy;
+    for (std::string_view token : jltx::TextUtils::SplitRange(str, ";")) {
+      lazy.emplace_back(token);
+    }
+    EXPECT_EQ(lazy, expected) << str;
+
+    std::vector<std::string> visited;
+    jltx::TextUtils::ForEachSplit(str, ";", [&](std::string_view token) {
+      visited.emplace_back(token);
+    });
+    EXPECT_EQ(visited, expected) << str;
+
+    std::vector<std::string_view> written;
+    jltx::TextUtils::SplitTo(str, ";", std::back_inserter(written));
+    EXPECT_EQ(written, views) << str;
+  }
+}
+
+TEST(TextUtilsTest, SplitRangeIsView) {
+  static_assert(std::ranges::view<jltx::TextUtils::SplitRange>);
+  static_assert(std::ranges::forward_range<jltx::TextUtils::SplitRange>);
+
+  const std::string str{"127.0.0.1"};
+  auto range = jltx::TextUtils::SplitRange(str, ".");
+  EXPECT_EQ(std::ranges::distance(range), 4);
+  EXPECT_EQ(range.front(), "127");
+
+  // Views point into the original string
+  EXPECT_EQ((*range.begin()).data(), str.data());
+}
+
 TEST(TextUtilsTest, TrimInPlace) {
   std::string str = "  two spaces left, three spaces right   ";
   jltx::TextUtils::Trim(str);
@@ -59,3 +122,117 @@ TEST(TextUtilsTest, TrimCopy) {
   ASSERT_EQ(str, "  two spaces left, three spaces right   ");
   ASSERT_EQ(trimmed_str, "two spaces left, three spaces right");
 }
+
+TEST(TextUtilsTest, Find) {
+  // Small alphabet so that partial matches are frequent
+  std::mt19937 generator(5);
+  std::uniform_int_distribution<int> letter('a', 'c');
+  auto random_string = [&](std::size_t size) {
+    std::string str(size, ' ');
+    for (char& ch : str) {
+      ch = static_cast<char>(letter(generator));
+    }
+    return str;
+  };
+
+  for (std::size_t size : {0, 1, 15, 16, 17, 31, 33, 100, 1000}) {
+    const std::string str = random_string(size);
+    for (std::size_t k = 1; k <= 20; ++k) {
+      const std::string delimiter = random_string(k);
+      for (std::size_t pos = 0; pos <= size; pos += 7) {
+        EXPECT_EQ(jltx::TextUtils::Find(str, delimiter, pos),
+                  std::string_view(str).find(delimiter, pos))
+            << "size " << size << " delimiter " << delimiter << " pos " << pos;
+      }
+    }
+  }
+}
+
+TEST(TextUtilsTest, TrimView) {
+  EXPECT_EQ(jltx::TextUtils::TrimView(""), "");
+  EXPECT_EQ(jltx::TextUtils::TrimView(" \t\n\v\f\r"), "");
+  EXPECT_EQ(jltx::TextUtils::TrimView("x"), "x");
+  EXPECT_EQ(jltx::TextUtils::TrimView(" \t\n\v\f\rx y\r\f\v\n\t "), "x y");
+
+  // Whitespace runs longer than a SIMD block
+  const std::string padding(40, ' ');
+  const std::string str = padding + "\tword\x01" + padding;
+  // Control characters outside '\t'..'\r' are not whitespace
+  EXPECT_EQ(jltx::TextUtils::TrimView(str), "word\x01");
+  EXPECT_EQ(jltx::TextUtils::TrimCopy(padding + "a" + padding), "a");
+  EXPECT_EQ(jltx::TextUtils::TrimCopy(padding), "");
+}
+
+TEST(TextUtilsTest, ParseNumber) {
+  using jltx::TextUtils::ParseNumber;
+  using jltx::TextUtils::ParseStatus;
+
+  int64_t i64 = 0;
+  EXPECT_EQ(ParseNumber("  -42 ", i64), ParseStatus::OK);
+  EXPECT_EQ(i64, -42);
+  EXPECT_EQ(ParseNumber("+1234567890123456789", i64), ParseStatus::OK);
+  EXPECT_EQ(i64, 1234567890123456789);
+  EXPECT_EQ(ParseNumber("-9223372036854775808", i64), ParseStatus::OK);
+  EXPECT_EQ(i64, INT64_MIN);
+  EXPECT_EQ(ParseNumber("9223372036854775808", i64),
+            ParseStatus::OUT_OF_RANGE);
+  EXPECT_EQ(ParseNumber("123456789012345678901", i64),
+            ParseStatus::OUT_OF_RANGE);
+  EXPECT_EQ(ParseNumber("1234567a", i64), ParseStatus::INVALID);
+  EXPECT_EQ(ParseNumber("12.5", i64), ParseStatus::INVALID);
+  EXPECT_EQ(ParseNumber("-", i64), ParseStatus::INVALID);
+  EXPECT_EQ(ParseNumber(" \t", i64), ParseStatus::EMPTY);
+
+  uint8_t u8 = 0;
+  EXPECT_EQ(ParseNumber("255", u8), ParseStatus::OK);
+  EXPECT_EQ(u8, 255);
+  EXPECT_EQ(ParseNumber("256", u8), ParseStatus::OUT_OF_RANGE);
+  EXPECT_EQ(ParseNumber("-1", u8), ParseStatus::INVALID);
+
+  float f = 0.0f;
+  EXPECT_EQ(ParseNumber("-1.5e3", f), ParseStatus::OK);
+  EXPECT_FLOAT_EQ(f, -1500.0f);
+  EXPECT_EQ(ParseNumber("+.25", f), ParseStatus::OK);
+  EXPECT_FLOAT_EQ(f, 0.25f);
+  EXPECT_EQ(ParseNumber("1e99", f), ParseStatus::OUT_OF_RANGE);
+  EXPECT_EQ(ParseNumber("1.0x", f), ParseStatus::INVALID);
+
+  // Compare the 8-digit fast path with plain decimal conversion
+  std::mt19937_64 generator(3);
+  for (int i = 0; i < 1000; ++i) {
+    const int64_t expected = static_cast<int64_t>(generator() >> 1) *
+                             (i % 2 == 0 ? 1 : -1) >>
+                             (i % 60);
+    ASSERT_EQ(ParseNumber(std::to_string(expected), i64), ParseStatus::OK);
+    ASSERT_EQ(i64, expected);
+  }
+}
+
+TEST(TextUtilsTest, ColumnParser) {
+  using jltx::TextUtils::ParseStatus;
+
+  jltx::TextUtils::ColumnParser<int64_t, float> parser({2, 0});
+  const std::vector<std::vector<std::string_view>> rows = {
+      {"1.5", "x", "10"}, {"oops", "y", "20"}, {"3.25", "z"}};
+  EXPECT_TRUE(parser.Append(rows[0]));
+  EXPECT_FALSE(parser.Append(rows[1]));
+  EXPECT_FALSE(parser.Append(rows[2]));
+
+  EXPECT_EQ(parser.Rows(), 3);
+  EXPECT_EQ(parser.Column<0>(), (std::vector<int64_t>{10, 20, 0}));
+  EXPECT_EQ(parser.Column<1>(), (std::vector<float>{1.5f, 0.0f, 3.25f}));
+
+  ASSERT_EQ(parser.Errors().size(), 2);
+  EXPECT_EQ(parser.Errors()[0].row, 1);
+  EXPECT_EQ(parser.Errors()[0].column, 1);
+  EXPECT_EQ(parser.Errors()[0].status, ParseStatus::INVALID);
+  EXPECT_EQ(parser.Errors()[1].row, 2);
+  EXPECT_EQ(parser.Errors()[1].column, 0);
+  EXPECT_EQ(parser.Errors()[1].status, ParseStatus::MISSING);
+
+  const std::vector<float> values = parser.TakeColumn<1>();
+  EXPECT_EQ(values.size(), 3);
+  parser.Clear();
+  EXPECT_EQ(parser.Rows(), 0);
+  EXPECT_TRUE(parser.Errors().empty());
+}
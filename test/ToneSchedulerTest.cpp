@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "dsp/NCO.hpp"
+#include "dsp/ToneScheduler.hpp"
+
+using jltx::dsp::NCO;
+using jltx::dsp::SineLUT;
+using jltx::dsp::ToneEvent;
+using jltx::dsp::ToneScheduler;
+
+static constexpr float SAMPLE_RATE = 8000.0f;
+
+static const std::vector<ToneEvent> EVENTS = {
+    {10, 697.0f, 0.5f},  {200, 1209.0f, 1.0f}, {201, 770.0f, 0.25f},
+    {333, 0.0f, 0.0f},   {500, 1336.0f, 1.0f}, {500, 852.0f, 0.75f},
+    {1000, 941.0f, 1.0f}};
+
+// The same timeline rendered one sample at a time with a plain NCO
+static std::vector<float> Reference(const SineLUT<10>& table,
+                                    std::size_t samples) {
+  NCO<10> nco(0.0f, SAMPLE_RATE, table);
+  float amplitude = 0.0f;
+  std::size_t next = 0;
+  std::vector<float> out(samples);
+  for (std::size_t n = 0; n < samples; ++n) {
+    while (next < EVENTS.size() && EVENTS[next].sample == n) {
+      nco.SetFrequency(EVENTS[next].frequency);
+      amplitude = EVENTS[next].amplitude;
+      ++next;
+    }
+    out[n] = amplitude * nco();
+  }
+  return out;
+}
+
+TEST(ToneSchedulerTest, SwitchesOnExactSamples) {
+  const SineLUT<10> table;
+  const std::vector<float> expected = Reference(table, 1500);
+  // The block size must not matter
+  for (const std::size_t block : {1, 7, 64, 256, 1500}) {
+    ToneScheduler<10> scheduler(SAMPLE_RATE, table);
+    ASSERT_TRUE(scheduler.Schedule(EVENTS));
+    std::vector<float> out(expected.size());
+    for (std::size_t n = 0; n < out.size(); n += block) {
+      const std::size_t size = std::min(block, out.size() - n);
+      scheduler.Render({out.data() + n, size});
+    }
+    EXPECT_EQ(out, expected) << "block " << block;
+    EXPECT_EQ(scheduler.Position(), 1500u);
+    EXPECT_EQ(scheduler.Pending(), 0u);
+  }
+}
+
+TEST(ToneSchedulerTest, SilentBeforeFirstEvent) {
+  const SineLUT<10> table;
+  ToneScheduler<10> scheduler(SAMPLE_RATE, table);
+  std::vector<float> out(64, 1.0f);
+  scheduler.Render(out);
+  EXPECT_EQ(out, std::vector<float>(64, 0.0f));
+}
+
+TEST(ToneSchedulerTest, PhaseContinuous) {
+  const SineLUT<10> table;
+  ToneScheduler<10> scheduler(SAMPLE_RATE, table);
+  ASSERT_TRUE(scheduler.Schedule({0, 1000.0f, 1.0f}));
+  ASSERT_TRUE(scheduler.Schedule({37, 1100.0f, 1.0f}));
+  std::vector<float> out(100);
+  scheduler.Render(out);
+  // No step bigger than the faster tone can make in one sample
+  const float max_step =
+      2.0f * static_cast<float>(M_PI) * 1100.0f / SAMPLE_RATE + 0.01f;
+  for (std::size_t i = 1; i < out.size(); ++i) {
+    EXPECT_LE(std::fabs(out[i] - out[i - 1]), max_step) << i;
+  }
+}
+
+TEST(ToneSchedulerTest, RejectsEventsInThePast) {
+  const SineLUT<10> table;
+  ToneScheduler<10> scheduler(SAMPLE_RATE, table);
+  EXPECT_TRUE(scheduler.Schedule({100, 1000.0f, 1.0f}));
+  EXPECT_FALSE(scheduler.Schedule({99, 1000.0f, 1.0f}));
+  EXPECT_TRUE(scheduler.Schedule({100, 2000.0f, 1.0f}));
+
+  // Frequencies outside [0, sample rate)
+  EXPECT_FALSE(scheduler.Schedule({120, -1.0f, 1.0f}));
+  EXPECT_FALSE(scheduler.Schedule({120, SAMPLE_RATE, 1.0f}));
+  EXPECT_FALSE(scheduler.Schedule({120, std::nanf(""), 1.0f}));
+  EXPECT_EQ(scheduler.Pending(), 2u);
+
+  std::vector<float> out(150);
+  scheduler.Render(out);
+  EXPECT_FALSE(scheduler.Schedule({149, 1000.0f, 1.0f}));
+  EXPECT_TRUE(scheduler.Schedule({150, 1000.0f, 1.0f}));
+  EXPECT_EQ(scheduler.Pending(), 1u);
+  scheduler.Clear();
+  EXPECT_EQ(scheduler.Pending(), 0u);
+}
+
+// A long timeline scheduled ahead, rendered in blocks
+TEST(ToneSchedulerTest, ManyEvents) {
+  const SineLUT<10> table;
+  ToneScheduler<10> scheduler(SAMPLE_RATE, table);
+  for (uint64_t n = 0; n < 100000; n += 5) {
+    ASSERT_TRUE(scheduler.Schedule(
+        {n, (n % 2 == 0) ? 1200.0f : 2200.0f, 1.0f}));
+  }
+  std::vector<float> out(256);
+  while (scheduler.Pending() > 0) {
+    scheduler.Render(out);
+  }
+  EXPECT_GE(scheduler.Position(), 100000u);
+}
@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define TRACE_ENABLED
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "trace.hpp"
+
+static std::size_t CountOf(const std::string& str, const std::string& part) {
+  std::size_t count = 0;
+  for (std::size_t pos = str.find(part); pos != std::string::npos;
+       pos = str.find(part, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(TraceTest, ChromeJson) {
+  jltx::trace::Tracer& tracer = jltx::trace::Tracer::Instance();
+  tracer.Clear();
+
+  auto work = [] {
+    JLTX_TRACE_FUNCTION();
+    for (int i = 0; i < 3; ++i) {
+      JLTX_TRACE_ZONE("inner \"zone\"");
+    }
+  };
+  work();
+  std::thread thread([&] {
+    jltx::trace::Tracer::Instance().SetThreadName("worker");
+    work();
+  });
+  thread.join();
+
+  char* text = nullptr;
+  std::size_t size = 0;
+  FILE* out = open_memstream(&text, &size);
+  EXPECT_TRUE(tracer.WriteChromeJson(out));
+  fclose(out);
+  const std::string json(text, size);
+  free(text);
+
+  EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+  EXPECT_EQ(CountOf(json, "\"ph\":\"X\""), 8);
+  EXPECT_EQ(CountOf(json, "\"name\":\"inner \\\"zone\\\"\""), 6);
+  EXPECT_EQ(CountOf(json, "\"name\":\"operator()\""), 2);
+  EXPECT_EQ(CountOf(json, "\"args\":{\"name\":\"worker\"}"), 1);
+  EXPECT_EQ(CountOf(json, "\"dur\":-"), 0);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+  EXPECT_EQ(tracer.Dropped(), 0);
+
+  tracer.Clear();
+  out = open_memstream(&text, &size);
+  tracer.WriteChromeJson(out);
+  fclose(out);
+  EXPECT_EQ(CountOf(text, "\"ph\":\"X\""), 0);
+  free(text);
+}
+
+TEST(TraceTest, ExitedThreads) {
+  jltx::trace::Tracer& tracer = jltx::trace::Tracer::Instance();
+  tracer.Clear();
+
+  // Every thread gets the buffer of the previous one, zones are kept
+  constexpr int THREADS = 16;
+  for (int t = 0; t < THREADS; ++t) {
+    std::thread([t] {
+      if (t == 0) {
+        jltx::trace::Tracer::Instance().SetThreadName("tab\tnew\nline\x01");
+      }
+      JLTX_TRACE_ZONE("first");
+      JLTX_TRACE_ZONE("second");
+    }).join();
+  }
+
+  char* text = nullptr;
+  std::size_t size = 0;
+  FILE* out = open_memstream(&text, &size);
+  EXPECT_TRUE(tracer.WriteChromeJson(out));
+  fclose(out);
+  const std::string json(text, size);
+  free(text);
+
+  EXPECT_EQ(CountOf(json, "\"name\":\"first\""), THREADS);
+  EXPECT_EQ(CountOf(json, "\"name\":\"second\""), THREADS);
+  EXPECT_EQ(CountOf(json, "\"name\":\"tab\\u0009new\\u000aline\\u0001\""), 1);
+  EXPECT_EQ(tracer.Dropped(), 0);
+  tracer.Clear();
+}
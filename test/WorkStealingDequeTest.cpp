@@ -0,0 +1,107 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2022 Javier Lancha Vázquez
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "containers/WorkStealingDeque.hpp"
+
+TEST(WorkStealingDequeTest, OwnerAndThief) {
+  jltx::WorkStealingDeque<int> deque(3);
+  ASSERT_EQ(deque.Capacity(), 4);
+
+  int item = 0;
+  EXPECT_FALSE(deque.Pop(item));
+  EXPECT_FALSE(deque.Steal(item));
+
+  deque.Push(1);
+  deque.Push(2);
+  deque.Push(3);
+  EXPECT_EQ(deque.Size(), 3);
+
+  // The owner takes the newest, thieves the oldest
+  ASSERT_TRUE(deque.Pop(item));
+  EXPECT_EQ(item, 3);
+  ASSERT_TRUE(deque.Steal(item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(deque.Pop(item));
+  EXPECT_EQ(item, 2);
+  EXPECT_FALSE(deque.Pop(item));
+  EXPECT_EQ(deque.Size(), 0);
+
+  // Positions keep growing past the capacity
+  for (int i = 0; i < 10; ++i) {
+    deque.Push(i);
+    deque.Push(i + 100);
+    ASSERT_TRUE(deque.Steal(item));
+    EXPECT_EQ(item, i);
+    ASSERT_TRUE(deque.Pop(item));
+    EXPECT_EQ(item, i + 100);
+  }
+}
+
+TEST(WorkStealingDequeTest, EveryItemTakenOnce) {
+  constexpr int COUNT = 1 << 18;
+  constexpr int THIEVES = 3;
+  jltx::WorkStealingDeque<int> deque(1024);
+  std::vector<std::atomic<int>> taken(COUNT);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < THIEVES; ++t) {
+    thieves.emplace_back([&] {
+      int item;
+      while (!done.load(std::memory_order_acquire)) {
+        if (deque.Steal(item)) {
+          taken[item].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  // Keep the deque short, so that pops and steals race for the last items
+  int item;
+  for (int i = 0; i < COUNT; ++i) {
+    deque.Push(i);
+    if (i % 4 == 3) {
+      while (deque.Pop(item)) {
+        taken[item].fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  while (deque.Pop(item)) {
+    taken[item].fetch_add(1, std::memory_order_relaxed);
+  }
+  done.store(true, std::memory_order_release);
+  for (std::thread& thief : thieves) {
+    thief.join();
+  }
+
+  for (int i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(taken[i].load(), 1) << "item " << i;
+  }
+}